@@ -58,7 +58,10 @@ vector<BuiltInType> getFormals(shared_ptr<ast::Formals> node)
 
 // Implementing Analyzer class methods
 
-Analyzer::Analyzer() : symbolTable(), printer(), inFirstFunction(false), currentReturnType(ast::BuiltInType::VOID) {}
+Analyzer::Analyzer(bool packFrames) : symbolTable(), printer(), inFirstFunction(false), currentReturnType(ast::BuiltInType::VOID)
+{
+    symbolTable.setPackedFrames(packFrames);
+}
 
 void Analyzer::printOutput()
 {
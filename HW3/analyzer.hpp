@@ -15,7 +15,8 @@ private:
     BuiltInType currentReturnType;
 
 public:
-    Analyzer();
+    // With packFrames, local offsets are byte offsets from SymbolTable's frame layout
+    explicit Analyzer(bool packFrames = false);
     void printOutput();
     void setInFirstFunction(bool val);
     bool getInFirstFunction() const;
@@ -0,0 +1,49 @@
+#include "frameLayout.hpp"
+
+// Implementing the FrameLayout class methods
+
+FrameLayout::FrameLayout() : live(), marks(), freeSlots(), highWater(0) {}
+
+void FrameLayout::beginScope()
+{
+    marks.push_back(live.size());
+}
+
+void FrameLayout::endScope()
+{
+    for (size_t i = marks.back(); i < live.size(); ++i)
+    {
+        freeSlots[{live[i].size, live[i].align}].push_back(live[i].offset);
+    }
+    live.resize(marks.back());
+    marks.pop_back();
+}
+
+int FrameLayout::place(int size, int align)
+{
+    int offset;
+    std::vector<int> &slots = freeSlots[{size, align}];
+    if (!slots.empty())
+    {
+        offset = slots.back();
+        slots.pop_back();
+    }
+    else
+    {
+        // Grow the frame; the bytes skipped to align the slot become free bytes
+        offset = (highWater + align - 1) / align * align;
+        for (int hole = offset - 1; hole >= highWater; --hole)
+        {
+            freeSlots[{1, 1}].push_back(hole);
+        }
+        highWater = offset + size;
+    }
+
+    live.push_back(Slot{offset, size, align});
+    return offset;
+}
+
+int FrameLayout::frameSize() const
+{
+    return highWater;
+}
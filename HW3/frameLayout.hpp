@@ -0,0 +1,48 @@
+#ifndef FRAME_LAYOUT_HPP
+#define FRAME_LAYOUT_HPP
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+/* FrameLayout class
+ * Byte offsets of the locals of a function. The slots of a scope are freed
+ * when it ends and go to a free list per size and alignment, which the next
+ * slot of the same shape takes before the frame grows, so disjoint scopes
+ * share space. The padding that aligning a new slot leaves is freed as
+ * one-byte slots, which byte and bool locals fill.
+ */
+class FrameLayout
+{
+private:
+    struct Slot
+    {
+        int offset;
+        int size;
+        int align;
+    };
+
+    // Live slots in placement order, the innermost scope's at the back
+    std::vector<Slot> live;
+    // Number of live slots when each open scope began
+    std::vector<std::size_t> marks;
+    // Offsets of the free slots of each size and alignment
+    std::map<std::pair<int, int>, std::vector<int>> freeSlots;
+    // End offset of the frame so far
+    int highWater;
+
+public:
+    FrameLayout();
+
+    void beginScope();
+    void endScope();
+
+    // Places a slot of size bytes and returns its offset
+    int place(int size, int align);
+
+    // Bytes the frame needs for every slot placed so far
+    int frameSize() const;
+};
+
+#endif // FRAME_LAYOUT_HPP
@@ -1,19 +1,30 @@
 #include "output.hpp"
 #include "nodes.hpp"
 #include "analyzer.hpp"
+#include <cstring>
 
 // Extern from the bison-generated parser
 extern int yyparse();
 
 extern std::shared_ptr<ast::Node> program;
 
-int main()
+int main(int argc, char *argv[])
 {
+    // --pack-frame prints byte offsets of a packed frame instead of slot numbers
+    bool packFrames = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--pack-frame") == 0)
+        {
+            packFrames = true;
+        }
+    }
+
     // Parse the input. The result is stored in the global variable `program`
     yyparse();
 
     // Print the AST using the PrintVisitor
-    Analyzer analyzer;
+    Analyzer analyzer(packFrames);
     program->accept(analyzer);
     analyzer.printOutput();
     // std::cout << analyzer.getPrinter();
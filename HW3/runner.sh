@@ -104,6 +104,7 @@ if [ $FAIL -eq 0 ]; then
         output.cpp output.hpp \
         parser.y scanner.lex \
         symbolTable.cpp symbolTable.hpp \
+        frameLayout.cpp frameLayout.hpp \
         visitor.hpp > /dev/null
     echo "submission file created"
 fi
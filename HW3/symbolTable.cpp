@@ -112,34 +112,23 @@ Scope::Scope(bool is_loop_scope) : is_loop_scope(is_loop_scope)
 
 void Scope::addSymbol(shared_ptr<SymbolEntry> entry)
 {
+    // Only the first declaration of a name is visible through the scope
+    scope_index.emplace(entry->getName(), entry);
     scope_entries.push_back(move(entry));
 }
 
 shared_ptr<SymbolEntry> Scope::findEntry(const string &name) const
 {
-    for (const auto &entry : scope_entries)
-    {
-        if (entry->getName() == name)
-        {
-            return entry;
-        }
-    }
-    return nullptr;
+    auto it = scope_index.find(name);
+    return it != scope_index.end() ? it->second : nullptr;
 }
 
 bool Scope::contains(const string &name) const
 {
-    for (const auto &entry : scope_entries)
-    {
-        if (entry->getName() == name)
-        {
-            return true;
-        }
-    }
-    return false;
+    return scope_index.count(name) != 0;
 }
 
-vector<shared_ptr<SymbolEntry>> Scope::getEntries() const
+const vector<shared_ptr<SymbolEntry>> &Scope::getEntries() const
 {
     return scope_entries;
 }
@@ -166,7 +155,7 @@ void Scope::setLoopScope(bool is_loopScope)
 
 // Impleminting the SymbolTable class methods
 
-SymbolTable::SymbolTable() : scopes(), symbolTable_offsets(0)
+SymbolTable::SymbolTable() : scopes(), symbolTable_offsets(0), packed_frames(false), frame_layout()
 {
     scopes.push_back(make_shared<Scope>()); // Initialize with a global scope
 }
@@ -175,61 +164,103 @@ void SymbolTable::beginScope()
 {
     scopes.push_back(make_shared<Scope>());
     symbolTable_offsets.push_back(this->symbolTable_offsets.empty() ? 0 : this->symbolTable_offsets.back());
+    frame_layout.beginScope();
 }
 
 void SymbolTable::endScope()
 {
     if (!scopes.empty())
     {
+        // Every binding of the innermost scope sits on top of its name's
+        // stack, so unwinding the scope's entries pops exactly those
+        for (const auto &entry : scopes.back()->getEntries())
+        {
+            auto it = bindings.find(entry->getName());
+            it->second.pop_back();
+            if (it->second.empty())
+            {
+                bindings.erase(it);
+            }
+        }
         scopes.pop_back();
         symbolTable_offsets.pop_back();
+        frame_layout.endScope();
     }
 }
 
+void SymbolTable::bind(const shared_ptr<SymbolEntry> &entry, int depth)
+{
+    vector<Binding> &stack = bindings[entry->getName()];
+
+    // Keep the stack ordered by depth, and within one scope keep the first
+    // declaration on top so it wins lookups like the linear scan used to
+    auto pos = stack.end();
+    while (pos != stack.begin() && (pos - 1)->depth >= depth)
+    {
+        --pos;
+    }
+    stack.insert(pos, Binding{entry, depth});
+}
+
 void SymbolTable::addEntry(shared_ptr<SymbolEntry> entry)
 {
     if (entry->isFunction())
     {
         scopes.front()->addSymbol(entry);
+        bind(entry, 0);
+        return;
     }
     else if (entry->isFormalParameter())
     {
-        entry->setOffset(symbolTable_offsets.back()--);
-        scopes.back()->addSymbol(entry);
+        // Every argument takes a 4 byte word of the caller's frame
+        int offset = symbolTable_offsets.back()--;
+        entry->setOffset(packed_frames ? offset * 4 : offset);
+    }
+    else if (packed_frames)
+    {
+        int elementSize = entry->getType().front() == BuiltInType::INT ? 4 : 1;
+        int length = entry->isArray() ? entry->getArraySize() : 1;
+        entry->setOffset(frame_layout.place(elementSize * length, elementSize));
     }
     else
     {
         int size = entry->isArray() ? entry->getArraySize() : 1;
         entry->setOffset(symbolTable_offsets.back());
         symbolTable_offsets.back() += size;
-        scopes.back()->addSymbol(entry);
     }
+    scopes.back()->addSymbol(entry);
+    bind(entry, static_cast<int>(scopes.size()) - 1);
 }
 
 shared_ptr<SymbolEntry> SymbolTable::findEntry(const string &name, bool is_function) const
 {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    auto it = bindings.find(name);
+    if (it == bindings.end())
+    {
+        return nullptr;
+    }
+
+    // A scope whose visible declaration has the wrong kind hides the rest
+    // of its own declarations, but not those of enclosing scopes
+    int skipDepth = -1;
+    for (auto b = it->second.rbegin(); b != it->second.rend(); ++b)
     {
-        shared_ptr<SymbolEntry> entry = (*it)->findEntry(name);
-        if (entry && entry->isFunction() == is_function)
+        if (b->depth == skipDepth)
+        {
+            continue;
+        }
+        if (b->entry->isFunction() == is_function)
         {
-            return entry;
+            return b->entry;
         }
+        skipDepth = b->depth;
     }
     return nullptr;
 }
 
 bool SymbolTable::contains(const string &name, bool is_function) const
 {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
-    {
-        shared_ptr<SymbolEntry> entry = (*it)->findEntry(name);
-        if (entry && entry->isFunction() == is_function)
-        {
-            return true;
-        }
-    }
-    return false;
+    return findEntry(name, is_function) != nullptr;
 }
 
 vector<shared_ptr<SymbolEntry>> SymbolTable::getCurrentScopeEntries() const
@@ -273,7 +304,7 @@ vector<BuiltInType> SymbolTable::getFunctionArgTypes(const string &name)
     return vector<BuiltInType>();
 }
 
-vector<shared_ptr<Scope>> SymbolTable::getScopes()
+const vector<shared_ptr<Scope>> &SymbolTable::getScopes() const
 {
     return scopes;
 }
@@ -283,6 +314,11 @@ void SymbolTable::setOffset(int offset)
     symbolTable_offsets.back() = offset;
 }
 
+void SymbolTable::setPackedFrames(bool packed)
+{
+    packed_frames = packed;
+}
+
 SymbolEntry::~SymbolEntry() {}
 Scope::~Scope() {}
 SymbolTable::~SymbolTable() {}
@@ -4,7 +4,9 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include "nodes.hpp"
+#include "frameLayout.hpp"
 using namespace std;
 using namespace ast;
 
@@ -56,7 +58,11 @@ public:
 class Scope
 {
 private:
+    // Entries in declaration order; also serves as the undo list that
+    // SymbolTable::endScope uses to unwind the name bindings
     vector<shared_ptr<SymbolEntry>> scope_entries;
+    // Index of the first entry declared under each name in this scope
+    unordered_map<string, shared_ptr<SymbolEntry>> scope_index;
     bool is_loop_scope;
 
 public:
@@ -72,7 +78,7 @@ public:
     bool contains(const string &name) const;
 
     // Get all entries in the scope
-    vector<shared_ptr<SymbolEntry>> getEntries() const;
+    const vector<shared_ptr<SymbolEntry>> &getEntries() const;
 
     // Get the argument types of a function by its name
     vector<BuiltInType> getFunctionArgumentTypes(const string &name) const;
@@ -89,8 +95,23 @@ public:
 class SymbolTable
 {
 private:
+    // A visible declaration of a name, tagged with the depth of its scope
+    struct Binding
+    {
+        shared_ptr<SymbolEntry> entry;
+        int depth;
+    };
+
     vector<shared_ptr<Scope>> scopes;
     vector<int> symbolTable_offsets;
+    // With packed frames, offsets are bytes assigned by the frame layout
+    bool packed_frames;
+    FrameLayout frame_layout;
+    // Shadow stack per name: the innermost declaration is at the back
+    unordered_map<string, vector<Binding>> bindings;
+
+    // Bind an entry that was just added to the scope at the given depth
+    void bind(const shared_ptr<SymbolEntry> &entry, int depth);
 
 public:
     // Constructor for SymbolTable, initializes with a global scope
@@ -125,11 +146,15 @@ public:
     vector<BuiltInType> getFunctionArgTypes(const string &name);
 
     // Get all scopes in the symbol table
-    vector<shared_ptr<Scope>> getScopes();
+    const vector<shared_ptr<Scope>> &getScopes() const;
 
     // Set the offset for the current scope
     void setOffset(int offset);
 
+    // Lay locals out in bytes: int slots are 4 bytes, byte and bool slots 1,
+    // and slots of scopes that are never open together overlap
+    void setPackedFrames(bool packed);
+
     // Destructor for SymbolTable
     ~SymbolTable();
 };
@@ -1,4 +1,11 @@
 #include "analyzer.hpp"
+#include "inliner.hpp"
+#include "irPrinter.hpp"
+#include "threadPool.hpp"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 using namespace std;
@@ -29,21 +36,42 @@ std::vector<std::string> builtInTypeToString(vector<ast::BuiltInType> types) {
     return result;
 }
 
-int getArraySize(std::shared_ptr<ast::ArrayType> arrType) {
-    if (auto num = std::dynamic_pointer_cast<ast::Num>(arrType->length)) {
+// LLVM type of a value of the given FanC type; anything else is a pointer
+ir::Type irType(ast::BuiltInType type) {
+    return (type == ast::BuiltInType::INT)    ? ir::Type::I32
+           : (type == ast::BuiltInType::BYTE) ? ir::Type::I8
+           : (type == ast::BuiltInType::BOOL) ? ir::Type::I1
+                                              : ir::Type::I8_PTR;
+}
+
+int getArraySize(ast::ArrayType *arrType) {
+    if (auto num = dynamic_cast<ast::Num *>(arrType->length)) {
         return num->value;
     } else if (auto numB =
-                   std::dynamic_pointer_cast<ast::NumB>(arrType->length)) {
+                   dynamic_cast<ast::NumB *>(arrType->length)) {
         return numB->value;
     }
     return -1;  // unreachable if semantic checks pass
 }
 
-vector<BuiltInType> getFormals(shared_ptr<ast::Formals> node) {
+// Whether exp is a number literal other than zero, a divisor that needs no check
+bool isNonzeroLiteral(ast::Exp *exp) {
+    if (auto num = dynamic_cast<ast::Num *>(exp)) {
+        return num->value != 0;
+    } else if (auto numB = dynamic_cast<ast::NumB *>(exp)) {
+        return numB->value != 0;
+    }
+    return false;
+}
+
+// Arrays up to this length are zeroed by straight-line stores, longer ones by memset
+const int smallArrayLength = 8;
+
+vector<BuiltInType> getFormals(ast::Formals *node) {
     vector<BuiltInType> result;
     for (auto formal : node->formals) {
         auto ptype =
-            std::dynamic_pointer_cast<ast::PrimitiveType>(formal->type);
+            dynamic_cast<ast::PrimitiveType *>(formal->type);
         result.push_back(ptype->type);
     }
     return result;
@@ -51,15 +79,33 @@ vector<BuiltInType> getFormals(shared_ptr<ast::Formals> node) {
 
 // Implementing Analyzer class methods
 
-Analyzer::Analyzer()
+Analyzer::Analyzer(std::size_t jobs, const ir::PassOptions &passes)
     : symbolTable(),
-      codeBuffer(),
+      module(),
+      builder(),
       inFirstFunction(false),
-      currentReturnType(ast::BuiltInType::VOID) {}
+      currentReturnType(ast::BuiltInType::VOID),
+      jobs(jobs),
+      passes(passes),
+      frame(),
+      frameBytes(0),
+      unsharedFrameBytes(0),
+      passStats(),
+      inlineReport(),
+      traps(),
+      loops() {}
+
+void Analyzer::printOutput(std::ostream &os)
+{
+    output::ChunkBuffer code;
+    ir::print(module, code);
+    os << code << endl;
+}
 
-void Analyzer::printOutput()
+void Analyzer::printOutput(output::ChunkBuffer &out)
 {
-    cout << codeBuffer << endl;
+    ir::print(module, out);
+    out.append('\n');
 }
 
 void Analyzer::setInFirstFunction(bool val) { inFirstFunction = val; }
@@ -78,7 +124,7 @@ void Analyzer::setCurrentReturnType(ast::BuiltInType type) {
 
 void Analyzer::visit(ast::Num &node) {
     node.type = ast::BuiltInType::INT;
-    node.reg = to_string(node.value);
+    node.reg = ir::Value::constant(node.value);
 }
 
 void Analyzer::visit(ast::NumB &node) {
@@ -87,17 +133,17 @@ void Analyzer::visit(ast::NumB &node) {
     }
 
     node.type = ast::BuiltInType::BYTE;
-    node.reg = to_string(node.value);
+    node.reg = ir::Value::constant(node.value);
 }
 
 void Analyzer::visit(ast::String &node) {
     node.type = ast::BuiltInType::STRING;
-    node.reg = codeBuffer.emitString(node.value);
+    node.reg = builder.string(node.value);
 }
 
 void Analyzer::visit(ast::Bool &node) {
     node.type = ast::BuiltInType::BOOL;
-    node.reg = node.value ? "1" : "0";
+    node.reg = ir::Value::constant(node.value ? 1 : 0);
 }
 
 void Analyzer::visit(ast::ID &node) {
@@ -116,14 +162,8 @@ void Analyzer::visit(ast::ID &node) {
 
     // Generate LLVM code to load the variable
     if (!symbolEntry->isArray()) {
-        string tempReg = codeBuffer.freshVar();
-        string llvmType = (node.type == ast::BuiltInType::INT)    ? "i32"
-                          : (node.type == ast::BuiltInType::BYTE) ? "i8"
-                          : (node.type == ast::BuiltInType::BOOL) ? "i1"
-                                                                  : "i8*";
-
-        codeBuffer << tempReg << " = load " << llvmType << ", " << llvmType
-                   << "* " << symbolEntry->getLlvmRig() << endl;
+        ir::Value tempReg = builder.temp();
+        builder.load(tempReg, irType(node.type), symbolEntry->getLlvmRig());
         node.reg = tempReg;
     } else {
         // For arrays, we just store the pointer
@@ -137,8 +177,8 @@ void Analyzer::visit(ast::BinOp &node) {
 
     auto leftType = node.left->type;
     auto rightType = node.right->type;
-    auto leftId = dynamic_pointer_cast<ast::ID>(node.left);
-    auto rightId = dynamic_pointer_cast<ast::ID>(node.right);
+    auto leftId = dynamic_cast<ast::ID *>(node.left);
+    auto rightId = dynamic_cast<ast::ID *>(node.right);
 
     if (leftId) {
         auto leftSymbolEntry = symbolTable.findEntry(leftId->value, false);
@@ -175,75 +215,58 @@ void Analyzer::visit(ast::BinOp &node) {
     }
 
     // Generate LLVM code for binary operation
-    string leftReg = node.left->reg;
-    string rightReg = node.right->reg;
-    string resultReg = codeBuffer.freshVar();
+    ir::Value leftReg = node.left->reg;
+    ir::Value rightReg = node.right->reg;
+    ir::Value resultReg = builder.temp();
 
     // Handle type promotions
     if (leftType == ast::BuiltInType::BYTE &&
         (rightType == ast::BuiltInType::INT ||
          node.type == ast::BuiltInType::INT)) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << leftReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, leftReg,
+                     ir::Type::I32);
         leftReg = extendedReg;
     }
     if (rightType == ast::BuiltInType::BYTE &&
         (leftType == ast::BuiltInType::INT ||
          node.type == ast::BuiltInType::INT)) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << rightReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, rightReg,
+                     ir::Type::I32);
         rightReg = extendedReg;
     }
 
-    string llvmType = (node.type == ast::BuiltInType::INT) ? "i32" : "i8";
-    string opCode;
+    ir::Type llvmType = (node.type == ast::BuiltInType::INT) ? ir::Type::I32 : ir::Type::I8;
+    ir::Opcode opCode = ir::Opcode::ADD;
 
     switch (node.op) {
         case ast::BinOpType::ADD:
-            opCode = "add";
+            opCode = ir::Opcode::ADD;
             break;
         case ast::BinOpType::SUB:
-            opCode = "sub";
+            opCode = ir::Opcode::SUB;
             break;
         case ast::BinOpType::MUL:
-            opCode = "mul";
+            opCode = ir::Opcode::MUL;
             break;
         case ast::BinOpType::DIV:
-            // Add division by zero check
-            if (node.op == ast::BinOpType::DIV) {
-                string isZeroReg = codeBuffer.freshVar();
-                string errorLabel = codeBuffer.freshLabel();
-                string continueLabel = codeBuffer.freshLabel();
+            // Add division by zero check, unless the divisor is a nonzero literal
+            if (!isNonzeroLiteral(node.right)) {
+                ir::Value isZeroReg = builder.temp();
 
                 // Check if divisor is zero
-                codeBuffer << isZeroReg << " = icmp eq " << llvmType << " "
-                           << rightReg << ", 0" << endl;
-                codeBuffer << "br i1 " << isZeroReg << ", label " << errorLabel
-                           << ", label " << continueLabel << endl;
-
-                // Handle division by zero error
-                codeBuffer.emitLabel(errorLabel);
-                string errorMsg = "Error division by zero";
-                string strVar = codeBuffer.emitString(errorMsg);
-                // Don't hardcode the string length, use the actual length
-                codeBuffer << "call void @print(i8* getelementptr (["
-                           << errorMsg.length() + 1 << " x i8], ["
-                           << errorMsg.length() + 1 << " x i8]* " << strVar
-                           << ", i32 0, i32 0))" << endl;
-                codeBuffer << "call void @exit(i32 0)" << endl;
-                codeBuffer << "br label " << continueLabel << endl;
-
-                // Continue with division
-                codeBuffer.emitLabel(continueLabel);
+                builder.icmp(isZeroReg, ir::Predicate::EQ, llvmType, rightReg,
+                             ir::Value::constant(0));
+
+                // Handle division by zero error, then continue with division
+                failIf(isZeroReg, "Error division by zero");
             }
-            opCode = "sdiv";
+            opCode = ir::Opcode::SDIV;
             break;
     }
 
-    codeBuffer << resultReg << " = " << opCode << " " << llvmType << " "
-               << leftReg << ", " << rightReg << endl;
+    builder.binary(opCode, resultReg, llvmType, leftReg, rightReg);
     node.reg = resultReg;
 }
 
@@ -254,7 +277,7 @@ void Analyzer::visit(ast::RelOp &node) {
     auto leftType = node.left->type;
     auto rightType = node.right->type;
 
-    auto leftID = std::dynamic_pointer_cast<ast::ID>(node.left);
+    auto leftID = dynamic_cast<ast::ID *>(node.left);
     if (leftID) {
         auto entry = symbolTable.findEntry(leftID->value, false);
         if (!entry)
@@ -263,7 +286,7 @@ void Analyzer::visit(ast::RelOp &node) {
             output::errorMismatch(node.line);
     }
 
-    auto rightID = std::dynamic_pointer_cast<ast::ID>(node.right);
+    auto rightID = dynamic_cast<ast::ID *>(node.right);
     if (rightID) {
         auto entry = symbolTable.findEntry(rightID->value, false);
         if (!entry)
@@ -283,110 +306,80 @@ void Analyzer::visit(ast::RelOp &node) {
     node.type = ast::BuiltInType::BOOL;
 
     // Generate LLVM code for relational operation
-    string leftReg = node.left->reg;
-    string rightReg = node.right->reg;
-    string resultReg = codeBuffer.freshVar();
+    ir::Value leftReg = node.left->reg;
+    ir::Value rightReg = node.right->reg;
+    ir::Value resultReg = builder.temp();
 
     // Handle type promotions
     if (leftType == ast::BuiltInType::BYTE &&
         rightType == ast::BuiltInType::INT) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << leftReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, leftReg,
+                     ir::Type::I32);
         leftReg = extendedReg;
         leftType = ast::BuiltInType::INT;
     }
     if (rightType == ast::BuiltInType::BYTE &&
         leftType == ast::BuiltInType::INT) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << rightReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, rightReg,
+                     ir::Type::I32);
         rightReg = extendedReg;
         rightType = ast::BuiltInType::INT;
     }
 
-    string llvmType = (leftType == ast::BuiltInType::INT ||
-                       rightType == ast::BuiltInType::INT)
-                          ? "i32"
-                          : "i8";
-    string opCode;
+    ir::Type llvmType = (leftType == ast::BuiltInType::INT ||
+                         rightType == ast::BuiltInType::INT)
+                            ? ir::Type::I32
+                            : ir::Type::I8;
+    ir::Predicate predicate = ir::Predicate::EQ;
 
     switch (node.op) {
         case ast::RelOpType::EQ:
-            opCode = "icmp eq";
+            predicate = ir::Predicate::EQ;
             break;
         case ast::RelOpType::NE:
-            opCode = "icmp ne";
+            predicate = ir::Predicate::NE;
             break;
         case ast::RelOpType::LT:
-            opCode = "icmp slt";
+            predicate = ir::Predicate::SLT;
             break;
         case ast::RelOpType::GT:
-            opCode = "icmp sgt";
+            predicate = ir::Predicate::SGT;
             break;
         case ast::RelOpType::LE:
-            opCode = "icmp sle";
+            predicate = ir::Predicate::SLE;
             break;
         case ast::RelOpType::GE:
-            opCode = "icmp sge";
+            predicate = ir::Predicate::SGE;
             break;
     }
 
-    codeBuffer << resultReg << " = " << opCode << " " << llvmType << " "
-               << leftReg << ", " << rightReg << endl;
+    builder.icmp(resultReg, predicate, llvmType, leftReg, rightReg);
     node.reg = resultReg;
 }
 
 void Analyzer::visit(ast::Not &node) {
-    node.exp->accept(*this);
-    if (node.exp->type != ast::BuiltInType::BOOL) {
-        output::errorMismatch(node.line);
-    }
-    node.type = ast::BuiltInType::BOOL;
-
-    // Generate LLVM code for NOT operation
-    string resultReg = codeBuffer.freshVar();
-    codeBuffer << resultReg << " = xor i1 " << node.exp->reg << ", 1" << endl;
-    node.reg = resultReg;
+    ir::BranchList trueList, falseList;
+    condition(node, trueList, falseList);
+    node.reg = materialize(trueList, falseList);
 }
 
 void Analyzer::visit(ast::And &node) {
-    node.left->accept(*this);
-    node.right->accept(*this);
-
-    if (node.left->type != ast::BuiltInType::BOOL ||
-        node.right->type != ast::BuiltInType::BOOL) {
-        output::errorMismatch(node.line);
-    }
-    node.type = ast::BuiltInType::BOOL;
-
-    // Generate LLVM code for AND operation
-    string resultReg = codeBuffer.freshVar();
-    codeBuffer << resultReg << " = and i1 " << node.left->reg << ", "
-               << node.right->reg << endl;
-    node.reg = resultReg;
+    ir::BranchList trueList, falseList;
+    condition(node, trueList, falseList);
+    node.reg = materialize(trueList, falseList);
 }
 
 void Analyzer::visit(ast::Or &node) {
-    node.left->accept(*this);
-    node.right->accept(*this);
-
-    if (node.left->type != ast::BuiltInType::BOOL ||
-        node.right->type != ast::BuiltInType::BOOL) {
-        output::errorMismatch(node.line);
-    }
-    node.type = ast::BuiltInType::BOOL;
-
-    // Generate LLVM code for OR operation
-    string resultReg = codeBuffer.freshVar();
-    codeBuffer << resultReg << " = or i1 " << node.left->reg << ", "
-               << node.right->reg << endl;
-    node.reg = resultReg;
+    ir::BranchList trueList, falseList;
+    condition(node, trueList, falseList);
+    node.reg = materialize(trueList, falseList);
 }
 
-void Analyzer::visit(ast::PrimitiveType &node) {
-    // Primitive types are already defined, no need to check anything
-    node.type = node.type;
+void Analyzer::visit(ast::PrimitiveType &) {
+    // Primitive types are already defined, no need to check anything.
+    // Nothing is written either: other functions' workers read signatures concurrently
 }
 
 void Analyzer::visit(ast::ArrayType &node) {
@@ -396,8 +389,8 @@ void Analyzer::visit(ast::ArrayType &node) {
         output::errorMismatch(node.line);
     }
 
-    if (!std::dynamic_pointer_cast<ast::Num>(node.length) &&
-        !std::dynamic_pointer_cast<ast::NumB>(node.length)) {
+    if (!dynamic_cast<ast::Num *>(node.length) &&
+        !dynamic_cast<ast::NumB *>(node.length)) {
         output::errorMismatch(node.line);
     }
 }
@@ -419,62 +412,26 @@ void Analyzer::visit(ast::ArrayDereference &node) {
     node.type = entry->getType()[0];
 
     // Generate LLVM code for array dereference
-    string indexReg = node.index->reg;
+    ir::Value indexReg = node.index->reg;
 
     // Convert byte index to int if needed
     if (node.index->type == ast::BuiltInType::BYTE) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << indexReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, indexReg,
+                     ir::Type::I32);
         indexReg = extendedReg;
     }
 
     // Add bounds checking
-    string isNegativeReg = codeBuffer.freshVar();
-    string isOutOfBoundsReg = codeBuffer.freshVar();
-    string combinedCheckReg = codeBuffer.freshVar();
-    string errorLabel = codeBuffer.freshLabel();
-    string continueLabel = codeBuffer.freshLabel();
-
-    // Check if index is negative
-    codeBuffer << isNegativeReg << " = icmp slt i32 " << indexReg << ", 0"
-               << endl;
-
-    // Check if index >= array size
-    codeBuffer << isOutOfBoundsReg << " = icmp sge i32 " << indexReg << ", "
-               << entry->getArraySize() << endl;
-
-    // Combine the checks (true if out of bounds)
-    codeBuffer << combinedCheckReg << " = or i1 " << isNegativeReg << ", "
-               << isOutOfBoundsReg << endl;
-    codeBuffer << "br i1 " << combinedCheckReg << ", label " << errorLabel
-               << ", label " << continueLabel << endl;
-
-    // Handle out of bounds error
-    codeBuffer.emitLabel(errorLabel);
-    string errorMsg = "Error out of bounds";
-    string strVar = codeBuffer.emitString(errorMsg);
-    // Don't hardcode the string length, use the actual length
-    codeBuffer << "call void @print(i8* getelementptr (["
-               << errorMsg.length() + 1 << " x i8], [" << errorMsg.length() + 1
-               << " x i8]* " << strVar << ", i32 0, i32 0))" << endl;
-    codeBuffer << "call void @exit(i32 0)" << endl;
-    codeBuffer << "br label " << continueLabel << endl;
+    checkBounds(indexReg, entry->getArraySize());
 
     // Continue with array access
-    codeBuffer.emitLabel(continueLabel);
-
-    string ptrReg = codeBuffer.freshVar();
-    string resultReg = codeBuffer.freshVar();
-    string llvmType = (node.type == BuiltInType::INT)    ? "i32"
-                      : (node.type == BuiltInType::BYTE) ? "i8"
-                      : (node.type == BuiltInType::BOOL) ? "i1"
-                                                         : "i8*";
+    ir::Value ptrReg = builder.temp();
+    ir::Value resultReg = builder.temp();
+    ir::Type llvmType = irType(node.type);
 
-    codeBuffer << ptrReg << " = getelementptr " << llvmType << ", " << llvmType
-               << "* " << entry->getLlvmRig() << ", i32 " << indexReg << endl;
-    codeBuffer << resultReg << " = load " << llvmType << ", " << llvmType
-               << "* " << ptrReg << endl;
+    builder.gep(ptrReg, llvmType, entry->getLlvmRig(), indexReg);
+    builder.load(resultReg, llvmType, ptrReg);
 
     node.reg = resultReg;
 }
@@ -492,7 +449,7 @@ void Analyzer::visit(ast::ArrayAssign &node) {
         output::errorUndef(node.line, node.id->value);
     }
 
-    auto rhsID = std::dynamic_pointer_cast<ast::ID>(node.exp);
+    auto rhsID = dynamic_cast<ast::ID *>(node.exp);
     if (rhsID) {
         auto rhsEntry = symbolTable.findEntry(rhsID->value, false);
         if (rhsEntry && rhsEntry->isArray()) {
@@ -511,71 +468,35 @@ void Analyzer::visit(ast::ArrayAssign &node) {
     }
 
     // Generate LLVM code for array assignment
-    string indexReg = node.index->reg;
-    string valueReg = node.exp->reg;
+    ir::Value indexReg = node.index->reg;
+    ir::Value valueReg = node.exp->reg;
 
     // Convert byte index to int if needed
     if (node.index->type == ast::BuiltInType::BYTE) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << indexReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, indexReg,
+                     ir::Type::I32);
         indexReg = extendedReg;
     }
 
     // Add bounds checking
-    string isNegativeReg = codeBuffer.freshVar();
-    string isOutOfBoundsReg = codeBuffer.freshVar();
-    string combinedCheckReg = codeBuffer.freshVar();
-    string errorLabel = codeBuffer.freshLabel();
-    string continueLabel = codeBuffer.freshLabel();
-
-    // Check if index is negative
-    codeBuffer << isNegativeReg << " = icmp slt i32 " << indexReg << ", 0"
-               << endl;
-
-    // Check if index >= array size
-    codeBuffer << isOutOfBoundsReg << " = icmp sge i32 " << indexReg << ", "
-               << entry->getArraySize() << endl;
-
-    // Combine the checks (true if out of bounds)
-    codeBuffer << combinedCheckReg << " = or i1 " << isNegativeReg << ", "
-               << isOutOfBoundsReg << endl;
-    codeBuffer << "br i1 " << combinedCheckReg << ", label " << errorLabel
-               << ", label " << continueLabel << endl;
-
-    // Handle out of bounds error
-    codeBuffer.emitLabel(errorLabel);
-    string errorMsg = "Error out of bounds";
-    string strVar = codeBuffer.emitString(errorMsg);
-    // Don't hardcode the string length, use the actual length
-    codeBuffer << "call void @print(i8* getelementptr (["
-               << errorMsg.length() + 1 << " x i8], [" << errorMsg.length() + 1
-               << " x i8]* " << strVar << ", i32 0, i32 0))" << endl;
-    codeBuffer << "call void @exit(i32 0)" << endl;
-    codeBuffer << "br label " << continueLabel << endl;
+    checkBounds(indexReg, entry->getArraySize());
 
     // Continue with array assignment
-    codeBuffer.emitLabel(continueLabel);
-
     // Handle type promotion for BYTE to INT if needed
     if (elemType == ast::BuiltInType::INT &&
         node.exp->type == ast::BuiltInType::BYTE) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << valueReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, valueReg,
+                     ir::Type::I32);
         valueReg = extendedReg;
     }
 
-    string llvmType = (elemType == ast::BuiltInType::INT)    ? "i32"
-                      : (elemType == ast::BuiltInType::BYTE) ? "i8"
-                      : (elemType == ast::BuiltInType::BOOL) ? "i1"
-                                                             : "i8*";
+    ir::Type llvmType = irType(elemType);
 
-    string ptrReg = codeBuffer.freshVar();
-    codeBuffer << ptrReg << " = getelementptr " << llvmType << ", " << llvmType
-               << "* " << entry->getLlvmRig() << ", i32 " << indexReg << endl;
-    codeBuffer << "store " << llvmType << " " << valueReg << ", " << llvmType
-               << "* " << ptrReg << endl;
+    ir::Value ptrReg = builder.temp();
+    builder.gep(ptrReg, llvmType, entry->getLlvmRig(), indexReg);
+    builder.store(llvmType, valueReg, ptrReg);
 }
 
 void Analyzer::visit(ast::Cast &node) {
@@ -598,16 +519,16 @@ void Analyzer::visit(ast::Cast &node) {
     } else if (expType == ast::BuiltInType::BYTE &&
                targetType == ast::BuiltInType::INT) {
         // Zero extend byte to int
-        string resultReg = codeBuffer.freshVar();
-        codeBuffer << resultReg << " = zext i8 " << node.exp->reg << " to i32"
-                   << endl;
+        ir::Value resultReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, resultReg, ir::Type::I8, node.exp->reg,
+                     ir::Type::I32);
         node.reg = resultReg;
     } else if (expType == ast::BuiltInType::INT &&
                targetType == ast::BuiltInType::BYTE) {
         // Truncate int to byte
-        string resultReg = codeBuffer.freshVar();
-        codeBuffer << resultReg << " = trunc i32 " << node.exp->reg << " to i8"
-                   << endl;
+        ir::Value resultReg = builder.temp();
+        builder.cast(ir::Opcode::TRUNC, resultReg, ir::Type::I32, node.exp->reg,
+                     ir::Type::I8);
         node.reg = resultReg;
     }
 }
@@ -658,7 +579,7 @@ void Analyzer::visit(ast::Call &node) {
 
             // Check if an entire array is being passed where a primitive is
             // expected.
-            auto argAsID = std::dynamic_pointer_cast<ast::ID>(args[i]);
+            auto argAsID = dynamic_cast<ast::ID *>(args[i]);
             if (argAsID) {
                 auto symbolEntryForID =
                     symbolTable.findEntry(argAsID->value, false);
@@ -678,66 +599,54 @@ void Analyzer::visit(ast::Call &node) {
     node.type = entry->getReturnType();
 
     // Generate LLVM code for function call
-    string argList = "";
+    vector<ir::Argument> argList;
     for (size_t i = 0; i < args.size(); ++i) {
-        if (i > 0)
-            argList += ", ";
-
-        string argReg = args[i]->reg;
+        ir::Value argReg = args[i]->reg;
         ast::BuiltInType argType = args[i]->type;
         ast::BuiltInType expectedType = expArgTypes[i];
 
-        // Handle string arguments - need getelementptr
+        // Handle string arguments - the address of the first character is a
+        // constant expression, nothing is computed at run time
         if (argType == ast::BuiltInType::STRING) {
-            auto stringNode = std::dynamic_pointer_cast<ast::String>(args[i]);
+            auto stringNode = dynamic_cast<ast::String *>(args[i]);
             if (stringNode) {
-                string ptrReg = codeBuffer.freshVar();
-                int strLen = stringNode->value.length() + 1;
-                codeBuffer << ptrReg << " = getelementptr [" << strLen
-                           << " x i8], [" << strLen << " x i8]* " << argReg
-                           << ", i32 0, i32 0" << endl;
-                argReg = ptrReg;
+                argReg = ir::Value::stringAddress(argReg.id);
             }
         }
 
         // Handle type promotion
         if (argType == ast::BuiltInType::BYTE &&
             expectedType == ast::BuiltInType::INT) {
-            string extendedReg = codeBuffer.freshVar();
-            codeBuffer << extendedReg << " = zext i8 " << argReg << " to i32"
-                       << endl;
+            ir::Value extendedReg = builder.temp();
+            builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, argReg,
+                         ir::Type::I32);
             argReg = extendedReg;
             argType = ast::BuiltInType::INT;
         }
 
-        string llvmType = (argType == ast::BuiltInType::INT)    ? "i32"
-                          : (argType == ast::BuiltInType::BYTE) ? "i8"
-                          : (argType == ast::BuiltInType::BOOL) ? "i1"
-                                                                : "i8*";
-        argList += llvmType + " " + argReg;
+        argList.push_back(ir::Argument{irType(argType), argReg});
     }
 
     if (entry->getReturnType() == ast::BuiltInType::VOID) {
-        codeBuffer << "call void @" << node.func_id->value << "(" << argList
-                   << ")" << endl;
-        node.reg = "";
+        builder.call(ir::Value(), ir::Type::VOID, node.func_id->value, argList);
+        node.reg = ir::Value();
     } else {
-        string resultReg = codeBuffer.freshVar();
-        string retType =
-            (entry->getReturnType() == ast::BuiltInType::INT)    ? "i32"
-            : (entry->getReturnType() == ast::BuiltInType::BYTE) ? "i8"
-            : (entry->getReturnType() == ast::BuiltInType::BOOL) ? "i1"
-                                                                 : "i8*";
-        codeBuffer << resultReg << " = call " << retType << " @"
-                   << node.func_id->value << "(" << argList << ")" << endl;
+        ir::Value resultReg = builder.temp();
+        builder.call(resultReg, irType(entry->getReturnType()),
+                     node.func_id->value, argList);
         node.reg = resultReg;
     }
 }
 
+void Analyzer::visit(ast::CallStatement &node) {
+    // The call's value, if any, is simply dropped
+    node.call->accept(*this);
+}
+
 void Analyzer::visit(ast::Statements &node) {
     bool isScopeOpen = false;
     if (!inFirstFunction) {
-        symbolTable.beginScope();
+        beginScope();
         isScopeOpen = true;
     }
 
@@ -748,14 +657,16 @@ void Analyzer::visit(ast::Statements &node) {
     }
 
     if (isScopeOpen) {
-        symbolTable.endScope();
+        endScope();
     }
 }
 
 void Analyzer::visit(ast::Break &node) {
     for (auto scope : symbolTable.getScopes()) {
         if (scope->isLoopScope()) {
-            return;  // Found a loop scope, break is valid
+            // Found a loop scope, break is valid and leaves the innermost loop
+            builder.br(loops.back().second);
+            return;
         }
     }
     output::errorUnexpectedBreak(node.line);
@@ -764,7 +675,9 @@ void Analyzer::visit(ast::Break &node) {
 void Analyzer::visit(ast::Continue &node) {
     for (auto scope : symbolTable.getScopes()) {
         if (scope->isLoopScope()) {
-            return;  // Found a loop scope, continue is valid
+            // Found a loop scope, continue is valid and checks the condition again
+            builder.br(loops.back().first);
+            return;
         }
     }
     output::errorUnexpectedContinue(node.line);
@@ -776,7 +689,7 @@ void Analyzer::visit(ast::Return &node) {
             output::errorMismatch(node.line);
         }
         // Generate LLVM code for void return
-        codeBuffer << "ret void" << endl;
+        builder.ret(ir::Type::VOID);
         return;
     }
 
@@ -791,7 +704,7 @@ void Analyzer::visit(ast::Return &node) {
     }
 
     // Check if an array is being returned where a primitive type is expected
-    auto returnAsID = std::dynamic_pointer_cast<ast::ID>(node.exp);
+    auto returnAsID = dynamic_cast<ast::ID *>(node.exp);
     if (returnAsID) {
         auto symbolEntryForReturn =
             symbolTable.findEntry(returnAsID->value, false);
@@ -805,92 +718,88 @@ void Analyzer::visit(ast::Return &node) {
     }
 
     // Generate LLVM code for return with value
-    string retReg = node.exp->reg;
-    string llvmType = (currentReturnType == BuiltInType::INT)    ? "i32"
-                      : (currentReturnType == BuiltInType::BYTE) ? "i8"
-                      : (currentReturnType == BuiltInType::BOOL) ? "i1"
-                                                                 : "i8*";
+    ir::Value retReg = node.exp->reg;
+    ir::Type llvmType = irType(currentReturnType);
 
     // Handle type promotion
     if (currentReturnType == ast::BuiltInType::INT &&
         node.exp->type == ast::BuiltInType::BYTE) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << retReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, retReg,
+                     ir::Type::I32);
         retReg = extendedReg;
     }
 
-    codeBuffer << "ret " << llvmType << " " << retReg << endl;
+    builder.ret(llvmType, retReg);
 }
 
 void Analyzer::visit(ast::If &node) {
-    node.condition->accept(*this);
+    ir::BranchList trueList, falseList;
+    condition(*node.condition, trueList, falseList);
     if (node.condition->type != ast::BuiltInType::BOOL) {
         output::errorMismatch(node.line);
     }
 
     // Generate LLVM code for if statement
-    string thenLabel = codeBuffer.freshLabel();
-    string elseLabel = codeBuffer.freshLabel();
-    string endLabel = codeBuffer.freshLabel();
+    ir::Block *thenLabel = builder.newBlock();
+    ir::Block *elseLabel = node.otherwise ? builder.newBlock() : nullptr;
+    ir::Block *endLabel = builder.newBlock();
 
-    // Conditional branch
-    if (node.otherwise) {
-        codeBuffer << "br i1 " << node.condition->reg << ", label " << thenLabel
-                   << ", label " << elseLabel << endl;
-    } else {
-        codeBuffer << "br i1 " << node.condition->reg << ", label " << thenLabel
-                   << ", label " << endLabel << endl;
-    }
+    // The condition jumps straight into the branches
+    builder.backpatch(trueList, thenLabel);
+    builder.backpatch(falseList, node.otherwise ? elseLabel : endLabel);
 
     // Then block
-    codeBuffer.emitLabel(thenLabel);
-    symbolTable.beginScope();
+    builder.place(thenLabel);
+    beginScope();
     node.then->accept(*this);
-    symbolTable.endScope();
-    codeBuffer << "br label " << endLabel << endl;
+    endScope();
+    builder.br(endLabel);
 
     // Else block (if exists)
     if (node.otherwise) {
-        codeBuffer.emitLabel(elseLabel);
-        symbolTable.beginScope();
+        builder.place(elseLabel);
+        beginScope();
         node.otherwise->accept(*this);
-        symbolTable.endScope();
-        codeBuffer << "br label " << endLabel << endl;
+        endScope();
+        builder.br(endLabel);
     }
 
     // End label
-    codeBuffer.emitLabel(endLabel);
+    builder.place(endLabel);
 }
 
 void Analyzer::visit(ast::While &node) {
     // Generate LLVM code for while loop
-    string condLabel = codeBuffer.freshLabel();
-    string bodyLabel = codeBuffer.freshLabel();
-    string endLabel = codeBuffer.freshLabel();
+    ir::Block *condLabel = builder.newBlock();
+    ir::Block *bodyLabel = builder.newBlock();
+    ir::Block *endLabel = builder.newBlock();
 
     // Jump to condition check
-    codeBuffer << "br label " << condLabel << endl;
+    builder.br(condLabel);
 
-    // Condition check
-    codeBuffer.emitLabel(condLabel);
-    node.condition->accept(*this);
+    // Condition check, jumping into the body or out of the loop
+    builder.place(condLabel);
+    ir::BranchList trueList, falseList;
+    condition(*node.condition, trueList, falseList);
     if (node.condition->type != ast::BuiltInType::BOOL) {
         output::errorMismatch(node.line);
     }
-    codeBuffer << "br i1 " << node.condition->reg << ", label " << bodyLabel
-               << ", label " << endLabel << endl;
+    builder.backpatch(trueList, bodyLabel);
+    builder.backpatch(falseList, endLabel);
 
     // Loop body
-    codeBuffer.emitLabel(bodyLabel);
-    symbolTable.beginScope();
+    builder.place(bodyLabel);
+    beginScope();
     symbolTable.getLastScope()->setLoopScope(true);  // Mark this scope as a loop scope
+    loops.push_back({condLabel, endLabel});
     node.body->accept(*this);
-    symbolTable.endScope();
-    codeBuffer << "br label " << condLabel << endl;  // Jump back to condition
+    loops.pop_back();
+    endScope();
+    builder.br(condLabel);  // Jump back to condition
 
     // End label
-    codeBuffer.emitLabel(endLabel);
+    builder.place(endLabel);
 }
 
 void Analyzer::visit(ast::VarDecl &node) {
@@ -902,20 +811,16 @@ void Analyzer::visit(ast::VarDecl &node) {
         output::errorDef(node.line, node.id->value);
     }
 
-    auto arrType = std::dynamic_pointer_cast<ast::ArrayType>(node.type);
-    auto primType = std::dynamic_pointer_cast<ast::PrimitiveType>(node.type);
+    auto arrType = dynamic_cast<ast::ArrayType *>(node.type);
+    auto primType = dynamic_cast<ast::PrimitiveType *>(node.type);
 
-    BuiltInType expectedType;
-    if (primType) {
-        expectedType = primType->type;
-    } else if (arrType) {
-        expectedType = arrType->type;
-    }
+    // A declared type is either primitive or an array
+    BuiltInType expectedType = primType ? primType->type : arrType->type;
 
     if (node.init_exp) {
         node.init_exp->accept(*this);
 
-        auto initID = std::dynamic_pointer_cast<ast::ID>(node.init_exp);
+        auto initID = dynamic_cast<ast::ID *>(node.init_exp);
         // Check if init_exp is an array
         if (initID) {
             auto initEntry = symbolTable.findEntry(initID->value, false);
@@ -934,7 +839,7 @@ void Analyzer::visit(ast::VarDecl &node) {
             }
         }
 
-        auto initCall = std::dynamic_pointer_cast<ast::Call>(node.init_exp);
+        auto initCall = dynamic_cast<ast::Call *>(node.init_exp);
         if (initCall) {
             auto funcEntry =
                 symbolTable.findEntry(initCall->func_id->value, true);
@@ -951,84 +856,28 @@ void Analyzer::visit(ast::VarDecl &node) {
     }
 
     // Generate LLVM code for variable declaration
-    string varReg = codeBuffer.freshVar();
-    string llvmType;
+    ir::Value varReg;
+    ir::Type llvmType;
 
     if (arrType) {
         arrType->accept(*this);
         int size = getArraySize(arrType);
-        llvmType = (arrType->type == ast::BuiltInType::INT)    ? "i32"
-                   : (arrType->type == ast::BuiltInType::BYTE) ? "i8"
-                   : (arrType->type == ast::BuiltInType::BOOL) ? "i1"
-                                                               : "i8*";
+        llvmType = irType(arrType->type);
 
-        codeBuffer << varReg << " = alloca " << llvmType << ", i32 " << size
-                   << endl;
+        // Arrays of disjoint scopes share slots, see FrameLayout
+        varReg = frame.place(builder, llvmType, size);
 
         // Initialize array elements to 0
-        string zeroValue;
-        if (arrType->type == ast::BuiltInType::INT)
-            zeroValue = "0";
-        else if (arrType->type == ast::BuiltInType::BYTE)
-            zeroValue = "0";
-        else if (arrType->type == ast::BuiltInType::BOOL)
-            zeroValue = "0";
-        else  // String
-            zeroValue = "null";
-
-        // Loop through array and initialize each element to zero
-        string indexVar = codeBuffer.freshVar();
-        string loopStart = codeBuffer.freshLabel();
-        string loopBody = codeBuffer.freshLabel();
-        string loopEnd = codeBuffer.freshLabel();
-        string elemPtrVar = codeBuffer.freshVar();
-
-        // Initialize loop counter
-        codeBuffer << indexVar << " = alloca i32" << endl;
-        codeBuffer << "store i32 0, i32* " << indexVar << endl;
-        codeBuffer << "br label " << loopStart << endl;
-
-        // Loop condition check
-        codeBuffer.emitLabel(loopStart);
-        string currentIndex = codeBuffer.freshVar();
-        string conditionVar = codeBuffer.freshVar();
-        codeBuffer << currentIndex << " = load i32, i32* " << indexVar << endl;
-        codeBuffer << conditionVar << " = icmp slt i32 " << currentIndex << ", "
-                   << size << endl;
-        codeBuffer << "br i1 " << conditionVar << ", label " << loopBody
-                   << ", label " << loopEnd << endl;
-
-        // Loop body - set element to zero
-        codeBuffer.emitLabel(loopBody);
-        string reloadedIndex = codeBuffer.freshVar();
-        codeBuffer << reloadedIndex << " = load i32, i32* " << indexVar << endl;
-        codeBuffer << elemPtrVar << " = getelementptr " << llvmType << ", "
-                   << llvmType << "* " << varReg << ", i32 " << reloadedIndex
-                   << endl;
-        codeBuffer << "store " << llvmType << " " << zeroValue << ", "
-                   << llvmType << "* " << elemPtrVar << endl;
-
-        // Increment loop counter
-        string incrementedIndex = codeBuffer.freshVar();
-        codeBuffer << incrementedIndex << " = add i32 " << reloadedIndex
-                   << ", 1" << endl;
-        codeBuffer << "store i32 " << incrementedIndex << ", i32* " << indexVar
-                   << endl;
-        codeBuffer << "br label " << loopStart << endl;
-
-        // Loop exit
-        codeBuffer.emitLabel(loopEnd);
+        zeroArray(varReg, llvmType, size);
 
         symbolTable.addEntry(std::make_shared<SymbolEntry>(
             node.id->value, std::vector<ast::BuiltInType>{arrType->type}, false,
             false, 0, BuiltInType::VOID, false, true, size, varReg));
     } else {
-        llvmType = (expectedType == ast::BuiltInType::INT)    ? "i32"
-                   : (expectedType == ast::BuiltInType::BYTE) ? "i8"
-                   : (expectedType == ast::BuiltInType::BOOL) ? "i1"
-                                                              : "i8*";
+        llvmType = irType(expectedType);
 
-        codeBuffer << varReg << " = alloca " << llvmType << endl;
+        varReg = builder.temp();
+        builder.allocate(varReg, llvmType);
 
         symbolTable.addEntry(std::make_shared<SymbolEntry>(
             node.id->value, std::vector<ast::BuiltInType>{expectedType}, false,
@@ -1036,33 +885,31 @@ void Analyzer::visit(ast::VarDecl &node) {
 
         // Initialize the variable if there's an init expression
         if (node.init_exp) {
-            string initReg = node.init_exp->reg;
+            ir::Value initReg = node.init_exp->reg;
 
             // Handle type promotion
             if (expectedType == ast::BuiltInType::INT &&
                 node.init_exp->type == ast::BuiltInType::BYTE) {
-                string extendedReg = codeBuffer.freshVar();
-                codeBuffer << extendedReg << " = zext i8 " << initReg
-                           << " to i32" << endl;
+                ir::Value extendedReg = builder.temp();
+                builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, initReg,
+                             ir::Type::I32);
                 initReg = extendedReg;
             }
 
-            codeBuffer << "store " << llvmType << " " << initReg << ", "
-                       << llvmType << "* " << varReg << endl;
+            builder.store(llvmType, initReg, varReg);
         } else {
             // Initialize primitive variables to 0
-            string zeroValue;
+            ir::Value zeroValue;
             if (expectedType == ast::BuiltInType::INT)
-                zeroValue = "0";
+                zeroValue = ir::Value::constant(0);
             else if (expectedType == ast::BuiltInType::BYTE)
-                zeroValue = "0";
+                zeroValue = ir::Value::constant(0);
             else if (expectedType == ast::BuiltInType::BOOL)
-                zeroValue = "0";
+                zeroValue = ir::Value::constant(0);
             else  // String
-                zeroValue = "null";
+                zeroValue = ir::Value::null();
 
-            codeBuffer << "store " << llvmType << " " << zeroValue << ", "
-                       << llvmType << "* " << varReg << endl;
+            builder.store(llvmType, zeroValue, varReg);
         }
     }
 }
@@ -1073,13 +920,13 @@ void Analyzer::visit(ast::Assign &node) {
 
     node.id->accept(*this);
 
-    auto lhsID = std::dynamic_pointer_cast<ast::ID>(node.id);
+    auto lhsID = dynamic_cast<ast::ID *>(node.id);
     std::shared_ptr<SymbolEntry> lhsEntry = nullptr;
 
     if (lhsID) {
         lhsEntry = symbolTable.findEntry(lhsID->value, false);
     } else if (auto lhsArrayDeref =
-                   std::dynamic_pointer_cast<ast::ArrayDereference>(node.id)) {
+                   dynamic_cast<ast::ArrayDereference *>(node.id)) {
         lhsEntry = symbolTable.findEntry(lhsArrayDeref->id->value, false);
     }
 
@@ -1097,7 +944,7 @@ void Analyzer::visit(ast::Assign &node) {
     }
 
     ast::BuiltInType lhsResolvedType;
-    if (std::dynamic_pointer_cast<ast::ArrayDereference>(node.id)) {
+    if (dynamic_cast<ast::ArrayDereference *>(node.id)) {
         lhsResolvedType = node.id->type;
     } else {
         // It's a simple ID
@@ -1106,12 +953,12 @@ void Analyzer::visit(ast::Assign &node) {
 
     // LHS is an array variable itself
     if (lhsEntry && lhsEntry->isArray() &&
-        !std::dynamic_pointer_cast<ast::ArrayDereference>(node.id)) {
+        !dynamic_cast<ast::ArrayDereference *>(node.id)) {
         output::ErrorInvalidAssignArray(node.line, lhsEntry->getName());
     }
 
     // RHS is an array variable being assigned to a primitive LHS
-    auto rhsAsID = std::dynamic_pointer_cast<ast::ID>(node.exp);
+    auto rhsAsID = dynamic_cast<ast::ID *>(node.exp);
     if (rhsAsID) {
         auto rhsEntry = symbolTable.findEntry(rhsAsID->value, false);
         if (rhsEntry && rhsEntry->isArray()) {
@@ -1128,64 +975,56 @@ void Analyzer::visit(ast::Assign &node) {
     }
 
     // Generate LLVM code for assignment
-    string rhsReg = node.exp->reg;
-    string lhsPtr;
+    ir::Value rhsReg = node.exp->reg;
+    ir::Value lhsPtr;
 
     // Handle type promotion
     if (lhsResolvedType == ast::BuiltInType::INT &&
         rhsType == ast::BuiltInType::BYTE) {
-        string extendedReg = codeBuffer.freshVar();
-        codeBuffer << extendedReg << " = zext i8 " << rhsReg << " to i32"
-                   << endl;
+        ir::Value extendedReg = builder.temp();
+        builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, rhsReg,
+                     ir::Type::I32);
         rhsReg = extendedReg;
     }
 
-    string llvmType = (lhsResolvedType == ast::BuiltInType::INT)    ? "i32"
-                      : (lhsResolvedType == ast::BuiltInType::BYTE) ? "i8"
-                      : (lhsResolvedType == ast::BuiltInType::BOOL) ? "i1"
-                                                                    : "i8*";
+    ir::Type llvmType = irType(lhsResolvedType);
 
     if (auto arrayDeref =
-            std::dynamic_pointer_cast<ast::ArrayDereference>(node.id)) {
+            dynamic_cast<ast::ArrayDereference *>(node.id)) {
         // Array element assignment - need to get the pointer first
-        string indexReg = arrayDeref->index->reg;
+        ir::Value indexReg = arrayDeref->index->reg;
 
         // Convert byte index to int if needed
         if (arrayDeref->index->type == ast::BuiltInType::BYTE) {
-            string extendedReg = codeBuffer.freshVar();
-            codeBuffer << extendedReg << " = zext i8 " << indexReg << " to i32"
-                       << endl;
+            ir::Value extendedReg = builder.temp();
+            builder.cast(ir::Opcode::ZEXT, extendedReg, ir::Type::I8, indexReg,
+                         ir::Type::I32);
             indexReg = extendedReg;
         }
 
-        string ptrReg = codeBuffer.freshVar();
-        codeBuffer << ptrReg << " = getelementptr " << llvmType << ", "
-                   << llvmType << "* " << lhsEntry->getLlvmRig() << ", i32 "
-                   << indexReg << endl;
+        ir::Value ptrReg = builder.temp();
+        builder.gep(ptrReg, llvmType, lhsEntry->getLlvmRig(), indexReg);
         lhsPtr = ptrReg;
     } else {
         // Simple variable assignment
         lhsPtr = lhsEntry->getLlvmRig();
     }
 
-    codeBuffer << "store " << llvmType << " " << rhsReg << ", " << llvmType
-               << "* " << lhsPtr << endl;
+    builder.store(llvmType, rhsReg, lhsPtr);
 }
 
 void Analyzer::visit(ast::Formal &node) {
     // Check for illegal array type in parameters
-    auto arrType = std::dynamic_pointer_cast<ast::ArrayType>(node.type);
+    auto arrType = dynamic_cast<ast::ArrayType *>(node.type);
     if (arrType) {
         output::errorMismatch(node.line);
     }
 
-    auto primType = std::dynamic_pointer_cast<ast::PrimitiveType>(node.type);
+    auto primType = dynamic_cast<ast::PrimitiveType *>(node.type);
     if (!primType) {
         output::errorMismatch(node.line);
     }
 
-    ast::BuiltInType expectedType = primType->type;
-
     node.id->accept(*this);
     node.type->accept(*this);
 }
@@ -1202,7 +1041,7 @@ void Analyzer::visit(ast::FuncDecl &node) {
     auto funcEntry = symbolTable.findEntry(node.id->value, true);
     auto expArgTypes = funcEntry->getType();
     auto primReturnType =
-        std::dynamic_pointer_cast<ast::PrimitiveType>(node.return_type);
+        dynamic_cast<ast::PrimitiveType *>(node.return_type);
     if (!primReturnType) {
         auto expectedTypes = builtInTypeToString(expArgTypes);
         output::errorPrototypeMismatch(
@@ -1214,7 +1053,7 @@ void Analyzer::visit(ast::FuncDecl &node) {
     vector<ast::BuiltInType> formalTypes;
     for (const auto &formal : node.formals->formals) {
         auto formalPrimType =
-            std::dynamic_pointer_cast<ast::PrimitiveType>(formal->type);
+            dynamic_cast<ast::PrimitiveType *>(formal->type);
         if (!formalPrimType) {
             output::errorMismatch(
                 formal->line);  // formal parameter must be primitive
@@ -1225,25 +1064,18 @@ void Analyzer::visit(ast::FuncDecl &node) {
     const auto &funcName = node.id->value;
 
     // Generate LLVM function declaration
-    string retTypeStr = (returnType == ast::BuiltInType::VOID)   ? "void"
-                        : (returnType == ast::BuiltInType::INT)  ? "i32"
-                        : (returnType == ast::BuiltInType::BYTE) ? "i8"
-                        : (returnType == ast::BuiltInType::BOOL) ? "i1"
-                                                                 : "i8*";
+    ir::Type retType = (returnType == ast::BuiltInType::VOID) ? ir::Type::VOID
+                                                              : irType(returnType);
 
-    string paramList = "";
+    vector<ir::Type> paramList;
     for (size_t i = 0; i < formalTypes.size(); ++i) {
-        if (i > 0)
-            paramList += ", ";
-        string paramType = (formalTypes[i] == ast::BuiltInType::INT)    ? "i32"
-                           : (formalTypes[i] == ast::BuiltInType::BYTE) ? "i8"
-                           : (formalTypes[i] == ast::BuiltInType::BOOL) ? "i1"
-                                                                        : "i8*";
-        paramList += paramType;
+        paramList.push_back(irType(formalTypes[i]));
     }
 
-    codeBuffer << "define " << retTypeStr << " @" << funcName << "("
-               << paramList << ") {" << endl;
+    auto function = std::make_unique<ir::Function>(funcName, retType, paramList);
+    builder.setFunction(function.get());
+    frame.reset();
+    traps.clear();
 
     // opening a new scope for function body
     symbolTable.beginScope();
@@ -1256,15 +1088,11 @@ void Analyzer::visit(ast::FuncDecl &node) {
     // parameter
     for (size_t i = 0; i < node.formals->formals.size(); ++i) {
         auto &formal = node.formals->formals[i];
-        string paramReg = codeBuffer.freshVar();
-        string llvmType = (formalTypes[i] == BuiltInType::INT)    ? "i32"
-                          : (formalTypes[i] == BuiltInType::BYTE) ? "i8"
-                          : (formalTypes[i] == BuiltInType::BOOL) ? "i1"
-                                                                  : "i8*";
+        ir::Value paramReg = builder.temp();
+        ir::Type llvmType = paramList[i];
 
-        codeBuffer << paramReg << " = alloca " << llvmType << endl;
-        codeBuffer << "store " << llvmType << " %" << i << ", " << llvmType
-                   << "* " << paramReg << endl;
+        builder.allocate(paramReg, llvmType);
+        builder.store(llvmType, ir::Value::argument(static_cast<int>(i)), paramReg);
 
         // Add the formal parameter to symbol table with LLVM register
         symbolTable.addEntry(std::make_shared<SymbolEntry>(
@@ -1286,53 +1114,191 @@ void Analyzer::visit(ast::FuncDecl &node) {
 
     // Add implicit return for void functions
     if (returnType == ast::BuiltInType::VOID) {
-        codeBuffer << "ret void" << endl;
+        builder.ret(ir::Type::VOID);
+    } else if (!builder.isTerminated()) {
+        // Falling off the end of a non-void function is undefined, and the
+        // passes expect every block to end in a terminator
+        builder.unreachable();
     }
+    placeTraps();
 
     symbolTable.endScope();
+    frameBytes += frame.frameBytes();
+    unsharedFrameBytes += frame.unsharedBytes();
 
-    codeBuffer << "}" << endl << endl;
+    passStats += ir::runPasses(*function, passes);
+    module.functions.push_back(std::move(function));
 }
 
 void Analyzer::visit(ast::Funcs &node) {
+    // The runtime (print, printi, readi) is supplied by the IR printer
+    declareFunctions(node);
+    if (jobs > 1 && node.funcs.size() > 1) {
+        visitFunctionsParallel(node);
+    } else {
+        for (auto &func : node.funcs) {
+            func->accept(*this);
+        }
+    }
+    // Needs every function lowered, so it runs once the bodies are done
+    if (passes.inlineThreshold > 0) {
+        passStats.callsInlined += ir::inlineCalls(module, passes, inlineReport);
+    }
+    symbolTable.endScope();
+}
+
+void Analyzer::zeroArray(ir::Value array, ir::Type elementType, int length) {
+    // A few elements are cheaper stored one by one than through a call
+    if (length <= smallArrayLength) {
+        for (int i = 0; i < length; ++i) {
+            ir::Value elemPtr = builder.temp();
+            builder.gep(elemPtr, elementType, array, ir::Value::constant(i));
+            builder.store(elementType, ir::Value::constant(0), elemPtr);
+        }
+        return;
+    }
+
+    // Otherwise one memset over the whole array; bool elements take a byte each
+    ir::Value bytes = array;
+    if (elementType != ir::Type::I8) {
+        bytes = builder.temp();
+        builder.cast(ir::Opcode::BITCAST, bytes, elementType, array, ir::Type::I8);
+    }
+    int size = elementType == ir::Type::I32 ? length * 4 : length;
+    builder.call(ir::Value(), ir::Type::VOID, "llvm.memset.p0i8.i32",
+                 {ir::Argument{ir::Type::I8_PTR, bytes},
+                  ir::Argument{ir::Type::I8, ir::Value::constant(0)},
+                  ir::Argument{ir::Type::I32, ir::Value::constant(size)},
+                  ir::Argument{ir::Type::I1, ir::Value::constant(0)}});
+}
+
+void Analyzer::beginScope() {
+    symbolTable.beginScope();
+    frame.beginScope();
+}
+
+void Analyzer::endScope() {
+    frame.endScope(builder);
+    symbolTable.endScope();
+}
+
+void Analyzer::condition(ast::Exp &exp, ir::BranchList &trueList,
+                         ir::BranchList &falseList) {
+    if (auto andExp = dynamic_cast<ast::And *>(&exp)) {
+        // Only a true left operand reaches the right one
+        ir::BranchList leftTrue;
+        condition(*andExp->left, leftTrue, falseList);
+        ir::Block *rightLabel = builder.newBlock();
+        builder.backpatch(leftTrue, rightLabel);
+        builder.place(rightLabel);
+        condition(*andExp->right, trueList, falseList);
+
+        if (andExp->left->type != ast::BuiltInType::BOOL ||
+            andExp->right->type != ast::BuiltInType::BOOL) {
+            output::errorMismatch(andExp->line);
+        }
+        andExp->type = ast::BuiltInType::BOOL;
+    } else if (auto orExp = dynamic_cast<ast::Or *>(&exp)) {
+        // Only a false left operand reaches the right one
+        ir::BranchList leftFalse;
+        condition(*orExp->left, trueList, leftFalse);
+        ir::Block *rightLabel = builder.newBlock();
+        builder.backpatch(leftFalse, rightLabel);
+        builder.place(rightLabel);
+        condition(*orExp->right, trueList, falseList);
+
+        if (orExp->left->type != ast::BuiltInType::BOOL ||
+            orExp->right->type != ast::BuiltInType::BOOL) {
+            output::errorMismatch(orExp->line);
+        }
+        orExp->type = ast::BuiltInType::BOOL;
+    } else if (auto notExp = dynamic_cast<ast::Not *>(&exp)) {
+        // The operand's targets, swapped
+        condition(*notExp->exp, falseList, trueList);
+        if (notExp->exp->type != ast::BuiltInType::BOOL) {
+            output::errorMismatch(notExp->line);
+        }
+        notExp->type = ast::BuiltInType::BOOL;
+    } else if (auto boolExp = dynamic_cast<ast::Bool *>(&exp)) {
+        boolExp->type = ast::BuiltInType::BOOL;
+        builder.br(boolExp->value ? trueList : falseList);
+    } else {
+        exp.accept(*this);
+        if (exp.type == ast::BuiltInType::BOOL) {
+            builder.condBr(exp.reg, trueList, falseList);
+        }
+    }
+}
+
+ir::Value Analyzer::materialize(const ir::BranchList &trueList,
+                                const ir::BranchList &falseList) {
+    // Each outcome gets a block of its own, so every phi entry names a
+    // distinct predecessor. An outcome no branch leads to is left out
+    ir::Block *endLabel = builder.newBlock();
+    vector<ir::Incoming> incoming;
+    if (!trueList.empty()) {
+        ir::Block *trueLabel = builder.newBlock();
+        builder.backpatch(trueList, trueLabel);
+        builder.place(trueLabel);
+        builder.br(endLabel);
+        incoming.push_back(ir::Incoming{ir::Value::constant(1), trueLabel});
+    }
+    if (!falseList.empty()) {
+        ir::Block *falseLabel = builder.newBlock();
+        builder.backpatch(falseList, falseLabel);
+        builder.place(falseLabel);
+        builder.br(endLabel);
+        incoming.push_back(ir::Incoming{ir::Value::constant(0), falseLabel});
+    }
+    builder.place(endLabel);
+
+    ir::Value resultReg = builder.temp();
+    builder.phi(resultReg, ir::Type::I1, incoming);
+    return resultReg;
+}
+
+void Analyzer::checkBounds(ir::Value index, int length) {
+    // Negative indices wrap to large unsigned values, so one compare catches both ends
+    ir::Value isOutOfBoundsReg = builder.temp();
+    builder.icmp(isOutOfBoundsReg, ir::Predicate::UGE, ir::Type::I32, index,
+                 ir::Value::constant(length));
+    failIf(isOutOfBoundsReg, "Error out of bounds");
+}
+
+void Analyzer::failIf(ir::Value condition, const string &message) {
+    ir::Block *continueLabel = builder.newBlock();
+    builder.condBr(condition, trap(message), continueLabel);
+    builder.place(continueLabel);
+}
+
+ir::Block *Analyzer::trap(const string &message) {
+    for (auto &existing : traps) {
+        if (existing.first == message) {
+            return existing.second;
+        }
+    }
+    traps.push_back({message, builder.newBlock()});
+    return traps.back().second;
+}
+
+void Analyzer::placeTraps() {
+    // Out of the way of the code that branches to them, after the last block
+    for (auto &existing : traps) {
+        builder.place(existing.second);
+        ir::Value strVar = builder.string(existing.first);
+        builder.call(ir::Value(), ir::Type::VOID, "print",
+                     {ir::Argument{ir::Type::I8_PTR, ir::Value::stringAddress(strVar.id)}});
+        builder.call(ir::Value(), ir::Type::VOID, "exit",
+                     {ir::Argument{ir::Type::I32, ir::Value::constant(0)}});
+        builder.unreachable();
+    }
+    traps.clear();
+}
+
+void Analyzer::declareFunctions(ast::Funcs &node) {
     bool mainFound = false;
     bool mainValid = false;
 
-    // Emit the print functions at the beginning
-    codeBuffer.emit("declare i32 @scanf(i8*, ...)\n");
-    codeBuffer.emit("declare i32 @printf(i8*, ...)\n");
-    codeBuffer.emit("declare void @exit(i32)\n");
-    codeBuffer.emit("@.int_specifier_scan = constant [3 x i8] c\"%d\\00\"\n");
-    codeBuffer.emit("@.int_specifier = constant [4 x i8] c\"%d\\0A\\00\"\n");
-    codeBuffer.emit("@.str_specifier = constant [4 x i8] c\"%s\\0A\\00\"\n\n");
-
-    codeBuffer.emit("define i32 @readi(i32) {\n");
-    codeBuffer.emit("    %ret_val = alloca i32\n");
-    codeBuffer.emit(
-        "    %spec_ptr = getelementptr [3 x i8], [3 x i8]* "
-        "@.int_specifier_scan, i32 0, i32 0\n");
-    codeBuffer.emit(
-        "    call i32 (i8*, ...) @scanf(i8* %spec_ptr, i32* %ret_val)\n");
-    codeBuffer.emit("    %val = load i32, i32* %ret_val\n");
-    codeBuffer.emit("    ret i32 %val\n");
-    codeBuffer.emit("}\n\n");
-
-    codeBuffer.emit("define void @printi(i32) {\n");
-    codeBuffer.emit(
-        "    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.int_specifier, "
-        "i32 0, i32 0\n");
-    codeBuffer.emit("    call i32 (i8*, ...) @printf(i8* %spec_ptr, i32 %0)\n");
-    codeBuffer.emit("    ret void\n");
-    codeBuffer.emit("}\n\n");
-
-    codeBuffer.emit("define void @print(i8*) {\n");
-    codeBuffer.emit(
-        "    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.str_specifier, "
-        "i32 0, i32 0\n");
-    codeBuffer.emit("    call i32 (i8*, ...) @printf(i8* %spec_ptr, i8* %0)\n");
-    codeBuffer.emit("    ret void\n");
-    codeBuffer.emit("}\n\n");
-
     symbolTable.beginScope();
     symbolTable.addEntry(std::make_shared<SymbolEntry>(
         "print", std::vector<ast::BuiltInType>{ast::BuiltInType::STRING}, true,
@@ -1345,7 +1311,7 @@ void Analyzer::visit(ast::Funcs &node) {
     for (auto &func : node.funcs) {
         if (func->id->value == "main") {
             mainFound = true;
-            auto retType = std::dynamic_pointer_cast<ast::PrimitiveType>(
+            auto retType = dynamic_cast<ast::PrimitiveType *>(
                 func->return_type);
             if (retType && func->formals->formals.empty() &&
                 retType->type == ast::BuiltInType::VOID) {
@@ -1358,7 +1324,7 @@ void Analyzer::visit(ast::Funcs &node) {
         }
 
         auto retType =
-            std::dynamic_pointer_cast<ast::PrimitiveType>(func->return_type);
+            dynamic_cast<ast::PrimitiveType *>(func->return_type);
         if (!retType) {
             output::errorMismatch(
                 func->line);  // function must return primitive
@@ -1371,8 +1337,78 @@ void Analyzer::visit(ast::Funcs &node) {
     if (!mainFound || !mainValid) {
         output::errorMainMissing();
     }
-    for (auto &func : node.funcs) {
-        func->accept(*this);
+}
+
+void Analyzer::visitFunctionsParallel(ast::Funcs &node) {
+    // Outcome of one function body: its IR, or the diagnostic it stopped at
+    struct FunctionResult {
+        std::unique_ptr<ir::Function> function;
+        std::exception_ptr error;
+        std::size_t frameBytes = 0;
+        std::size_t unsharedFrameBytes = 0;
+        ir::PassStats passStats;
+    };
+    const size_t count = node.funcs.size();
+    std::vector<FunctionResult> results(count);
+
+    // Functions after the first failing one need not be analyzed at all
+    std::atomic<size_t> firstError(count);
+
+    // Each worker analyzer has the global scope of its own, so symbol tables are never shared.
+    // One that hit an error is left with open scopes and is dropped
+    std::mutex idleMutex;
+    std::vector<std::unique_ptr<Analyzer>> idle;
+
+    {
+        ThreadPool pool(jobs);
+        for (size_t i = 0; i < count; ++i) {
+            pool.submit([&, i] {
+                if (i > firstError.load()) {
+                    return;
+                }
+                std::unique_ptr<Analyzer> worker;
+                {
+                    std::lock_guard<std::mutex> lock(idleMutex);
+                    if (!idle.empty()) {
+                        worker = std::move(idle.back());
+                        idle.pop_back();
+                    }
+                }
+                try {
+                    if (!worker) {
+                        worker = std::make_unique<Analyzer>(1, passes);
+                        worker->declareFunctions(node);
+                    }
+                    node.funcs[i]->accept(*worker);
+                    results[i].frameBytes = worker->frame.frameBytes();
+                    results[i].unsharedFrameBytes = worker->frame.unsharedBytes();
+                    results[i].passStats = worker->passStats;
+                    worker->passStats = ir::PassStats();
+                    results[i].function = std::move(worker->module.functions.back());
+                    worker->module.functions.pop_back();
+                } catch (...) {
+                    results[i].error = std::current_exception();
+                    size_t seen = firstError.load();
+                    while (i < seen && !firstError.compare_exchange_weak(seen, i)) {
+                    }
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(idleMutex);
+                idle.push_back(std::move(worker));
+            });
+        }
+        pool.wait();
+    }
+
+    // Same order and first diagnostic as the serial walk. Names are local to
+    // each function until printing, so nothing needs renumbering
+    for (size_t i = 0; i < count; ++i) {
+        if (results[i].error) {
+            std::rethrow_exception(results[i].error);
+        }
+        module.functions.push_back(std::move(results[i].function));
+        frameBytes += results[i].frameBytes;
+        unsharedFrameBytes += results[i].unsharedFrameBytes;
+        passStats += results[i].passStats;
     }
-    symbolTable.endScope();
 }
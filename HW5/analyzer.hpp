@@ -4,26 +4,108 @@
 #include "visitor.hpp"
 #include "symbolTable.hpp"
 #include "output.hpp"
+#include "ir.hpp"
+#include "chunkBuffer.hpp"
+#include "passes.hpp"
+#include "frameLayout.hpp"
+#include <cstddef>
 #include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
 
 class Analyzer : public Visitor
 {
 private:
     SymbolTable symbolTable;
-    output::CodeBuffer codeBuffer;
+    ir::Module module;
+    ir::Builder builder;
     bool inFirstFunction;
     BuiltInType currentReturnType;
+    // Threads used for the function bodies, 1 analyzes them in order on the caller
+    std::size_t jobs;
+    // Run on every function once it is lowered
+    ir::PassOptions passes;
+    // Array slots of the function being lowered
+    ir::FrameLayout frame;
+    // Array bytes of all functions lowered so far, with and without slot sharing
+    std::size_t frameBytes;
+    std::size_t unsharedFrameBytes;
+    // What the passes did to the functions lowered so far
+    ir::PassStats passStats;
+    // What the inliner did at each call site, in source order
+    std::vector<std::string> inlineReport;
+    // Trap blocks of the function being lowered, with their messages
+    std::vector<std::pair<std::string, ir::Block *>> traps;
+    // Blocks continue and break jump to in the enclosing loops, innermost last
+    std::vector<std::pair<ir::Block *, ir::Block *>> loops;
+
+    // Sets every element of a freshly declared array to zero
+    void zeroArray(ir::Value array, ir::Type elementType, int length);
+
+    // Open and close a block scope, in the symbol table and in the frame
+    void beginScope();
+    void endScope();
+
+    // Opens the global scope and registers the built-ins and every function signature
+    void declareFunctions(ast::Funcs &node);
+
+    // Analyzes each function body on a worker with its own module, then moves
+    // the functions into this one in source order
+    void visitFunctionsParallel(ast::Funcs &node);
+
+    // Branches to an out of bounds error unless 0 <= index < length. The
+    // bounds check pass recognizes the unsigned compare this emits
+    void checkBounds(ir::Value index, int length);
+
+    // Branches to the trap for message if condition holds, and continues
+    // emitting in a new block otherwise
+    void failIf(ir::Value condition, const std::string &message);
+
+    // The block of the current function that prints message and exits, made
+    // on first use. Every check with the same message shares it
+    ir::Block *trap(const std::string &message);
+
+    // Lays out the traps of the function after its last block
+    void placeTraps();
+
+    // Lowers a boolean expression as jumping code. The branches taken when it
+    // is true and when it is false are left open in trueList and falseList, so
+    // and/or evaluate their right operand only when it decides the result.
+    // Nothing is branched on when exp turns out not to be a boolean
+    void condition(ast::Exp &exp, ir::BranchList &trueList, ir::BranchList &falseList);
+
+    // Value of a condition lowered by condition(), merged by a phi
+    ir::Value materialize(const ir::BranchList &trueList, const ir::BranchList &falseList);
 
 public:
-    Analyzer();
-    void printOutput();
+    explicit Analyzer(std::size_t jobs = 1, const ir::PassOptions &passes = ir::PassOptions());
+    void printOutput(std::ostream &os = std::cout);
+    // Prints the generated module into out
+    void printOutput(output::ChunkBuffer &out);
     void setInFirstFunction(bool val);
     bool getInFirstFunction() const;
     BuiltInType getCurrentReturnType() const;
     void setCurrentReturnType(BuiltInType type);
-    const output::CodeBuffer &getCodeBuffer() const
+    const ir::Module &getModule() const
+    {
+        return module;
+    }
+    std::size_t getFrameBytes() const
+    {
+        return frameBytes;
+    }
+    std::size_t getUnsharedFrameBytes() const
+    {
+        return unsharedFrameBytes;
+    }
+    const ir::PassStats &getPassStats() const
+    {
+        return passStats;
+    }
+    const std::vector<std::string> &getInlineReport() const
     {
-        return codeBuffer;
+        return inlineReport;
     }
 
     // Visitor methods
@@ -44,6 +126,7 @@ public:
     void visit(ast::Cast &node) override;
     void visit(ast::ExpList &node) override;
     void visit(ast::Call &node) override;
+    void visit(ast::CallStatement &node) override;
     void visit(ast::Statements &node) override;
     void visit(ast::Break &node) override;
     void visit(ast::Continue &node) override;
@@ -0,0 +1,66 @@
+#include "arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace ast
+{
+
+        Arena::Arena(std::size_t chunkSize)
+            : chunks(), current(nullptr), limit(nullptr), chunkSize(chunkSize),
+              usedBytes(0), reservedBytes(0), objects(0), finalizers(nullptr) {}
+
+        Arena::~Arena()
+        {
+                // Newest objects first, mirroring the order they were built in
+                for (Finalizer *f = finalizers; f != nullptr; f = f->next)
+                {
+                        f->destroy(f->object);
+                }
+                for (char *chunk : chunks)
+                {
+                        delete[] chunk;
+                }
+        }
+
+        void Arena::grow(std::size_t size, std::size_t align)
+        {
+                std::size_t bytes = std::max(chunkSize, size + align);
+                char *chunk = new char[bytes];
+                chunks.push_back(chunk);
+                current = chunk;
+                limit = chunk + bytes;
+                reservedBytes += bytes;
+        }
+
+        void *Arena::allocate(std::size_t size, std::size_t align)
+        {
+                auto address = reinterpret_cast<std::uintptr_t>(current);
+                std::size_t padding = (align - address % align) % align;
+                if (current == nullptr || padding + size > static_cast<std::size_t>(limit - current))
+                {
+                        grow(size, align);
+                        address = reinterpret_cast<std::uintptr_t>(current);
+                        padding = (align - address % align) % align;
+                }
+                char *result = current + padding;
+                current = result + size;
+                usedBytes += padding + size;
+                return result;
+        }
+
+        std::size_t Arena::bytesUsed() const
+        {
+                return usedBytes;
+        }
+
+        std::size_t Arena::bytesReserved() const
+        {
+                return reservedBytes;
+        }
+
+        std::size_t Arena::objectCount() const
+        {
+                return objects;
+        }
+
+}
@@ -0,0 +1,82 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ast
+{
+
+    /* Arena class
+     * Bump-pointer allocator that owns every AST node of one compilation.
+     * Nodes are never freed one by one: destroying the arena runs the
+     * pending destructors and releases all chunks in one shot.
+     */
+    class Arena
+    {
+    private:
+        // Destructor to run for an object living in the arena.
+        // The records themselves are allocated from the arena.
+        struct Finalizer
+        {
+            void *object;
+            void (*destroy)(void *);
+            Finalizer *next;
+        };
+
+        std::vector<char *> chunks;
+        char *current;
+        char *limit;
+        std::size_t chunkSize;
+        std::size_t usedBytes;
+        std::size_t reservedBytes;
+        std::size_t objects;
+        Finalizer *finalizers;
+
+        // Allocates a fresh chunk large enough for size bytes at the given alignment
+        void grow(std::size_t size, std::size_t align);
+
+    public:
+        explicit Arena(std::size_t chunkSize = 64 * 1024);
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        ~Arena();
+
+        // Returns uninitialized memory for size bytes at the given alignment
+        void *allocate(std::size_t size, std::size_t align);
+
+        // Constructs an object in the arena, the arena counterpart of std::make_shared
+        // Usage example:
+        //      auto id = arena.make<ast::ID>(yytext);
+        template <typename T, typename... Args>
+        T *make(Args &&...args)
+        {
+            T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if (!std::is_trivially_destructible<T>::value)
+            {
+                Finalizer *finalizer = new (allocate(sizeof(Finalizer), alignof(Finalizer)))
+                    Finalizer{object, [](void *p) { static_cast<T *>(p)->~T(); }, finalizers};
+                finalizers = finalizer;
+            }
+            objects++;
+            return object;
+        }
+
+        // Bytes handed out so far, including alignment padding
+        std::size_t bytesUsed() const;
+
+        // Bytes obtained from the system allocator
+        std::size_t bytesReserved() const;
+
+        // Number of objects constructed with make
+        std::size_t objectCount() const;
+    };
+
+}
+
+#endif // ARENA_HPP
@@ -0,0 +1,882 @@
+#include "arithmetic.hpp"
+#include "cfg.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                int width(Type type)
+                {
+                        switch (type)
+                        {
+                        case Type::I1:
+                                return 1;
+                        case Type::I8:
+                                return 8;
+                        case Type::I64:
+                                return 64;
+                        default:
+                                return 32;
+                        }
+                }
+
+                std::uint64_t mask(Type type)
+                {
+                        return type == Type::I64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width(type)) - 1;
+                }
+
+                // Bits of a constant of the type, zero extended
+                std::uint64_t bitsOf(Value value, Type type)
+                {
+                        return static_cast<std::uint64_t>(static_cast<std::int64_t>(value.id)) & mask(type);
+                }
+
+                std::int64_t signedOf(Value value, Type type)
+                {
+                        std::uint64_t bits = bitsOf(value, type);
+                        if (type != Type::I64 && (bits >> (width(type) - 1)) != 0)
+                        {
+                                bits |= ~mask(type);
+                        }
+                        return static_cast<std::int64_t>(bits);
+                }
+
+                // Bytes and bools hold their unsigned value, ints their signed
+                // one, the way the analyzer emits them
+                Value constantOf(std::uint64_t bits, Type type)
+                {
+                        bits &= mask(type);
+                        if (type == Type::I32)
+                        {
+                                return Value::constant(static_cast<std::int32_t>(static_cast<std::uint32_t>(bits)));
+                        }
+                        return Value::constant(static_cast<int>(bits));
+                }
+
+                bool isConstant(Value value)
+                {
+                        return value.kind == Value::Kind::CONSTANT;
+                }
+
+                // k for 2^k, -1 if bits is no power of two
+                int log2(std::uint64_t bits)
+                {
+                        if (bits == 0 || (bits & (bits - 1)) != 0)
+                        {
+                                return -1;
+                        }
+                        int k = 0;
+                        while (bits >>= 1)
+                        {
+                                ++k;
+                        }
+                        return k;
+                }
+
+                bool commutes(Opcode op)
+                {
+                        return op == Opcode::ADD || op == Opcode::MUL || op == Opcode::AND || op == Opcode::OR ||
+                               op == Opcode::XOR;
+                }
+
+                // The low bits of their result only depend on the low bits of their operands
+                bool truncates(Opcode op)
+                {
+                        return commutes(op) || op == Opcode::SUB;
+                }
+
+                // Instructions that only compute their result; unused, they can go
+                bool isPure(Opcode op)
+                {
+                        switch (op)
+                        {
+                        case Opcode::LOAD:
+                        case Opcode::ADD:
+                        case Opcode::SUB:
+                        case Opcode::MUL:
+                        case Opcode::SDIV:
+                        case Opcode::AND:
+                        case Opcode::OR:
+                        case Opcode::XOR:
+                        case Opcode::SHL:
+                        case Opcode::LSHR:
+                        case Opcode::ASHR:
+                        case Opcode::ICMP:
+                        case Opcode::ZEXT:
+                        case Opcode::SEXT:
+                        case Opcode::TRUNC:
+                        case Opcode::BITCAST:
+                        case Opcode::GEP:
+                        case Opcode::PHI:
+                                return true;
+                        default:
+                                return false;
+                        }
+                }
+
+                Predicate unsignedPredicate(Predicate predicate)
+                {
+                        switch (predicate)
+                        {
+                        case Predicate::SLT:
+                                return Predicate::ULT;
+                        case Predicate::SGT:
+                                return Predicate::UGT;
+                        case Predicate::SLE:
+                                return Predicate::ULE;
+                        case Predicate::SGE:
+                                return Predicate::UGE;
+                        default:
+                                return predicate;
+                        }
+                }
+
+                bool compare(Predicate predicate, Value lhs, Value rhs, Type type)
+                {
+                        std::int64_t a = signedOf(lhs, type);
+                        std::int64_t b = signedOf(rhs, type);
+                        std::uint64_t ua = bitsOf(lhs, type);
+                        std::uint64_t ub = bitsOf(rhs, type);
+                        switch (predicate)
+                        {
+                        case Predicate::EQ:
+                                return ua == ub;
+                        case Predicate::NE:
+                                return ua != ub;
+                        case Predicate::SLT:
+                                return a < b;
+                        case Predicate::SGT:
+                                return a > b;
+                        case Predicate::SLE:
+                                return a <= b;
+                        case Predicate::SGE:
+                                return a >= b;
+                        case Predicate::ULT:
+                                return ua < ub;
+                        case Predicate::UGT:
+                                return ua > ub;
+                        case Predicate::ULE:
+                                return ua <= ub;
+                        default:
+                                return ua >= ub;
+                        }
+                }
+
+                // Multiplier and shift that divide an int by d, at least 3,
+                // after Hacker's Delight 10-1: the quotient is the high word
+                // of x * multiplier shifted right by shift, plus one for a
+                // negative x. A multiplier above INT_MAX comes out negative,
+                // x is then added to the high word
+                struct Magic
+                {
+                        std::int32_t multiplier;
+                        int shift;
+                };
+
+                Magic magic(std::uint32_t d)
+                {
+                        const std::uint32_t two31 = 0x80000000u;
+                        std::uint32_t anc = two31 - 1 - two31 % d;
+                        std::uint32_t q1 = two31 / anc;
+                        std::uint32_t r1 = two31 - q1 * anc;
+                        std::uint32_t q2 = two31 / d;
+                        std::uint32_t r2 = two31 - q2 * d;
+                        std::uint32_t delta;
+                        int p = 31;
+                        do
+                        {
+                                ++p;
+                                q1 *= 2;
+                                r1 *= 2;
+                                if (r1 >= anc)
+                                {
+                                        ++q1;
+                                        r1 -= anc;
+                                }
+                                q2 *= 2;
+                                r2 *= 2;
+                                if (r2 >= d)
+                                {
+                                        ++q2;
+                                        r2 -= d;
+                                }
+                                delta = d - r2;
+                        } while (q1 < delta || (q1 == delta && r1 == 0));
+                        return Magic{static_cast<std::int32_t>(q2 + 1), p - 32};
+                }
+
+                // Where new instructions go: right before the one being simplified
+                struct Cursor
+                {
+                        Block *block;
+                        Instruction *previous;
+                };
+
+                /* ArithmeticSimplifier class
+                 * One walk over the blocks of a function, replacing the
+                 * results of the instructions it folds away by the values
+                 * they stand for.
+                 */
+                class ArithmeticSimplifier
+                {
+                private:
+                        Function &function;
+                        ArithmeticCounts counts;
+                        // By temporary: its defining instruction, and the value it was folded to
+                        std::vector<Instruction *> definitions;
+                        std::vector<Value> replacement;
+
+                        Value resolve(Value value) const
+                        {
+                                while (value.kind == Value::Kind::TEMP && !replacement[value.id].isNone())
+                                {
+                                        value = replacement[value.id];
+                                }
+                                return value;
+                        }
+
+                        Instruction *definition(Value value, Opcode op) const
+                        {
+                                if (value.kind != Value::Kind::TEMP || definitions[value.id] == nullptr ||
+                                    definitions[value.id]->op != op)
+                                {
+                                        return nullptr;
+                                }
+                                return definitions[value.id];
+                        }
+
+                        // Appends a new instruction at the cursor, its result a new temporary
+                        Value emit(Cursor &at, Opcode op, Type type, Value lhs, Value rhs)
+                        {
+                                Instruction *instruction = function.storage().make<Instruction>(op);
+                                instruction->type = type;
+                                instruction->lhs = lhs;
+                                instruction->rhs = rhs;
+                                instruction->result = Value::temp(function.tempCount++);
+                                definitions.push_back(instruction);
+                                replacement.push_back(Value());
+
+                                Instruction *&link = at.previous ? at.previous->next : at.block->first;
+                                instruction->next = link;
+                                link = instruction;
+                                at.previous = instruction;
+                                return instruction->result;
+                        }
+
+                        Value cast(Cursor &at, Opcode op, Type sourceType, Value value, Type type)
+                        {
+                                Value result = emit(at, op, type, value, Value());
+                                definitions[result.id]->sourceType = sourceType;
+                                return result;
+                        }
+
+                        // The instruction is removed; its uses read value instead
+                        bool replace(Instruction *instruction, Value value)
+                        {
+                                replacement[instruction->result.id] = value;
+                                definitions[instruction->result.id] = nullptr;
+                                ++counts.simplified;
+                                return true;
+                        }
+
+                        void rewrite(Instruction *instruction, Opcode op, Value lhs, Value rhs)
+                        {
+                                instruction->op = op;
+                                instruction->lhs = lhs;
+                                instruction->rhs = rhs;
+                        }
+
+                        bool fold(Instruction *instruction)
+                        {
+                                Type type = instruction->type;
+                                std::uint64_t a = bitsOf(instruction->lhs, type);
+                                std::uint64_t b = bitsOf(instruction->rhs, type);
+                                switch (instruction->op)
+                                {
+                                case Opcode::ADD:
+                                        return replace(instruction, constantOf(a + b, type));
+                                case Opcode::SUB:
+                                        return replace(instruction, constantOf(a - b, type));
+                                case Opcode::MUL:
+                                        return replace(instruction, constantOf(a * b, type));
+                                case Opcode::AND:
+                                        return replace(instruction, constantOf(a & b, type));
+                                case Opcode::OR:
+                                        return replace(instruction, constantOf(a | b, type));
+                                case Opcode::XOR:
+                                        return replace(instruction, constantOf(a ^ b, type));
+                                case Opcode::SDIV:
+                                {
+                                        // Division by zero never gets here, the overflowing one traps
+                                        std::int64_t x = signedOf(instruction->lhs, type);
+                                        std::int64_t y = signedOf(instruction->rhs, type);
+                                        if (y == 0 || (y == -1 && bitsOf(instruction->lhs, type) == (mask(type) >> 1) + 1))
+                                        {
+                                                return false;
+                                        }
+                                        return replace(instruction, constantOf(static_cast<std::uint64_t>(x / y), type));
+                                }
+                                default:
+                                        return false;
+                                }
+                        }
+
+                        // x / d by shifts for d = ±2^k, adding d - 1 to a negative x
+                        // first so it rounds toward zero like sdiv
+                        void divideByPowerOfTwo(Instruction *instruction, Cursor &at, int k, bool negative)
+                        {
+                                Type type = instruction->type;
+                                Value x = instruction->lhs;
+                                int bits = width(type);
+                                Value bias;
+                                if (k == 1)
+                                {
+                                        bias = emit(at, Opcode::LSHR, type, x, Value::constant(bits - 1));
+                                }
+                                else
+                                {
+                                        Value sign = emit(at, Opcode::ASHR, type, x, Value::constant(bits - 1));
+                                        bias = emit(at, Opcode::LSHR, type, sign, Value::constant(bits - k));
+                                }
+                                Value biased = emit(at, Opcode::ADD, type, x, bias);
+                                if (!negative)
+                                {
+                                        rewrite(instruction, Opcode::ASHR, biased, Value::constant(k));
+                                        return;
+                                }
+                                Value quotient = emit(at, Opcode::ASHR, type, biased, Value::constant(k));
+                                rewrite(instruction, Opcode::SUB, Value::constant(0), quotient);
+                        }
+
+                        // x / d for an int by the high word of a 64 bit product
+                        void divideByMultiplying(Instruction *instruction, Cursor &at, std::uint32_t d, bool negative)
+                        {
+                                Magic m = magic(d);
+                                Value x = instruction->lhs;
+                                Value wide = cast(at, Opcode::SEXT, Type::I32, x, Type::I64);
+                                Value product = emit(at, Opcode::MUL, Type::I64, wide, Value::constant(m.multiplier));
+                                Value quotient;
+                                if (m.multiplier >= 0)
+                                {
+                                        Value high = emit(at, Opcode::ASHR, Type::I64, product, Value::constant(32 + m.shift));
+                                        quotient = cast(at, Opcode::TRUNC, Type::I64, high, Type::I32);
+                                }
+                                else
+                                {
+                                        Value high = emit(at, Opcode::ASHR, Type::I64, product, Value::constant(32));
+                                        high = cast(at, Opcode::TRUNC, Type::I64, high, Type::I32);
+                                        quotient = emit(at, Opcode::ADD, Type::I32, high, x);
+                                        if (m.shift > 0)
+                                        {
+                                                quotient = emit(at, Opcode::ASHR, Type::I32, quotient, Value::constant(m.shift));
+                                        }
+                                }
+                                Value sign = emit(at, Opcode::LSHR, Type::I32, x, Value::constant(31));
+                                if (!negative)
+                                {
+                                        rewrite(instruction, Opcode::ADD, quotient, sign);
+                                        return;
+                                }
+                                quotient = emit(at, Opcode::ADD, Type::I32, quotient, sign);
+                                rewrite(instruction, Opcode::SUB, Value::constant(0), quotient);
+                        }
+
+                        // Bytes divide as signed i8 too; only their powers of two get shifts
+                        bool divide(Instruction *instruction, Cursor &at)
+                        {
+                                Type type = instruction->type;
+                                std::int64_t d = signedOf(instruction->rhs, type);
+                                if (d == 1)
+                                {
+                                        return replace(instruction, instruction->lhs);
+                                }
+                                std::uint64_t magnitude = d < 0 ? -static_cast<std::uint64_t>(d) : d;
+                                int k = log2(magnitude);
+                                if (d == 0 || d == -1 || k == width(type) - 1)
+                                {
+                                        return false;
+                                }
+                                if (k > 0)
+                                {
+                                        divideByPowerOfTwo(instruction, at, k, d < 0);
+                                }
+                                else if (type == Type::I32)
+                                {
+                                        divideByMultiplying(instruction, at, static_cast<std::uint32_t>(magnitude), d < 0);
+                                }
+                                else
+                                {
+                                        return false;
+                                }
+                                ++counts.reduced;
+                                return false;
+                        }
+
+                        bool simplifyBinary(Instruction *instruction, Cursor &at)
+                        {
+                                Type type = instruction->type;
+                                if (type == Type::I64)
+                                {
+                                        return false;
+                                }
+                                if (isConstant(instruction->lhs) && isConstant(instruction->rhs))
+                                {
+                                        return fold(instruction);
+                                }
+                                if (commutes(instruction->op) && isConstant(instruction->lhs))
+                                {
+                                        std::swap(instruction->lhs, instruction->rhs);
+                                }
+                                Value x = instruction->lhs;
+                                Value y = instruction->rhs;
+
+                                if (x == y && !isConstant(x))
+                                {
+                                        switch (instruction->op)
+                                        {
+                                        case Opcode::SUB:
+                                        case Opcode::XOR:
+                                                return replace(instruction, Value::constant(0));
+                                        case Opcode::AND:
+                                        case Opcode::OR:
+                                                return replace(instruction, x);
+                                        default:
+                                                return false;
+                                        }
+                                }
+                                if (!isConstant(y))
+                                {
+                                        return false;
+                                }
+
+                                std::uint64_t c = bitsOf(y, type);
+                                switch (instruction->op)
+                                {
+                                case Opcode::SUB:
+                                        // x - c is x + -c, which the next add can absorb
+                                        instruction->op = Opcode::ADD;
+                                        instruction->rhs = constantOf(0 - c, type);
+                                        return simplifyBinary(instruction, at);
+                                case Opcode::ADD:
+                                {
+                                        if (c == 0)
+                                        {
+                                                return replace(instruction, x);
+                                        }
+                                        Instruction *inner = definition(x, Opcode::ADD);
+                                        if (inner != nullptr && isConstant(inner->rhs) && inner->type == type)
+                                        {
+                                                instruction->lhs = inner->lhs;
+                                                instruction->rhs = constantOf(c + bitsOf(inner->rhs, type), type);
+                                                ++counts.simplified;
+                                                return simplifyBinary(instruction, at);
+                                        }
+                                        return false;
+                                }
+                                case Opcode::MUL:
+                                {
+                                        if (c == 0)
+                                        {
+                                                return replace(instruction, constantOf(0, type));
+                                        }
+                                        if (c == 1)
+                                        {
+                                                return replace(instruction, x);
+                                        }
+                                        if (c == mask(type))
+                                        {
+                                                rewrite(instruction, Opcode::SUB, Value::constant(0), x);
+                                                ++counts.reduced;
+                                                return false;
+                                        }
+                                        int k = log2(c);
+                                        if (k > 0)
+                                        {
+                                                instruction->op = Opcode::SHL;
+                                                instruction->rhs = Value::constant(k);
+                                                ++counts.reduced;
+                                        }
+                                        return false;
+                                }
+                                case Opcode::SDIV:
+                                        return divide(instruction, at);
+                                case Opcode::AND:
+                                        if (c == 0)
+                                        {
+                                                return replace(instruction, constantOf(0, type));
+                                        }
+                                        return c == mask(type) && replace(instruction, x);
+                                case Opcode::OR:
+                                        if (c == mask(type))
+                                        {
+                                                return replace(instruction, y);
+                                        }
+                                        return c == 0 && replace(instruction, x);
+                                case Opcode::XOR:
+                                        return c == 0 && replace(instruction, x);
+                                default:
+                                        return false;
+                                }
+                        }
+
+                        // The byte a zext of type narrow widened, or a constant that fits in narrow
+                        Value narrowed(Value value, Type type, Type narrow) const
+                        {
+                                if (isConstant(value))
+                                {
+                                        return constantOf(bitsOf(value, type), narrow);
+                                }
+                                Instruction *extension = definition(value, Opcode::ZEXT);
+                                return extension && extension->sourceType == narrow ? extension->lhs : Value();
+                        }
+
+                        // i64 constants do not fit a Value, so a division sequence whose
+                        // dividend became constant later is evaluated at its trunc
+                        bool evaluateWide(Value value, std::int64_t &result) const
+                        {
+                                if (isConstant(value))
+                                {
+                                        result = value.id;
+                                        return true;
+                                }
+                                if (value.kind != Value::Kind::TEMP || definitions[value.id] == nullptr)
+                                {
+                                        return false;
+                                }
+                                Instruction *instruction = definitions[value.id];
+                                if (instruction->op == Opcode::SEXT)
+                                {
+                                        if (!isConstant(instruction->lhs))
+                                        {
+                                                return false;
+                                        }
+                                        result = signedOf(instruction->lhs, instruction->sourceType);
+                                        return true;
+                                }
+                                std::int64_t a, b;
+                                if (instruction->type != Type::I64 || !evaluateWide(instruction->lhs, a) ||
+                                    !evaluateWide(instruction->rhs, b))
+                                {
+                                        return false;
+                                }
+                                std::uint64_t ua = static_cast<std::uint64_t>(a);
+                                std::uint64_t ub = static_cast<std::uint64_t>(b);
+                                switch (instruction->op)
+                                {
+                                case Opcode::ADD:
+                                        result = static_cast<std::int64_t>(ua + ub);
+                                        return true;
+                                case Opcode::MUL:
+                                        result = static_cast<std::int64_t>(ua * ub);
+                                        return true;
+                                case Opcode::ASHR:
+                                        result = a >> (b & 63);
+                                        return true;
+                                default:
+                                        return false;
+                                }
+                        }
+
+                        bool simplifyCast(Instruction *instruction)
+                        {
+                                Type source = instruction->sourceType;
+                                Type type = instruction->type;
+                                Value x = instruction->lhs;
+                                if (isConstant(x))
+                                {
+                                        std::uint64_t bits = instruction->op == Opcode::SEXT
+                                                                 ? static_cast<std::uint64_t>(signedOf(x, source))
+                                                                 : bitsOf(x, source);
+                                        return replace(instruction, constantOf(bits, type));
+                                }
+                                if (instruction->op == Opcode::SEXT)
+                                {
+                                        return false;
+                                }
+
+                                if (x.kind != Value::Kind::TEMP || definitions[x.id] == nullptr)
+                                {
+                                        return false;
+                                }
+                                std::int64_t wide;
+                                if (source == Type::I64 && evaluateWide(x, wide))
+                                {
+                                        return replace(instruction, constantOf(static_cast<std::uint64_t>(wide), type));
+                                }
+                                Instruction *inner = definitions[x.id];
+                                if (instruction->op == Opcode::ZEXT)
+                                {
+                                        // zext (zext x) is one zext, zext (trunc x) to the type of x keeps its low bits
+                                        if (inner->op == Opcode::ZEXT)
+                                        {
+                                                instruction->sourceType = inner->sourceType;
+                                                instruction->lhs = inner->lhs;
+                                                ++counts.simplified;
+                                        }
+                                        else if (inner->op == Opcode::TRUNC && inner->sourceType == type)
+                                        {
+                                                rewrite(instruction, Opcode::AND, inner->lhs, constantOf(mask(source), type));
+                                                instruction->sourceType = Type::VOID;
+                                                ++counts.simplified;
+                                        }
+                                        return false;
+                                }
+
+                                if (inner->op == Opcode::ZEXT || inner->op == Opcode::TRUNC)
+                                {
+                                        Type original = inner->sourceType;
+                                        if (original == type)
+                                        {
+                                                return replace(instruction, inner->lhs);
+                                        }
+                                        if (inner->op == Opcode::ZEXT && width(original) < width(type))
+                                        {
+                                                instruction->op = Opcode::ZEXT;
+                                        }
+                                        instruction->sourceType = original;
+                                        instruction->lhs = inner->lhs;
+                                        ++counts.simplified;
+                                        return false;
+                                }
+
+                                // Arithmetic on widened bytes, truncated back, is byte arithmetic
+                                if (truncates(inner->op) && inner->type == source)
+                                {
+                                        Value lhs = narrowed(inner->lhs, source, type);
+                                        Value rhs = narrowed(inner->rhs, source, type);
+                                        if (!lhs.isNone() && !rhs.isNone())
+                                        {
+                                                rewrite(instruction, inner->op, lhs, rhs);
+                                                instruction->sourceType = Type::VOID;
+                                                ++counts.simplified;
+                                        }
+                                }
+                                return false;
+                        }
+
+                        bool simplifyCompare(Instruction *instruction)
+                        {
+                                Type type = instruction->type;
+                                Value x = instruction->lhs;
+                                Value y = instruction->rhs;
+                                if (isConstant(x) && isConstant(y))
+                                {
+                                        return replace(instruction, Value::constant(compare(instruction->predicate, x, y, type)));
+                                }
+                                if (x == y && !isConstant(x))
+                                {
+                                        Value any = Value::constant(0);
+                                        return replace(instruction, Value::constant(compare(instruction->predicate, any, any, type)));
+                                }
+
+                                // Zero extended values compare like the bytes they extend, unsigned
+                                Instruction *extension = definition(x, Opcode::ZEXT);
+                                if (extension == nullptr)
+                                {
+                                        extension = definition(y, Opcode::ZEXT);
+                                }
+                                if (extension == nullptr)
+                                {
+                                        return false;
+                                }
+                                Type narrow = extension->sourceType;
+                                Value lhs = narrowed(x, type, narrow);
+                                Value rhs = narrowed(y, type, narrow);
+                                for (Value value : {x, y})
+                                {
+                                        if (isConstant(value) && bitsOf(value, type) > mask(narrow))
+                                        {
+                                                return false;
+                                        }
+                                }
+                                if (lhs.isNone() || rhs.isNone())
+                                {
+                                        return false;
+                                }
+                                instruction->predicate = unsignedPredicate(instruction->predicate);
+                                instruction->type = narrow;
+                                instruction->lhs = lhs;
+                                instruction->rhs = rhs;
+                                ++counts.simplified;
+                                return false;
+                        }
+
+                        // A phi whose incoming values all agree, or are the phi itself
+                        bool simplifyPhi(Instruction *instruction)
+                        {
+                                Value same;
+                                for (int k = 0; k < instruction->incomingCount; ++k)
+                                {
+                                        Value value = instruction->incoming[k].value;
+                                        if (value == instruction->result || value == same)
+                                        {
+                                                continue;
+                                        }
+                                        if (!same.isNone())
+                                        {
+                                                return false;
+                                        }
+                                        same = value;
+                                }
+                                return !same.isNone() && replace(instruction, same);
+                        }
+
+                        // Whether the instruction is gone, its uses left to read its replacement
+                        bool simplify(Instruction *instruction, Cursor &at)
+                        {
+                                switch (instruction->op)
+                                {
+                                case Opcode::ADD:
+                                case Opcode::SUB:
+                                case Opcode::MUL:
+                                case Opcode::SDIV:
+                                case Opcode::AND:
+                                case Opcode::OR:
+                                case Opcode::XOR:
+                                        return simplifyBinary(instruction, at);
+                                case Opcode::ZEXT:
+                                case Opcode::SEXT:
+                                case Opcode::TRUNC:
+                                        return simplifyCast(instruction);
+                                case Opcode::ICMP:
+                                        return simplifyCompare(instruction);
+                                case Opcode::PHI:
+                                        return simplifyPhi(instruction);
+                                default:
+                                        return false;
+                                }
+                        }
+
+                        void removeDeadCode()
+                        {
+                                std::vector<int> uses(function.tempCount, 0);
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                i->forEachOperand([&](Value &operand) {
+                                                        if (operand.kind == Value::Kind::TEMP)
+                                                        {
+                                                                ++uses[operand.id];
+                                                        }
+                                                });
+                                        }
+                                }
+
+                                // Backwards, so a chain of dead instructions goes in one sweep
+                                bool changed = true;
+                                while (changed)
+                                {
+                                        changed = false;
+                                        for (auto b = function.blocks.rbegin(); b != function.blocks.rend(); ++b)
+                                        {
+                                                Block *block = *b;
+                                                std::vector<Instruction *> instructions;
+                                                for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                                {
+                                                        instructions.push_back(i);
+                                                }
+                                                for (auto i = instructions.rbegin(); i != instructions.rend(); ++i)
+                                                {
+                                                        Instruction *instruction = *i;
+                                                        if (!isPure(instruction->op) || instruction->result.kind != Value::Kind::TEMP ||
+                                                            uses[instruction->result.id] > 0)
+                                                        {
+                                                                continue;
+                                                        }
+                                                        instruction->forEachOperand([&](Value &operand) {
+                                                                if (operand.kind == Value::Kind::TEMP)
+                                                                {
+                                                                        --uses[operand.id];
+                                                                }
+                                                        });
+                                                        // Marks it, unlinked below
+                                                        instruction->result = Value();
+                                                        ++counts.removed;
+                                                        changed = true;
+                                                }
+                                                Instruction *previous = nullptr;
+                                                for (Instruction *instruction : instructions)
+                                                {
+                                                        if (instruction->result.isNone() && isPure(instruction->op))
+                                                        {
+                                                                continue;
+                                                        }
+                                                        (previous ? previous->next : block->first) = instruction;
+                                                        previous = instruction;
+                                                }
+                                                (previous ? previous->next : block->first) = nullptr;
+                                                block->last = previous;
+                                        }
+                                }
+                        }
+
+                public:
+                        explicit ArithmeticSimplifier(Function &function) : function(function) {}
+
+                        ArithmeticCounts run()
+                        {
+                                definitions.assign(function.tempCount, nullptr);
+                                replacement.assign(function.tempCount, Value());
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                if (i->result.kind == Value::Kind::TEMP)
+                                                {
+                                                        definitions[i->result.id] = i;
+                                                }
+                                        }
+                                }
+
+                                // Definitions before uses, so a phi folded to a constant is seen as one
+                                DominatorTree tree(function);
+                                for (Block *block : tree.order())
+                                {
+                                        Cursor at{block, nullptr};
+                                        for (Instruction *i = block->first; i != nullptr;)
+                                        {
+                                                Instruction *next = i->next;
+                                                i->forEachOperand([&](Value &operand) { operand = resolve(operand); });
+                                                if (simplify(i, at))
+                                                {
+                                                        (at.previous ? at.previous->next : block->first) = next;
+                                                        if (block->last == i)
+                                                        {
+                                                                block->last = at.previous;
+                                                        }
+                                                }
+                                                else
+                                                {
+                                                        at.previous = i;
+                                                }
+                                                i = next;
+                                        }
+                                }
+
+                                // Phis read values of blocks laid out after them
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                i->forEachOperand([&](Value &operand) { operand = resolve(operand); });
+                                        }
+                                }
+                                removeDeadCode();
+                                return counts;
+                        }
+                };
+
+        }
+
+        ArithmeticCounts simplifyArithmetic(Function &function)
+        {
+                return ArithmeticSimplifier(function).run();
+        }
+
+}
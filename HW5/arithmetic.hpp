@@ -0,0 +1,28 @@
+#ifndef ARITHMETIC_HPP
+#define ARITHMETIC_HPP
+
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // What simplifyArithmetic did to one function
+    struct ArithmeticCounts
+    {
+        int simplified = 0;
+        int reduced = 0;
+        int removed = 0;
+    };
+
+    // Folds instructions on constants and identities such as x * 1, x + 0 and
+    // x - x, merges chains of zext and trunc, and narrows compares and
+    // truncated arithmetic of zero extended bytes back to bytes. Strength
+    // reduces multiplications by a power of two to shifts and divisions by a
+    // constant to shifts, or for ints to a multiplication by its inverse,
+    // rounding toward zero like sdiv. Finally removes the instructions no
+    // longer used
+    ArithmeticCounts simplifyArithmetic(Function &function);
+
+}
+
+#endif // ARITHMETIC_HPP
@@ -0,0 +1,1644 @@
+#include "asmPrinter.hpp"
+#include "linearScan.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                enum Register
+                {
+                        RAX,
+                        RCX,
+                        RDX,
+                        RBX,
+                        RSP,
+                        RBP,
+                        RSI,
+                        RDI,
+                        R8,
+                        R9,
+                        R10,
+                        R11,
+                        R12,
+                        R13,
+                        R14,
+                        R15
+                };
+
+                const char *const quadNames[] = {"%rax", "%rcx", "%rdx", "%rbx", "%rsp", "%rbp", "%rsi", "%rdi",
+                                                 "%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"};
+                const char *const longNames[] = {"%eax", "%ecx", "%edx", "%ebx", "%esp", "%ebp", "%esi", "%edi",
+                                                 "%r8d", "%r9d", "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d"};
+                const char *const byteNames[] = {"%al", "%cl", "%dl", "%bl", "%spl", "%bpl", "%sil", "%dil",
+                                                 "%r8b", "%r9b", "%r10b", "%r11b", "%r12b", "%r13b", "%r14b", "%r15b"};
+
+                // Registers the allocator hands out, those a call clobbers first. rax,
+                // rcx, rdx and r11 are left as scratch for division, shifts, addresses
+                // and values that live on the stack
+                const Register allocatable[] = {RSI, RDI, R8, R9, R10, RBX, R12, R13, R14, R15};
+                const int allocatableCount = 10;
+                const int preservedCount = 5;
+
+                const Register argumentRegisters[] = {RDI, RSI, RDX, RCX, R8, R9};
+                const int registerArguments = 6;
+
+                static const char runtime[] =
+                    "\t.globl\t_start\n"
+                    "_start:\n"
+                    "\txorl\t%ebp, %ebp\n"
+                    "\tcall\tmain\n"
+                    "\txorl\t%edi, %edi\n"
+                    "\tcall\texit\n"
+                    "\n"
+                    // Writes out and empties the output buffer
+                    ".Lflush:\n"
+                    "\tmovq\t.Lout_length(%rip), %rdx\n"
+                    "\tleaq\t.Lout_buffer(%rip), %rsi\n"
+                    ".Lflush_loop:\n"
+                    "\ttestq\t%rdx, %rdx\n"
+                    "\tjle\t.Lflush_done\n"
+                    "\tmovl\t$1, %edi\n"
+                    "\tmovl\t$1, %eax\n"
+                    "\tsyscall\n"
+                    "\ttestq\t%rax, %rax\n"
+                    "\tjle\t.Lflush_done\n"
+                    "\taddq\t%rax, %rsi\n"
+                    "\tsubq\t%rax, %rdx\n"
+                    "\tjmp\t.Lflush_loop\n"
+                    ".Lflush_done:\n"
+                    "\tmovq\t$0, .Lout_length(%rip)\n"
+                    "\tret\n"
+                    "\n"
+                    "\t.globl\texit\n"
+                    "exit:\n"
+                    "\tpushq\t%rdi\n"
+                    "\tcall\t.Lflush\n"
+                    "\tpopq\t%rdi\n"
+                    "\tmovl\t$231, %eax\n"
+                    "\tsyscall\n"
+                    "\n"
+                    // The string and a newline, like printf("%s\n")
+                    "\t.globl\tprint\n"
+                    "print:\n"
+                    "\tmovq\t.Lout_length(%rip), %rcx\n"
+                    ".Lprint_next:\n"
+                    "\tmovzbl\t(%rdi), %eax\n"
+                    "\ttestl\t%eax, %eax\n"
+                    "\tjne\t.Lprint_char\n"
+                    "\tmovl\t$10, %eax\n"
+                    "\txorl\t%edi, %edi\n"
+                    ".Lprint_char:\n"
+                    "\tcmpq\t$65536, %rcx\n"
+                    "\tjb\t.Lprint_store\n"
+                    "\tmovq\t%rcx, .Lout_length(%rip)\n"
+                    "\tpushq\t%rax\n"
+                    "\tpushq\t%rdi\n"
+                    "\tcall\t.Lflush\n"
+                    "\tpopq\t%rdi\n"
+                    "\tpopq\t%rax\n"
+                    "\txorl\t%ecx, %ecx\n"
+                    ".Lprint_store:\n"
+                    "\tleaq\t.Lout_buffer(%rip), %rdx\n"
+                    "\tmovb\t%al, (%rdx,%rcx)\n"
+                    "\tincq\t%rcx\n"
+                    "\ttestq\t%rdi, %rdi\n"
+                    "\tje\t.Lprint_done\n"
+                    "\tincq\t%rdi\n"
+                    "\tjmp\t.Lprint_next\n"
+                    ".Lprint_done:\n"
+                    "\tmovq\t%rcx, .Lout_length(%rip)\n"
+                    "\tret\n"
+                    "\n"
+                    // The number and a newline, like printf("%d\n"). The digits are
+                    // made backwards in the red zone, then copied
+                    "\t.globl\tprinti\n"
+                    "printi:\n"
+                    "\tmovq\t.Lout_length(%rip), %rcx\n"
+                    "\tcmpq\t$65520, %rcx\n"
+                    "\tjbe\t.Lprinti_room\n"
+                    "\tpushq\t%rdi\n"
+                    "\tcall\t.Lflush\n"
+                    "\tpopq\t%rdi\n"
+                    "\txorl\t%ecx, %ecx\n"
+                    ".Lprinti_room:\n"
+                    "\tleaq\t.Lout_buffer(%rip), %rsi\n"
+                    "\taddq\t%rcx, %rsi\n"
+                    "\tmovl\t%edi, %eax\n"
+                    "\ttestl\t%eax, %eax\n"
+                    "\tjns\t.Lprinti_digits\n"
+                    "\tmovb\t$45, (%rsi)\n"
+                    "\tincq\t%rsi\n"
+                    "\tnegl\t%eax\n"
+                    ".Lprinti_digits:\n"
+                    "\tmovq\t%rsp, %r8\n"
+                    "\tmovl\t$10, %r9d\n"
+                    ".Lprinti_digit:\n"
+                    "\txorl\t%edx, %edx\n"
+                    "\tdivl\t%r9d\n"
+                    "\taddl\t$48, %edx\n"
+                    "\tdecq\t%r8\n"
+                    "\tmovb\t%dl, (%r8)\n"
+                    "\ttestl\t%eax, %eax\n"
+                    "\tjne\t.Lprinti_digit\n"
+                    ".Lprinti_copy:\n"
+                    "\tmovb\t(%r8), %al\n"
+                    "\tmovb\t%al, (%rsi)\n"
+                    "\tincq\t%rsi\n"
+                    "\tincq\t%r8\n"
+                    "\tcmpq\t%rsp, %r8\n"
+                    "\tjb\t.Lprinti_copy\n"
+                    "\tmovb\t$10, (%rsi)\n"
+                    "\tincq\t%rsi\n"
+                    "\tleaq\t.Lout_buffer(%rip), %rax\n"
+                    "\tsubq\t%rax, %rsi\n"
+                    "\tmovq\t%rsi, .Lout_length(%rip)\n"
+                    "\tret\n"
+                    "\n"
+                    // Next input byte in eax without consuming it, -1 at the end
+                    ".Lpeek:\n"
+                    "\tmovq\t.Lin_position(%rip), %rcx\n"
+                    "\tcmpq\t.Lin_length(%rip), %rcx\n"
+                    "\tjb\t.Lpeek_byte\n"
+                    "\txorl\t%eax, %eax\n"
+                    "\txorl\t%edi, %edi\n"
+                    "\tleaq\t.Lin_buffer(%rip), %rsi\n"
+                    "\tmovl\t$65536, %edx\n"
+                    "\tsyscall\n"
+                    "\ttestq\t%rax, %rax\n"
+                    "\tjg\t.Lpeek_read\n"
+                    "\tmovl\t$-1, %eax\n"
+                    "\tret\n"
+                    ".Lpeek_read:\n"
+                    "\tmovq\t%rax, .Lin_length(%rip)\n"
+                    "\txorl\t%ecx, %ecx\n"
+                    "\tmovq\t%rcx, .Lin_position(%rip)\n"
+                    ".Lpeek_byte:\n"
+                    "\tleaq\t.Lin_buffer(%rip), %rax\n"
+                    "\tmovzbl\t(%rax,%rcx), %eax\n"
+                    "\tret\n"
+                    "\n"
+                    // A decimal number after white space, like scanf("%d"); 0 if there is none
+                    "\t.globl\treadi\n"
+                    "readi:\n"
+                    "\txorl\t%r8d, %r8d\n"
+                    "\txorl\t%r9d, %r9d\n"
+                    ".Lreadi_space:\n"
+                    "\tcall\t.Lpeek\n"
+                    "\tcmpl\t$32, %eax\n"
+                    "\tje\t.Lreadi_skip\n"
+                    "\tleal\t-9(%rax), %edx\n"
+                    "\tcmpl\t$4, %edx\n"
+                    "\tja\t.Lreadi_sign\n"
+                    ".Lreadi_skip:\n"
+                    "\tincq\t.Lin_position(%rip)\n"
+                    "\tjmp\t.Lreadi_space\n"
+                    ".Lreadi_sign:\n"
+                    "\tcmpl\t$43, %eax\n"
+                    "\tje\t.Lreadi_signed\n"
+                    "\tcmpl\t$45, %eax\n"
+                    "\tjne\t.Lreadi_digit\n"
+                    "\tmovl\t$1, %r9d\n"
+                    ".Lreadi_signed:\n"
+                    "\tincq\t.Lin_position(%rip)\n"
+                    ".Lreadi_digit:\n"
+                    "\tcall\t.Lpeek\n"
+                    "\tsubl\t$48, %eax\n"
+                    "\tcmpl\t$9, %eax\n"
+                    "\tja\t.Lreadi_done\n"
+                    "\timull\t$10, %r8d, %r8d\n"
+                    "\taddl\t%eax, %r8d\n"
+                    "\tincq\t.Lin_position(%rip)\n"
+                    "\tjmp\t.Lreadi_digit\n"
+                    ".Lreadi_done:\n"
+                    "\tmovl\t%r8d, %eax\n"
+                    "\ttestl\t%r9d, %r9d\n"
+                    "\tje\t.Lreadi_positive\n"
+                    "\tnegl\t%eax\n"
+                    ".Lreadi_positive:\n"
+                    "\tret\n"
+                    "\n"
+                    "\t.globl\tmemset\n"
+                    "memset:\n"
+                    "\tmovq\t%rdi, %r8\n"
+                    "\tmovl\t%edx, %ecx\n"
+                    "\tmovl\t%esi, %eax\n"
+                    "\trep stosb\n"
+                    "\tmovq\t%r8, %rax\n"
+                    "\tret\n"
+                    "\n"
+                    "\t.bss\n"
+                    "\t.p2align\t4\n"
+                    ".Lout_length:\n"
+                    "\t.zero\t8\n"
+                    ".Lin_position:\n"
+                    "\t.zero\t8\n"
+                    ".Lin_length:\n"
+                    "\t.zero\t8\n"
+                    "\t.p2align\t4\n"
+                    ".Lout_buffer:\n"
+                    "\t.zero\t65536\n"
+                    ".Lin_buffer:\n"
+                    "\t.zero\t65536\n"
+                    "\t.section\t.note.GNU-stack,\"\",@progbits\n";
+
+                // Operand size: a byte for bools and bytes, else 32 or 64 bits
+                enum class Width
+                {
+                        BYTE,
+                        LONG,
+                        QUAD
+                };
+
+                Width widthOf(Type type)
+                {
+                        switch (type)
+                        {
+                        case Type::I1:
+                        case Type::I8:
+                                return Width::BYTE;
+                        case Type::I32:
+                                return Width::LONG;
+                        default:
+                                return Width::QUAD;
+                        }
+                }
+
+                // Arithmetic on bools and bytes is done on 32 bits, of which only
+                // the low ones count
+                Width arithmeticWidth(Type type)
+                {
+                        return widthOf(type) == Width::QUAD ? Width::QUAD : Width::LONG;
+                }
+
+                int sizeOf(Type type)
+                {
+                        switch (type)
+                        {
+                        case Type::I32:
+                                return 4;
+                        case Type::I64:
+                        case Type::I8_PTR:
+                                return 8;
+                        default:
+                                return 1;
+                        }
+                }
+
+                int alignUp(int value, int alignment)
+                {
+                        return (value + alignment - 1) / alignment * alignment;
+                }
+
+                /* Place class
+                 * Where an operand is at run time: a register, a slot of the
+                 * frame, an immediate, or an address, of the frame or of a string,
+                 * that has to be computed with lea.
+                 */
+                struct Place
+                {
+                        enum class Kind
+                        {
+                                NONE,
+                                REGISTER,
+                                STACK,
+                                IMMEDIATE,
+                                FRAME,
+                                STRING
+                        };
+
+                        Kind kind = Kind::NONE;
+                        // Register, offset from rbp, value, or number of the string
+                        int number = 0;
+
+                        static Place reg(int reg) { return Place{Kind::REGISTER, reg}; }
+
+                        static Place stack(int offset) { return Place{Kind::STACK, offset}; }
+
+                        static Place immediate(int value) { return Place{Kind::IMMEDIATE, value}; }
+
+                        static Place frame(int offset) { return Place{Kind::FRAME, offset}; }
+
+                        static Place string(int id) { return Place{Kind::STRING, id}; }
+
+                        bool is(Kind other) const { return kind == other; }
+
+                        bool operator==(const Place &other) const { return kind == other.kind && number == other.number; }
+                };
+
+                // base + offset + index * scale, or a string relative to rip
+                struct Memory
+                {
+                        int base = RBP;
+                        int offset = 0;
+                        int index = -1;
+                        int scale = 1;
+                        int string = -1;
+                };
+
+                // One of the moves parallelMove does at once
+                struct Move
+                {
+                        Place destination;
+                        Place source;
+                        Type type;
+                };
+
+                const char *conditionCode(Predicate predicate)
+                {
+                        switch (predicate)
+                        {
+                        case Predicate::EQ:
+                                return "e";
+                        case Predicate::NE:
+                                return "ne";
+                        case Predicate::SLT:
+                                return "l";
+                        case Predicate::SGT:
+                                return "g";
+                        case Predicate::SLE:
+                                return "le";
+                        case Predicate::SGE:
+                                return "ge";
+                        case Predicate::ULT:
+                                return "b";
+                        case Predicate::UGT:
+                                return "a";
+                        case Predicate::ULE:
+                                return "be";
+                        default:
+                                return "ae";
+                        }
+                }
+
+                Predicate negated(Predicate predicate)
+                {
+                        switch (predicate)
+                        {
+                        case Predicate::EQ:
+                                return Predicate::NE;
+                        case Predicate::NE:
+                                return Predicate::EQ;
+                        case Predicate::SLT:
+                                return Predicate::SGE;
+                        case Predicate::SGT:
+                                return Predicate::SLE;
+                        case Predicate::SLE:
+                                return Predicate::SGT;
+                        case Predicate::SGE:
+                                return Predicate::SLT;
+                        case Predicate::ULT:
+                                return Predicate::UGE;
+                        case Predicate::UGT:
+                                return Predicate::ULE;
+                        case Predicate::ULE:
+                                return Predicate::UGT;
+                        default:
+                                return Predicate::ULT;
+                        }
+                }
+
+                // The predicate with its operands swapped
+                Predicate swapped(Predicate predicate)
+                {
+                        switch (predicate)
+                        {
+                        case Predicate::SLT:
+                                return Predicate::SGT;
+                        case Predicate::SGT:
+                                return Predicate::SLT;
+                        case Predicate::SLE:
+                                return Predicate::SGE;
+                        case Predicate::SGE:
+                                return Predicate::SLE;
+                        case Predicate::ULT:
+                                return Predicate::UGT;
+                        case Predicate::UGT:
+                                return Predicate::ULT;
+                        case Predicate::ULE:
+                                return Predicate::UGE;
+                        case Predicate::UGE:
+                                return Predicate::ULE;
+                        default:
+                                return predicate;
+                        }
+                }
+
+                /* FunctionEmitter class
+                 * Emits one function. Stack slots become rbp relative addresses
+                 * folded into the instructions that use them, and so do constant
+                 * indices into them; a compare right before the branch on it
+                 * becomes the flags of a jump, and an element address used right
+                 * after it the address operand of the load or store. Every other
+                 * value gets a register or a stack slot from allocateRegisters.
+                 * Phis become moves on the edges into their block; an edge from a
+                 * conditional branch gets a block of its own for them, after the
+                 * function, unless it falls through.
+                 */
+                class FunctionEmitter
+                {
+                private:
+                    const Function &function;
+                    output::ChunkBuffer &out;
+                    // Number of the function in the module, part of its labels
+                    int number;
+                    // Pool number of each string of the function
+                    const std::vector<int> &globals;
+
+                    std::vector<Instruction *> definitions;
+                    std::vector<int> useCounts;
+                    // Stack addresses standing for temporaries, and the other temporaries
+                    // the instructions that use them compute on the spot
+                    std::vector<Place> aliases;
+                    std::vector<bool> inlined;
+                    Allocation allocation;
+                    std::unordered_map<const Block *, int> layout;
+                    // Bytes of the allocas, where the spill slots start
+                    int allocaBytes = 0;
+                    int frameSize = 0;
+                    // Preserved registers the function uses, with their save slots
+                    std::vector<std::pair<int, int>> saved;
+                    // Edges whose phi moves are emitted after the function
+                    std::vector<std::pair<const Block *, const Block *>> edges;
+
+                    // Output helpers
+
+                    void instruction(const char *mnemonic)
+                    {
+                            out.append('\t');
+                            out.append(mnemonic);
+                            out.append('\t');
+                    }
+
+                    void instruction(const char *mnemonic, Width width)
+                    {
+                            out.append('\t');
+                            out.append(mnemonic);
+                            out.append(width == Width::BYTE ? 'b' : width == Width::LONG ? 'l' : 'q');
+                            out.append('\t');
+                    }
+
+                    void comma()
+                    {
+                            out.append(", ");
+                    }
+
+                    void end()
+                    {
+                            out.append('\n');
+                    }
+
+                    void reg(int reg, Width width)
+                    {
+                            out.append(width == Width::BYTE   ? byteNames[reg]
+                                       : width == Width::LONG ? longNames[reg]
+                                                              : quadNames[reg]);
+                    }
+
+                    void string(int id)
+                    {
+                            out.append(".LC");
+                            out.appendInt(id);
+                            out.append("(%rip)");
+                    }
+
+                    void memory(const Memory &memory)
+                    {
+                            if (memory.string >= 0)
+                            {
+                                    string(memory.string);
+                                    return;
+                            }
+                            if (memory.offset != 0)
+                            {
+                                    out.appendInt(memory.offset);
+                            }
+                            out.append('(');
+                            out.append(quadNames[memory.base]);
+                            if (memory.index >= 0)
+                            {
+                                    out.append(',');
+                                    out.append(quadNames[memory.index]);
+                                    out.append(',');
+                                    out.appendInt(memory.scale);
+                            }
+                            out.append(')');
+                    }
+
+                    // A register, stack slot or immediate as an operand
+                    void operand(const Place &place, Width width)
+                    {
+                            switch (place.kind)
+                            {
+                            case Place::Kind::REGISTER:
+                                    reg(place.number, width);
+                                    break;
+                            case Place::Kind::STACK:
+                                    memory(Memory{RBP, place.number});
+                                    break;
+                            case Place::Kind::IMMEDIATE:
+                                    out.append('$');
+                                    out.appendInt(place.number);
+                                    break;
+                            default:
+                                    break;
+                            }
+                    }
+
+                    void label(const Block *block)
+                    {
+                            out.append(".L");
+                            out.appendInt(number);
+                            out.append('_');
+                            out.appendInt(layout.at(block));
+                    }
+
+                    void edgeLabel(size_t edge)
+                    {
+                            out.append(".L");
+                            out.appendInt(number);
+                            out.append("_e");
+                            out.appendInt(edge);
+                    }
+
+                    // Analysis
+
+                    bool isAlias(Value value) const
+                    {
+                            return value.kind == Value::Kind::TEMP && !aliases[value.id].is(Place::Kind::NONE);
+                    }
+
+                    bool isInlined(Value value) const
+                    {
+                            return value.kind == Value::Kind::TEMP && inlined[value.id];
+                    }
+
+                    // Compares only used by the branch right after them, and element
+                    // addresses only used by the load or store right after them
+                    bool inlinable(const Instruction *instruction) const
+                    {
+                            const Instruction *user = instruction->next;
+                            if (user == nullptr || useCounts[instruction->result.id] != 1)
+                            {
+                                    return false;
+                            }
+                            if (instruction->op == Opcode::ICMP)
+                            {
+                                    return user->op == Opcode::COND_BR && user->lhs == instruction->result;
+                            }
+                            return (user->op == Opcode::LOAD && user->lhs == instruction->result) ||
+                                   (user->op == Opcode::STORE && user->rhs == instruction->result);
+                    }
+
+                    void analyze()
+                    {
+                            for (size_t b = 0; b < function.blocks.size(); ++b)
+                            {
+                                    layout[function.blocks[b]] = static_cast<int>(b);
+                            }
+
+                            int temps = function.tempCount;
+                            definitions.assign(temps, nullptr);
+                            useCounts.assign(temps, 0);
+                            aliases.assign(temps, Place());
+                            inlined.assign(temps, false);
+                            for (const Block *block : function.blocks)
+                            {
+                                    for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                    {
+                                            if (i->result.kind == Value::Kind::TEMP)
+                                            {
+                                                    definitions[i->result.id] = i;
+                                            }
+                                            i->forEachOperand([&](Value operand) {
+                                                    if (operand.kind == Value::Kind::TEMP)
+                                                    {
+                                                            useCounts[operand.id]++;
+                                                    }
+                                            });
+                                            if (i->op == Opcode::ALLOCA)
+                                            {
+                                                    int size = sizeOf(i->type) * std::max(i->count, 1);
+                                                    allocaBytes = alignUp(allocaBytes + size, std::min(sizeOf(i->type), 8));
+                                                    aliases[i->result.id] = Place::frame(-allocaBytes);
+                                            }
+                                    }
+                            }
+
+                            // Addresses of strings, and constant offsets into the frame,
+                            // whatever order their definitions are laid out in
+                            for (bool changed = true; changed;)
+                            {
+                                    changed = false;
+                                    for (Instruction *i : definitions)
+                                    {
+                                            if (i == nullptr || isAlias(i->result))
+                                            {
+                                                    continue;
+                                            }
+                                            Place base = i->lhs.kind == Value::Kind::STRING ? Place::string(globals[i->lhs.id])
+                                                         : isAlias(i->lhs)                   ? aliases[i->lhs.id]
+                                                                                             : Place();
+                                            if (i->op == Opcode::GEP && base.is(Place::Kind::STRING))
+                                            {
+                                                    aliases[i->result.id] = base;
+                                            }
+                                            else if (i->op == Opcode::GEP && base.is(Place::Kind::FRAME) &&
+                                                     i->rhs.kind == Value::Kind::CONSTANT)
+                                            {
+                                                    aliases[i->result.id] = Place::frame(base.number + i->rhs.id * sizeOf(i->type));
+                                            }
+                                            else if (i->op == Opcode::BITCAST && base.is(Place::Kind::FRAME))
+                                            {
+                                                    aliases[i->result.id] = base;
+                                            }
+                                            else
+                                            {
+                                                    continue;
+                                            }
+                                            changed = true;
+                                    }
+                            }
+
+                            std::vector<bool> located(temps + function.parameters.size(), true);
+                            for (int t = 0; t < temps; ++t)
+                            {
+                                    Instruction *i = definitions[t];
+                                    inlined[t] = i != nullptr && !isAlias(i->result) &&
+                                                 (i->op == Opcode::ICMP || i->op == Opcode::GEP) && inlinable(i);
+                                    located[t] = i != nullptr && !isAlias(i->result) && !inlined[t];
+                            }
+
+                            // Arguments start out where the convention passes them
+                            std::vector<int> preferred(located.size(), -1);
+                            for (int k = 0; k < std::min<int>(function.parameters.size(), registerArguments); ++k)
+                            {
+                                    for (int r = 0; r < allocatableCount; ++r)
+                                    {
+                                            if (allocatable[r] == argumentRegisters[k])
+                                            {
+                                                    preferred[temps + k] = r;
+                                            }
+                                    }
+                            }
+                            allocation = allocateRegisters(function, located, preferred, allocatableCount, preservedCount);
+
+                            int bytes = alignUp(allocaBytes, 8) + 8 * allocation.slotCount;
+                            for (int r = allocatableCount - preservedCount; r < allocatableCount; ++r)
+                            {
+                                    if (allocation.used[r])
+                                    {
+                                            bytes += 8;
+                                            saved.push_back({allocatable[r], -bytes});
+                                    }
+                            }
+                            frameSize = alignUp(bytes, 16);
+                    }
+
+                    Place place(Value value) const
+                    {
+                            switch (value.kind)
+                            {
+                            case Value::Kind::CONSTANT:
+                                    return Place::immediate(value.id);
+                            case Value::Kind::NULLPTR:
+                                    return Place::immediate(0);
+                            case Value::Kind::STRING:
+                            case Value::Kind::STRING_ADDRESS:
+                                    return Place::string(globals[value.id]);
+                            case Value::Kind::TEMP:
+                                    if (isAlias(value))
+                                    {
+                                            return aliases[value.id];
+                                    }
+                                    break;
+                            case Value::Kind::ARGUMENT:
+                                    break;
+                            default:
+                                    return Place();
+                            }
+                            int index = valueIndex(function, value);
+                            if (allocation.registers[index] >= 0)
+                            {
+                                    return Place::reg(allocatable[allocation.registers[index]]);
+                            }
+                            if (allocation.slots[index] >= 0)
+                            {
+                                    return Place::stack(-alignUp(allocaBytes, 8) - 8 * (allocation.slots[index] + 1));
+                            }
+                            return Place();
+                    }
+
+                    // Moves
+
+                    // Copies source into register r. Only the low bits of the type count
+                    void load(int r, const Place &source, Type type)
+                    {
+                            Width width = arithmeticWidth(type);
+                            switch (source.kind)
+                            {
+                            case Place::Kind::REGISTER:
+                                    if (source.number == r)
+                                    {
+                                            return;
+                                    }
+                                    instruction("mov", width);
+                                    break;
+                            case Place::Kind::STACK:
+                            case Place::Kind::IMMEDIATE:
+                                    instruction("mov", width);
+                                    break;
+                            case Place::Kind::FRAME:
+                                    instruction("leaq");
+                                    memory(Memory{RBP, source.number});
+                                    comma();
+                                    reg(r, Width::QUAD);
+                                    end();
+                                    return;
+                            case Place::Kind::STRING:
+                                    instruction("leaq");
+                                    string(source.number);
+                                    comma();
+                                    reg(r, Width::QUAD);
+                                    end();
+                                    return;
+                            case Place::Kind::NONE:
+                                    return;
+                            }
+                            operand(source, width);
+                            comma();
+                            reg(r, width);
+                            end();
+                    }
+
+                    // A place an instruction can read directly, addresses loaded into scratch
+                    Place readable(Value value, int scratch)
+                    {
+                            Place p = place(value);
+                            if (p.is(Place::Kind::FRAME) || p.is(Place::Kind::STRING))
+                            {
+                                    load(scratch, p, Type::I8_PTR);
+                                    return Place::reg(scratch);
+                            }
+                            return p;
+                    }
+
+                    void move(const Place &destination, const Place &source, Type type)
+                    {
+                            if (destination.is(Place::Kind::REGISTER))
+                            {
+                                    load(destination.number, source, source.is(Place::Kind::IMMEDIATE) ? type : Type::I64);
+                                    return;
+                            }
+                            if (!destination.is(Place::Kind::STACK) || destination == source)
+                            {
+                                    return;
+                            }
+                            Place from = source;
+                            if (!source.is(Place::Kind::REGISTER) && !source.is(Place::Kind::IMMEDIATE))
+                            {
+                                    load(RAX, source, Type::I64);
+                                    from = Place::reg(RAX);
+                            }
+                            instruction("movq");
+                            operand(from, Width::QUAD);
+                            comma();
+                            operand(destination, Width::QUAD);
+                            end();
+                    }
+
+                    // Does the moves as if all at once: a destination is written only
+                    // after every move reading it, and r11 breaks the cycles
+                    void parallelMove(std::vector<Move> moves)
+                    {
+                            moves.erase(std::remove_if(moves.begin(), moves.end(), [](const Move &m) {
+                                                return m.destination.is(Place::Kind::NONE) || m.destination == m.source;
+                                        }),
+                                        moves.end());
+                            while (!moves.empty())
+                            {
+                                    bool progress = false;
+                                    for (size_t m = 0; m < moves.size() && !progress; ++m)
+                                    {
+                                            bool read = false;
+                                            for (size_t k = 0; k < moves.size() && !read; ++k)
+                                            {
+                                                    read = k != m && moves[k].source == moves[m].destination;
+                                            }
+                                            if (!read)
+                                            {
+                                                    move(moves[m].destination, moves[m].source, moves[m].type);
+                                                    moves.erase(moves.begin() + m);
+                                                    progress = true;
+                                            }
+                                    }
+                                    if (!progress)
+                                    {
+                                            Place blocked = moves.front().destination;
+                                            move(Place::reg(R11), blocked, Type::I64);
+                                            for (Move &m : moves)
+                                            {
+                                                    if (m.source == blocked)
+                                                    {
+                                                            m.source = Place::reg(R11);
+                                                    }
+                                            }
+                                    }
+                            }
+                    }
+
+                    // Register the result is computed in: its own, or rax when it lives on the stack
+                    int target(Value result) const
+                    {
+                            Place p = place(result);
+                            return p.is(Place::Kind::REGISTER) ? p.number : RAX;
+                    }
+
+                    // Stores a result computed in rax to its stack slot
+                    void finish(Value result, int r)
+                    {
+                            Place p = place(result);
+                            if (p.is(Place::Kind::STACK))
+                            {
+                                    move(p, Place::reg(r), Type::I64);
+                            }
+                    }
+
+                    // Addresses
+
+                    // Address of element index of type past base
+                    Memory element(const Place &base, Value index, Type type)
+                    {
+                            Memory memory;
+                            switch (base.kind)
+                            {
+                            case Place::Kind::FRAME:
+                                    memory.offset = base.number;
+                                    break;
+                            case Place::Kind::STRING:
+                                    load(RCX, base, Type::I8_PTR);
+                                    memory.base = RCX;
+                                    break;
+                            case Place::Kind::REGISTER:
+                                    memory.base = base.number;
+                                    break;
+                            default:
+                                    load(RCX, base, Type::I8_PTR);
+                                    memory.base = RCX;
+                                    break;
+                            }
+                            Place i = place(index);
+                            if (i.is(Place::Kind::IMMEDIATE))
+                            {
+                                    memory.offset += i.number * sizeOf(type);
+                                    return memory;
+                            }
+                            // The index is signed, and only its low 32 bits are defined
+                            instruction("movslq");
+                            operand(i, Width::LONG);
+                            comma();
+                            reg(R11, Width::QUAD);
+                            end();
+                            memory.index = R11;
+                            memory.scale = sizeOf(type);
+                            return memory;
+                    }
+
+                    Memory address(Value pointer)
+                    {
+                            if (isInlined(pointer))
+                            {
+                                    Instruction *gep = definitions[pointer.id];
+                                    return element(place(gep->lhs), gep->rhs, gep->type);
+                            }
+                            Place p = place(pointer);
+                            switch (p.kind)
+                            {
+                            case Place::Kind::FRAME:
+                                    return Memory{RBP, p.number};
+                            case Place::Kind::STRING:
+                                    return Memory{RBP, 0, -1, 1, p.number};
+                            case Place::Kind::REGISTER:
+                                    return Memory{p.number};
+                            default:
+                                    load(R11, p, Type::I8_PTR);
+                                    return Memory{R11};
+                            }
+                    }
+
+                    // Instructions
+
+                    void load(const Instruction &instruction)
+                    {
+                            Memory from = address(instruction.lhs);
+                            int r = target(instruction.result);
+                            Width width = widthOf(instruction.type);
+                            this->instruction(width == Width::BYTE ? "movzbl" : width == Width::LONG ? "movl" : "movq");
+                            memory(from);
+                            comma();
+                            reg(r, width == Width::QUAD ? Width::QUAD : Width::LONG);
+                            end();
+                            finish(instruction.result, r);
+                    }
+
+                    void store(const Instruction &instruction)
+                    {
+                            Width width = widthOf(instruction.type);
+                            Place value = place(instruction.lhs);
+                            if (!value.is(Place::Kind::REGISTER) && !value.is(Place::Kind::IMMEDIATE))
+                            {
+                                    load(RAX, value, Type::I64);
+                                    value = Place::reg(RAX);
+                            }
+                            Memory to = address(instruction.rhs);
+                            this->instruction("mov", width);
+                            operand(value, width);
+                            comma();
+                            memory(to);
+                            end();
+                    }
+
+                    static bool commutes(Opcode op)
+                    {
+                            return op == Opcode::ADD || op == Opcode::MUL || op == Opcode::AND ||
+                                   op == Opcode::OR || op == Opcode::XOR;
+                    }
+
+                    static const char *mnemonic(Opcode op)
+                    {
+                            switch (op)
+                            {
+                            case Opcode::ADD:
+                                    return "add";
+                            case Opcode::SUB:
+                                    return "sub";
+                            case Opcode::MUL:
+                                    return "imul";
+                            case Opcode::AND:
+                                    return "and";
+                            case Opcode::OR:
+                                    return "or";
+                            case Opcode::XOR:
+                                    return "xor";
+                            case Opcode::SHL:
+                                    return "shl";
+                            case Opcode::LSHR:
+                                    return "shr";
+                            default:
+                                    return "sar";
+                            }
+                    }
+
+                    void divide(const Instruction &instruction)
+                    {
+                            Width width = arithmeticWidth(instruction.type);
+                            Place divisor = readable(instruction.rhs, RCX);
+                            if (divisor == Place::immediate(-1))
+                            {
+                                    // Wraps like LLVM folds it, where idiv would trap on the minimum
+                                    int r = target(instruction.result);
+                                    load(r, readable(instruction.lhs, RAX), instruction.type);
+                                    this->instruction("neg", width);
+                                    reg(r, width);
+                                    end();
+                                    finish(instruction.result, r);
+                                    return;
+                            }
+                            if (instruction.type == Type::I8)
+                            {
+                                    // Both bytes sign extended; the quotient of -128 by -1 fits in 32 bits
+                                    extend(RAX, place(instruction.lhs), Type::I8, true, Width::LONG);
+                                    extend(RCX, divisor, Type::I8, true, Width::LONG);
+                                    divisor = Place::reg(RCX);
+                            }
+                            else
+                            {
+                                    load(RAX, place(instruction.lhs), instruction.type);
+                                    if (divisor.is(Place::Kind::IMMEDIATE))
+                                    {
+                                            load(RCX, divisor, instruction.type);
+                                            divisor = Place::reg(RCX);
+                                    }
+                            }
+                            this->instruction(width == Width::QUAD ? "cqto" : "cltd");
+                            end();
+                            this->instruction("idiv", width);
+                            operand(divisor, width);
+                            end();
+                            move(place(instruction.result), Place::reg(RAX), Type::I64);
+                    }
+
+                    // Copies the low bits of a bool or byte, or of an int to 64 bits,
+                    // into r, extended with zeros or the sign
+                    void extend(int r, const Place &source, Type type, bool sign, Width width)
+                    {
+                            if (source.is(Place::Kind::IMMEDIATE))
+                            {
+                                    int value = source.number;
+                                    if (type == Type::I8)
+                                    {
+                                            value = sign ? static_cast<signed char>(value) : value & 0xff;
+                                    }
+                                    else if (type == Type::I1)
+                                    {
+                                            value = sign ? -(value & 1) : value & 1;
+                                    }
+                                    load(r, Place::immediate(value), width == Width::QUAD ? Type::I64 : Type::I32);
+                                    return;
+                            }
+                            if (type == Type::I32)
+                            {
+                                    instruction(sign ? "movslq" : "movl");
+                                    operand(source, Width::LONG);
+                                    comma();
+                                    reg(r, sign ? Width::QUAD : Width::LONG);
+                                    end();
+                                    return;
+                            }
+                            bool bytewise = type == Type::I8 && sign;
+                            instruction(bytewise ? (width == Width::QUAD ? "movsbq" : "movsbl") : "movzbl");
+                            operand(source, Width::BYTE);
+                            comma();
+                            reg(r, bytewise ? width : Width::LONG);
+                            end();
+                            if (type == Type::I1 && sign)
+                            {
+                                    instruction("neg", width);
+                                    reg(r, width);
+                                    end();
+                            }
+                    }
+
+                    void shift(const Instruction &instruction)
+                    {
+                            Width width = arithmeticWidth(instruction.type);
+                            Place count = place(instruction.rhs);
+                            if (!count.is(Place::Kind::IMMEDIATE))
+                            {
+                                    load(RCX, count, Type::I32);
+                            }
+                            int r = target(instruction.result);
+                            Place value = readable(instruction.lhs, RAX);
+                            if (instruction.type == Type::I8 && instruction.op != Opcode::SHL)
+                            {
+                                    extend(r, value, Type::I8, instruction.op == Opcode::ASHR, Width::LONG);
+                            }
+                            else
+                            {
+                                    load(r, value, instruction.type);
+                            }
+                            this->instruction(mnemonic(instruction.op), width);
+                            if (count.is(Place::Kind::IMMEDIATE))
+                            {
+                                    operand(count, width);
+                            }
+                            else
+                            {
+                                    reg(RCX, Width::BYTE);
+                            }
+                            comma();
+                            reg(r, width);
+                            end();
+                            finish(instruction.result, r);
+                    }
+
+                    void binary(const Instruction &instruction)
+                    {
+                            Opcode op = instruction.op;
+                            Width width = arithmeticWidth(instruction.type);
+                            Place a = readable(instruction.lhs, RCX);
+                            Place b = readable(instruction.rhs, RDX);
+                            if (commutes(op) && a.is(Place::Kind::IMMEDIATE))
+                            {
+                                    std::swap(a, b);
+                            }
+                            int r = target(instruction.result);
+
+                            if (op == Opcode::MUL && b.is(Place::Kind::IMMEDIATE) && !a.is(Place::Kind::IMMEDIATE))
+                            {
+                                    this->instruction("imul", width);
+                                    operand(b, width);
+                                    comma();
+                                    operand(a, width);
+                                    comma();
+                                    reg(r, width);
+                                    end();
+                                    finish(instruction.result, r);
+                                    return;
+                            }
+                            if ((op == Opcode::ADD || op == Opcode::SUB) && a.is(Place::Kind::REGISTER) &&
+                                b.is(Place::Kind::IMMEDIATE) && a.number != r)
+                            {
+                                    // A three operand add
+                                    this->instruction("lea", width);
+                                    out.appendInt(op == Opcode::ADD ? b.number : -b.number);
+                                    out.append('(');
+                                    out.append(quadNames[a.number]);
+                                    out.append("), ");
+                                    reg(r, width);
+                                    end();
+                                    finish(instruction.result, r);
+                                    return;
+                            }
+                            if (b == Place::reg(r) && !(a == b))
+                            {
+                                    if (commutes(op))
+                                    {
+                                            std::swap(a, b);
+                                    }
+                                    else
+                                    {
+                                            // x - y into the register of y
+                                            load(R11, a, instruction.type);
+                                            this->instruction(mnemonic(op), width);
+                                            operand(b, width);
+                                            comma();
+                                            reg(R11, width);
+                                            end();
+                                            move(place(instruction.result), Place::reg(R11), Type::I64);
+                                            return;
+                                    }
+                            }
+                            load(r, a, instruction.type);
+                            this->instruction(mnemonic(op), width);
+                            operand(b, width);
+                            comma();
+                            reg(r, width);
+                            end();
+                            finish(instruction.result, r);
+                    }
+
+                    // Sets the flags for the compare and returns the condition on them
+                    Predicate compare(const Instruction &instruction)
+                    {
+                            Width width = widthOf(instruction.type);
+                            Predicate predicate = instruction.predicate;
+                            Place a = readable(instruction.lhs, RAX);
+                            Place b = readable(instruction.rhs, RCX);
+                            if (a.is(Place::Kind::IMMEDIATE) && !b.is(Place::Kind::IMMEDIATE))
+                            {
+                                    std::swap(a, b);
+                                    predicate = swapped(predicate);
+                            }
+                            if (a.is(Place::Kind::IMMEDIATE) || (a.is(Place::Kind::STACK) && b.is(Place::Kind::STACK)))
+                            {
+                                    load(RAX, a, Type::I64);
+                                    a = Place::reg(RAX);
+                            }
+                            if (a.is(Place::Kind::REGISTER) && b == Place::immediate(0))
+                            {
+                                    this->instruction("test", width);
+                                    operand(a, width);
+                            }
+                            else
+                            {
+                                    this->instruction("cmp", width);
+                                    operand(b, width);
+                            }
+                            comma();
+                            operand(a, width);
+                            end();
+                            return predicate;
+                    }
+
+                    void cast(const Instruction &instruction)
+                    {
+                            int r = target(instruction.result);
+                            Place source = readable(instruction.lhs, RAX);
+                            Width width = arithmeticWidth(instruction.type);
+                            switch (instruction.op)
+                            {
+                            case Opcode::ZEXT:
+                                    extend(r, source, instruction.sourceType, false, width);
+                                    break;
+                            case Opcode::SEXT:
+                                    extend(r, source, instruction.sourceType, true, width);
+                                    break;
+                            case Opcode::TRUNC:
+                                    load(r, source, instruction.sourceType);
+                                    if (instruction.type == Type::I1)
+                                    {
+                                            this->instruction("andl");
+                                            out.append("$1, ");
+                                            reg(r, Width::LONG);
+                                            end();
+                                    }
+                                    break;
+                            default:
+                                    load(r, source, Type::I8_PTR);
+                                    break;
+                            }
+                            finish(instruction.result, r);
+                    }
+
+                    // Restores what the prologue saved and leaves the frame
+                    void leave()
+                    {
+                            for (const auto &s : saved)
+                            {
+                                    instruction("movq");
+                                    memory(Memory{RBP, s.second});
+                                    comma();
+                                    reg(s.first, Width::QUAD);
+                                    end();
+                            }
+                            instruction("leave");
+                            end();
+                    }
+
+                    // Whether the call can leave this frame before it starts: it ends
+                    // the function, and nothing it gets points into the frame
+                    bool tailCall(const Instruction &call) const
+                    {
+                            const Instruction *ret = call.next;
+                            if (ret == nullptr || ret->op != Opcode::RET || call.argumentCount > registerArguments ||
+                                (ret->type != Type::VOID && ret->lhs != call.result))
+                            {
+                                    return false;
+                            }
+                            for (int k = 0; k < call.argumentCount; ++k)
+                            {
+                                    Place p = place(call.arguments[k].value);
+                                    if (call.arguments[k].type == Type::I8_PTR && !p.is(Place::Kind::STRING))
+                                    {
+                                            return false;
+                                    }
+                            }
+                            return true;
+                    }
+
+                    // Returns true if the call jumped, so the ret after it is left out
+                    bool call(const Instruction &call)
+                    {
+                            const char *callee = call.callee;
+                            if (std::strncmp(callee, "llvm.lifetime.", 14) == 0)
+                            {
+                                    return false;
+                            }
+                            if (std::strncmp(callee, "llvm.memset.", 12) == 0)
+                            {
+                                    callee = "memset";
+                            }
+
+                            int onStack = std::max(call.argumentCount - registerArguments, 0);
+                            bool jumps = tailCall(call);
+                            if (onStack % 2 != 0)
+                            {
+                                    instruction("subq");
+                                    out.append("$8, %rsp\n");
+                            }
+                            for (int k = call.argumentCount - 1; k >= registerArguments; --k)
+                            {
+                                    Place p = readable(call.arguments[k].value, RAX);
+                                    instruction("pushq");
+                                    operand(p, Width::QUAD);
+                                    end();
+                            }
+                            std::vector<Move> moves;
+                            for (int k = 0; k < std::min(call.argumentCount, registerArguments); ++k)
+                            {
+                                    moves.push_back(Move{Place::reg(argumentRegisters[k]), place(call.arguments[k].value),
+                                                         call.arguments[k].type});
+                            }
+                            parallelMove(moves);
+
+                            if (jumps)
+                            {
+                                    leave();
+                                    instruction("jmp");
+                                    out.append(callee);
+                                    end();
+                                    return true;
+                            }
+                            instruction("call");
+                            out.append(callee);
+                            end();
+                            if (onStack > 0)
+                            {
+                                    instruction("addq");
+                                    out.append('$');
+                                    out.appendInt(alignUp(onStack, 2) * 8);
+                                    out.append(", %rsp\n");
+                            }
+                            move(place(call.result), Place::reg(RAX), Type::I64);
+                            return false;
+                    }
+
+                    // The moves of the phis of to on the edge from from, but those that change nothing
+                    std::vector<Move> edgeMoves(const Block *from, const Block *to) const
+                    {
+                            std::vector<Move> moves;
+                            for (const Instruction *phi = to->first; phi != nullptr && phi->op == Opcode::PHI; phi = phi->next)
+                            {
+                                    for (int k = 0; k < phi->incomingCount; ++k)
+                                    {
+                                            if (phi->incoming[k].block == from)
+                                            {
+                                                    Move move{place(phi->result), place(phi->incoming[k].value), phi->type};
+                                                    if (!move.destination.is(Place::Kind::NONE) && !(move.destination == move.source))
+                                                    {
+                                                            moves.push_back(move);
+                                                    }
+                                                    break;
+                                            }
+                                    }
+                            }
+                            return moves;
+                    }
+
+                    void jump(const Block *from, const Block *to)
+                    {
+                            parallelMove(edgeMoves(from, to));
+                            if (layout.at(to) != layout.at(from) + 1)
+                            {
+                                    instruction("jmp");
+                                    label(to);
+                                    end();
+                            }
+                    }
+
+                    // Jumps to to on the condition, through a block of phi moves if it needs any
+                    void jumpIf(Predicate predicate, const Block *from, const Block *to)
+                    {
+                            out.append("\tj");
+                            out.append(conditionCode(predicate));
+                            out.append('\t');
+                            if (!edgeMoves(from, to).empty())
+                            {
+                                    edgeLabel(edges.size());
+                                    edges.push_back({from, to});
+                            }
+                            else
+                            {
+                                    label(to);
+                            }
+                            end();
+                    }
+
+                    void branch(const Block *block, const Instruction &instruction)
+                    {
+                            const Block *yes = instruction.target;
+                            const Block *no = instruction.otherwise;
+                            Predicate predicate = Predicate::NE;
+                            if (isInlined(instruction.lhs))
+                            {
+                                    predicate = compare(*definitions[instruction.lhs.id]);
+                            }
+                            else
+                            {
+                                    Place condition = place(instruction.lhs);
+                                    if (condition.is(Place::Kind::IMMEDIATE) || yes == no)
+                                    {
+                                            jump(block, condition.number != 0 ? yes : no);
+                                            return;
+                                    }
+                                    this->instruction("cmpb");
+                                    out.append("$0, ");
+                                    operand(condition, Width::BYTE);
+                                    end();
+                            }
+
+                            // The side that can fall through is taken last
+                            if (layout.at(yes) == layout.at(block) + 1 && edgeMoves(block, yes).empty())
+                            {
+                                    std::swap(yes, no);
+                                    predicate = negated(predicate);
+                            }
+                            jumpIf(predicate, block, yes);
+                            jump(block, no);
+                    }
+
+                    void ret(const Instruction &instruction)
+                    {
+                            if (instruction.type != Type::VOID)
+                            {
+                                    load(RAX, place(instruction.lhs), instruction.type);
+                            }
+                            leave();
+                            this->instruction("ret");
+                            end();
+                    }
+
+                    // Emits instruction; true if it also took care of the one after it
+                    bool emit(const Block *block, const Instruction &instruction)
+                    {
+                            if ((instruction.result.kind == Value::Kind::TEMP &&
+                                 (isAlias(instruction.result) || isInlined(instruction.result))))
+                            {
+                                    return false;
+                            }
+                            switch (instruction.op)
+                            {
+                            case Opcode::LOAD:
+                                    load(instruction);
+                                    break;
+                            case Opcode::STORE:
+                                    store(instruction);
+                                    break;
+                            case Opcode::ADD:
+                            case Opcode::SUB:
+                            case Opcode::MUL:
+                            case Opcode::AND:
+                            case Opcode::OR:
+                            case Opcode::XOR:
+                                    binary(instruction);
+                                    break;
+                            case Opcode::SHL:
+                            case Opcode::LSHR:
+                            case Opcode::ASHR:
+                                    shift(instruction);
+                                    break;
+                            case Opcode::SDIV:
+                                    divide(instruction);
+                                    break;
+                            case Opcode::ICMP:
+                            {
+                                    Predicate predicate = compare(instruction);
+                                    int r = target(instruction.result);
+                                    out.append("\tset");
+                                    out.append(conditionCode(predicate));
+                                    out.append('\t');
+                                    reg(r, Width::BYTE);
+                                    end();
+                                    this->instruction("movzbl");
+                                    reg(r, Width::BYTE);
+                                    comma();
+                                    reg(r, Width::LONG);
+                                    end();
+                                    finish(instruction.result, r);
+                                    break;
+                            }
+                            case Opcode::ZEXT:
+                            case Opcode::SEXT:
+                            case Opcode::TRUNC:
+                            case Opcode::BITCAST:
+                                    cast(instruction);
+                                    break;
+                            case Opcode::GEP:
+                            {
+                                    Memory address = element(place(instruction.lhs), instruction.rhs, instruction.type);
+                                    int r = target(instruction.result);
+                                    this->instruction("leaq");
+                                    memory(address);
+                                    comma();
+                                    reg(r, Width::QUAD);
+                                    end();
+                                    finish(instruction.result, r);
+                                    break;
+                            }
+                            case Opcode::CALL:
+                                    return call(instruction);
+                            case Opcode::BR:
+                                    jump(block, instruction.target);
+                                    break;
+                            case Opcode::COND_BR:
+                                    branch(block, instruction);
+                                    break;
+                            case Opcode::RET:
+                                    ret(instruction);
+                                    break;
+                            default:
+                                    // Allocas are frame addresses, phis moves on the edges, and
+                                    // nothing follows unreachable
+                                    break;
+                            }
+                            return false;
+                    }
+
+                public:
+                    FunctionEmitter(const Function &function, output::ChunkBuffer &out, int number,
+                                    const std::vector<int> &globals)
+                        : function(function), out(out), number(number), globals(globals) {}
+
+                    void print()
+                    {
+                            analyze();
+
+                            out.append("\t.globl\t");
+                            out.append(function.name);
+                            out.append("\n\t.type\t");
+                            out.append(function.name);
+                            out.append(", @function\n");
+                            out.append(function.name);
+                            out.append(":\n\tpushq\t%rbp\n\tmovq\t%rsp, %rbp\n");
+                            if (frameSize > 0)
+                            {
+                                    instruction("subq");
+                                    out.append('$');
+                                    out.appendInt(frameSize);
+                                    out.append(", %rsp\n");
+                            }
+                            for (const auto &s : saved)
+                            {
+                                    instruction("movq");
+                                    reg(s.first, Width::QUAD);
+                                    comma();
+                                    memory(Memory{RBP, s.second});
+                                    end();
+                            }
+                            std::vector<Move> arguments;
+                            for (int k = 0; k < static_cast<int>(function.parameters.size()); ++k)
+                            {
+                                    Place from = k < registerArguments ? Place::reg(argumentRegisters[k])
+                                                                       : Place::stack(16 + 8 * (k - registerArguments));
+                                    arguments.push_back(Move{place(Value::argument(k)), from, function.parameters[k]});
+                            }
+                            parallelMove(arguments);
+
+                            for (const Block *block : function.blocks)
+                            {
+                                    label(block);
+                                    out.append(":\n");
+                                    for (const Instruction *i = block->first; i != nullptr; i = i->next)
+                                    {
+                                            if (emit(block, *i))
+                                            {
+                                                    i = i->next;
+                                            }
+                                    }
+                            }
+                            for (size_t e = 0; e < edges.size(); ++e)
+                            {
+                                    edgeLabel(e);
+                                    out.append(":\n");
+                                    parallelMove(edgeMoves(edges[e].first, edges[e].second));
+                                    instruction("jmp");
+                                    label(edges[e].second);
+                                    end();
+                            }
+
+                            out.append("\t.size\t");
+                            out.append(function.name);
+                            out.append(", .-");
+                            out.append(function.name);
+                            out.append("\n\n");
+                    }
+                };
+
+                // The text as the operand of .string, which adds the terminating zero
+                void quote(const std::string &text, output::ChunkBuffer &out)
+                {
+                        out.append('"');
+                        for (unsigned char c : text)
+                        {
+                                if (c == '"' || c == '\\')
+                                {
+                                        out.append('\\');
+                                        out.append(static_cast<char>(c));
+                                }
+                                else if (c < 32 || c >= 127)
+                                {
+                                        char octal[] = {'\\', static_cast<char>('0' + (c >> 6)),
+                                                        static_cast<char>('0' + ((c >> 3) & 7)),
+                                                        static_cast<char>('0' + (c & 7))};
+                                        out.append(octal, sizeof(octal));
+                                }
+                                else
+                                {
+                                        out.append(static_cast<char>(c));
+                                }
+                        }
+                        out.append('"');
+                }
+
+        }
+
+        void printAssembly(const Module &module, output::ChunkBuffer &out)
+        {
+                // One constant per distinct text, like the LLVM printer
+                std::unordered_map<std::string, int> pool;
+                std::vector<std::vector<int>> globals(module.functions.size());
+                out.append("\t.section\t.rodata\n");
+                for (size_t f = 0; f < module.functions.size(); ++f)
+                {
+                        for (const std::string &text : module.functions[f]->strings)
+                        {
+                                auto found = pool.emplace(text, static_cast<int>(pool.size()));
+                                globals[f].push_back(found.first->second);
+                                if (found.second)
+                                {
+                                        out.append(".LC");
+                                        out.appendInt(found.first->second);
+                                        out.append(":\n\t.string\t");
+                                        quote(text, out);
+                                        out.append('\n');
+                                }
+                        }
+                }
+
+                out.append("\n\t.text\n");
+                for (size_t f = 0; f < module.functions.size(); ++f)
+                {
+                        FunctionEmitter(*module.functions[f], out, static_cast<int>(f), globals[f]).print();
+                }
+                out.append(runtime);
+        }
+
+}
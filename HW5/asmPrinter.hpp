@@ -0,0 +1,21 @@
+#ifndef ASM_PRINTER_HPP
+#define ASM_PRINTER_HPP
+
+#include "chunkBuffer.hpp"
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // Prints the module as x86-64 assembly for the GNU assembler, following
+    // the System V calling convention, with registers allocated by linear
+    // scan. The string constants come first, then every function of the
+    // program, then a runtime of its own in place of the C library: print,
+    // printi, readi, exit and memset over the read, write and exit system
+    // calls, and _start, which calls main. The result needs nothing else:
+    //      as -o prog.o prog.s && ld -o prog prog.o
+    void printAssembly(const Module &module, output::ChunkBuffer &out);
+
+}
+
+#endif // ASM_PRINTER_HPP
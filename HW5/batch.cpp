@@ -0,0 +1,124 @@
+#include "batch.hpp"
+#include "threadPool.hpp"
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+// Helper functions
+
+static std::string outputPath(const std::string &inputPath, const CompileOptions &options)
+{
+    const std::string suffix = ".in";
+    const std::string extension = options.assembly ? ".s" : ".ll";
+    if (inputPath.size() > suffix.size() &&
+        inputPath.compare(inputPath.size() - suffix.size(), suffix.size(), suffix) == 0)
+    {
+        return inputPath.substr(0, inputPath.size() - suffix.size()) + extension;
+    }
+    return inputPath + extension;
+}
+
+static bool readList(const std::string &listPath, std::vector<std::string> &paths)
+{
+    std::ifstream list(listPath);
+    if (!list)
+    {
+        return false;
+    }
+    std::string line;
+    while (std::getline(list, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (!line.empty())
+        {
+            paths.push_back(line);
+        }
+    }
+    return true;
+}
+
+// Outcome of one file, filled in by whichever worker compiled it
+struct BatchEntry
+{
+    std::string path;
+    bool ioError = false;
+    bool success = false;
+    std::string diagnostic;
+};
+
+static void compileEntry(BatchEntry &entry, const CompileOptions &options)
+{
+    std::ifstream input(entry.path, std::ios::binary);
+    if (!input)
+    {
+        entry.ioError = true;
+        entry.diagnostic = "cannot read file\n";
+        return;
+    }
+    std::string source((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    CompileResult result = compile(source, options);
+
+    int fd = ::open(outputPath(entry.path, options).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool written = fd >= 0 && result.output.writeTo(fd);
+    if (fd >= 0 && ::close(fd) != 0)
+    {
+        written = false;
+    }
+    if (!written)
+    {
+        entry.ioError = true;
+        entry.diagnostic = "cannot write " + outputPath(entry.path, options) + "\n";
+        return;
+    }
+    entry.success = result.success;
+    if (!result.success)
+    {
+        entry.diagnostic = result.output.str();
+    }
+}
+
+int runBatch(const std::string &listPath, std::size_t jobs, const CompileOptions &options)
+{
+    std::vector<std::string> paths;
+    if (!readList(listPath, paths))
+    {
+        std::cerr << listPath << ": cannot read file list" << std::endl;
+        return 1;
+    }
+
+    std::vector<BatchEntry> entries(paths.size());
+    {
+        ThreadPool pool(jobs);
+        for (std::size_t i = 0; i < paths.size(); ++i)
+        {
+            entries[i].path = paths[i];
+            pool.submit([&entries, i, &options] { compileEntry(entries[i], options); });
+        }
+        pool.wait();
+    }
+
+    // Reported only after every file is done, so the order never depends on scheduling
+    std::size_t failed = 0;
+    bool ioError = false;
+    std::ostringstream report;
+    for (const BatchEntry &entry : entries)
+    {
+        if (!entry.success)
+        {
+            failed++;
+            report << entry.path << ": " << entry.diagnostic;
+        }
+        ioError = ioError || entry.ioError;
+    }
+    std::cerr << report.str() << "batch: " << entries.size() << " files, "
+              << failed << " with diagnostics" << std::endl;
+    return ioError ? 1 : 0;
+}
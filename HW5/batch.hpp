@@ -0,0 +1,15 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <cstddef>
+#include <string>
+#include "compilation.hpp"
+
+// Compiles every file named in listPath (one path per line) on `jobs` threads.
+// Each result goes to its own .ll file, or .s file with options.assembly:
+// foo.in is written to foo.ll, any other name gets .ll appended. The file
+// holds exactly what `hw5 < file` would print. Diagnostics are also reported on stderr, in list order.
+// Returns 0 unless the list or one of its files could not be read or written
+int runBatch(const std::string &listPath, std::size_t jobs, const CompileOptions &options);
+
+#endif // BATCH_HPP
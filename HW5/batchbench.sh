@@ -0,0 +1,61 @@
+#!/bin/bash
+
+# Usage: ./batchbench.sh [jobs...]
+# Compiles every HW2 and HW3 test input once per process, as runner.sh does,
+# and then with hw5 --batch, and compares the throughput.
+# Defaults to -j 1 and -j $(nproc).
+
+# Compile the project
+make > /dev/null 2>&1
+
+# Exit if compilation fails
+if [ $? -ne 0 ]; then
+    echo "❌ Compilation failed."
+    exit 1
+fi
+
+BENCH_DIR=$(mktemp -d)
+trap 'rm -rf "$BENCH_DIR"; make clean > /dev/null' EXIT
+
+JOBS=(1 "$(nproc)")
+if [ $# -gt 0 ]; then
+    JOBS=("$@")
+fi
+
+# Copy the inputs into two identical trees, one per mode, so outputs can be compared
+mkdir -p "$BENCH_DIR/loop" "$BENCH_DIR/batch"
+SOURCES=()
+COUNT=0
+while IFS= read -r IN_FILE; do
+    SOURCES+=("$IN_FILE")
+    cp "$IN_FILE" "$BENCH_DIR/loop/$COUNT.in"
+    cp "$IN_FILE" "$BENCH_DIR/batch/$COUNT.in"
+    echo "$BENCH_DIR/batch/$COUNT.in" >> "$BENCH_DIR/list.txt"
+    ((COUNT++))
+done < <(find ../HW3/allTests ../HW2/AllTests -name '*.in' | sort)
+
+TIMEFORMAT="%R"
+
+echo "========================="
+echo "  Batch Throughput ($COUNT files)"
+echo "========================="
+echo ""
+
+LOOP_SECONDS=$( { time for IN_FILE in "$BENCH_DIR"/loop/*.in; do
+    ./hw5 < "$IN_FILE" > "${IN_FILE%.in}.ll" 2> /dev/null
+done; } 2>&1 )
+printf "  %-14s %8ss %10s files/s\n" "per process" "$LOOP_SECONDS" \
+    "$(awk -v n="$COUNT" -v t="$LOOP_SECONDS" 'BEGIN { printf "%.0f", n / t }')"
+
+for J in "${JOBS[@]}"; do
+    BATCH_SECONDS=$( { time ./hw5 --batch "$BENCH_DIR/list.txt" -j "$J" 2> /dev/null; } 2>&1 )
+    printf "  %-14s %8ss %10s files/s\n" "--batch -j $J" "$BATCH_SECONDS" \
+        "$(awk -v n="$COUNT" -v t="$BATCH_SECONDS" 'BEGIN { printf "%.0f", n / t }')"
+
+    # Batch output must match what the per-process run printed
+    for ((i = 0; i < COUNT; i++)); do
+        if ! cmp -s "$BENCH_DIR/loop/$i.ll" "$BENCH_DIR/batch/$i.ll"; then
+            echo "  ❌ output of ${SOURCES[$i]} differs"
+        fi
+    done
+done
@@ -0,0 +1,158 @@
+#!/bin/bash
+
+# Usage: ./bench.sh [scenario...]
+# Generates synthetic FanC programs and times ./hw5 on them.
+# Scenarios that generate code also report output throughput in MB/s.
+# The symtab scenario times SymbolTable alone instead, see bench/symbolTableBench.cpp.
+# With no arguments every scenario is run.
+
+# Compile the project
+make > /dev/null 2>&1
+
+# Exit if compilation fails
+if [ $? -ne 0 ]; then
+    echo "❌ Compilation failed."
+    exit 1
+fi
+
+BENCH_DIR=$(mktemp -d)
+trap 'rm -rf "$BENCH_DIR"; make clean > /dev/null' EXIT
+
+SIZES=(10000 100000 1000000)
+
+# N locals in one function, each read back once
+gen_locals() {
+    awk -v n="$1" 'BEGIN {
+        print "void main() {";
+        for (i = 0; i < n; i++) printf "    int v%d = %d;\n", i, i;
+        for (i = 1; i < n; i++) printf "    v%d = v%d;\n", i, i - 1;
+        print "}";
+    }'
+}
+
+# N locals spread over sibling blocks of ten, so every scope is unwound
+gen_scopes() {
+    awk -v n="$1" 'BEGIN {
+        print "void main() {";
+        for (i = 0; i < n; i += 10) {
+            print "    {";
+            for (j = 0; j < 10; j++) printf "        int v%d = %d;\n", j, i + j;
+            print "        printi(v9 - v0);";
+            print "    }";
+        }
+        print "}";
+    }'
+}
+
+# N functions, all registered in the global scope
+gen_funcs() {
+    awk -v n="$1" 'BEGIN {
+        for (i = 0; i < n; i++) printf "void f%d() { return; }\n", i;
+        print "void main() { f0(); }";
+    }'
+}
+
+# One function with N formals, called once with N arguments
+gen_args() {
+    awk -v n="$1" 'BEGIN {
+        printf "void f(int a0";
+        for (i = 1; i < n; i++) printf ", int a%d", i;
+        print ") { return; }";
+        printf "void main() { f(0";
+        for (i = 1; i < n; i++) printf ", %d", i;
+        print "); }";
+    }'
+}
+FLAGS_args="--parse-only"
+
+# About 45 bytes of statements per element, so 1M elements is a ~45 MB program
+gen_parse() {
+    awk -v n="$1" 'BEGIN {
+        print "void main() {";
+        print "    int x = 0;";
+        for (i = 0; i < n; i++) {
+            if (i % 2 == 0) printf "    x = (x + %d) * (x - 3) / 7 - x;\n", i;
+            else print "    if (x < 10 and not (x == 3)) printi(x + 1b);";
+        }
+        print "}";
+    }'
+}
+FLAGS_parse="--parse-only"
+
+# The parse program compiled in full, about 540 bytes of LLVM per element
+gen_emit() {
+    gen_parse "$1"
+}
+
+# N call sites of print spread over functions of 100, all printing the same five
+# texts, so string pooling decides how many globals the output has
+gen_messages() {
+    awk -v n="$1" 'BEGIN {
+        split("checking row|row ok|value out of range|done|retrying", text, "|");
+        functions = int(n / 100) > 0 ? int(n / 100) : 1;
+        print "// Many functions printing the same few messages, most of them skipped at run time";
+        for (f = 0; f < functions; f++) {
+            printf "void report%d(int level) {\n", f;
+            for (k = 0; k < 100; k++) {
+                printf "    if (level > %d) {\n", k;
+                printf "        print(\"%s\");\n", text[(f + k) % 5 + 1];
+                print "    }";
+            }
+            print "}";
+            print "";
+        }
+        print "void main() {";
+        print "    int i = 0;";
+        print "    while (i < 30) {";
+        print "        report0(i / 10);";
+        print "        i = i + 1;";
+        print "    }";
+        for (f = 1; f < functions; f++) printf "    report%d(0);\n", f;
+        print "}";
+    }'
+}
+
+# Inserts, lookups and scope pops driven straight through SymbolTable, so the
+# lexer, the parser and code generation do not hide its cost
+run_symtab() {
+    if [ ! -x "$BENCH_DIR/symtab" ]; then
+        g++ -std=c++17 -O2 -o "$BENCH_DIR/symtab" bench/symbolTableBench.cpp symbolTable.cpp || exit 1
+    fi
+    echo "  $1"
+    "$BENCH_DIR/symtab" "$1"
+}
+
+SCENARIOS=(symtab locals scopes parse funcs args emit messages)
+if [ $# -gt 0 ]; then
+    SCENARIOS=("$@")
+fi
+
+TIMEFORMAT="%R"
+
+echo "========================="
+echo "     Running Benchmarks"
+echo "========================="
+
+for SCENARIO in "${SCENARIOS[@]}"; do
+    echo ""
+    echo "▶ Scenario: $SCENARIO"
+    for N in "${SIZES[@]}"; do
+        if [ "$(type -t "run_$SCENARIO")" = "function" ]; then
+            "run_$SCENARIO" "$N"
+            continue
+        fi
+        IN_FILE="$BENCH_DIR/${SCENARIO}_$N.in"
+        "gen_$SCENARIO" "$N" > "$IN_FILE"
+        OUT_FILE="$BENCH_DIR/${SCENARIO}_$N.ll"
+        FLAGS="FLAGS_$SCENARIO"
+        SECONDS_TAKEN=$( { time ./hw5 ${!FLAGS} < "$IN_FILE" > "$OUT_FILE"; } 2>&1 )
+        BYTES=$(stat -c %s "$OUT_FILE")
+        if [ "$BYTES" -gt 0 ]; then
+            MBPS=$(awk -v b="$BYTES" -v t="$SECONDS_TAKEN" 'BEGIN { printf "%.1f", b / 1048576 / t }')
+            printf "  %-10s %8ss %10s MB/s\n" "$N" "$SECONDS_TAKEN" "$MBPS"
+        else
+            printf "  %-10s %8ss\n" "$N" "$SECONDS_TAKEN"
+        fi
+        rm -f "$OUT_FILE"
+    done
+done
@@ -0,0 +1,117 @@
+// Drives SymbolTable directly, without the lexer, the parser or code
+// generation in the way, and prints how long each access pattern takes.
+// Built and run by `./bench.sh symtab`; the argument is the number of symbols.
+#include "../symbolTable.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+    using Clock = std::chrono::steady_clock;
+
+    shared_ptr<SymbolEntry> variable(const string &name)
+    {
+        return make_shared<SymbolEntry>(name, vector<BuiltInType>{BuiltInType::INT});
+    }
+
+    shared_ptr<SymbolEntry> function(const string &name)
+    {
+        return make_shared<SymbolEntry>(name, vector<BuiltInType>{BuiltInType::INT}, true);
+    }
+
+    vector<string> names(int n, const char *prefix)
+    {
+        vector<string> result;
+        result.reserve(n);
+        for (int i = 0; i < n; ++i)
+        {
+            result.push_back(prefix + std::to_string(i));
+        }
+        return result;
+    }
+
+    // Keeps the lookups from being optimized away
+    std::size_t found = 0;
+
+    template <typename F>
+    void measure(const char *pattern, long operations, F run)
+    {
+        Clock::time_point start = Clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("    %-10s %8.3fs %8.1f ns/op\n", pattern, seconds, seconds * 1e9 / operations);
+    }
+
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? std::atoi(argv[1]) : 100000;
+    vector<string> locals = names(n, "v");
+    vector<string> functions = names(n, "f");
+
+    // n locals in one scope, then every one of them looked up
+    measure("flat", 2L * n, [&]() {
+        SymbolTable table;
+        table.beginScope();
+        for (const string &name : locals)
+        {
+            table.addEntry(variable(name));
+        }
+        for (const string &name : locals)
+        {
+            found += table.findEntry(name, false) != nullptr;
+        }
+        table.endScope();
+    });
+
+    // Blocks of ten nested ten deep, each redeclaring the names of the one
+    // around it and looking them up, then popped
+    measure("shadowed", 2L * n, [&]() {
+        SymbolTable table;
+        table.beginScope();
+        for (int block = 0; block < n; block += 100)
+        {
+            for (int depth = 0; depth < 10; ++depth)
+            {
+                table.beginScope();
+                for (int j = 0; j < 10; ++j)
+                {
+                    table.addEntry(variable(locals[j]));
+                    found += table.findEntry(locals[j], false) != nullptr;
+                }
+            }
+            for (int depth = 0; depth < 10; ++depth)
+            {
+                table.endScope();
+            }
+        }
+        table.endScope();
+    });
+
+    // n functions, looked up from inside a scope that declares none of them,
+    // and a variable of each name, which a function lookup has to skip
+    measure("global", 3L * n, [&]() {
+        SymbolTable table;
+        for (const string &name : functions)
+        {
+            table.addEntry(function(name));
+        }
+        table.beginScope();
+        for (const string &name : functions)
+        {
+            table.addEntry(variable(name));
+        }
+        for (const string &name : functions)
+        {
+            found += table.findEntry(name, true) != nullptr;
+        }
+        table.endScope();
+    });
+
+    return found == 0;
+}
@@ -0,0 +1,748 @@
+#include "boundsChecks.hpp"
+#include "cfg.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                // Values an integer may take, from lo to hi; empty if lo > hi.
+                // Bytes are seen as unsigned, 0 to 255
+                struct Range
+                {
+                        std::int64_t lo;
+                        std::int64_t hi;
+
+                        bool empty() const { return lo > hi; }
+
+                        bool operator==(const Range &other) const { return lo == other.lo && hi == other.hi; }
+
+                        bool operator!=(const Range &other) const { return !(*this == other); }
+                };
+
+                const std::int64_t intMin = std::numeric_limits<std::int32_t>::min();
+                const std::int64_t intMax = std::numeric_limits<std::int32_t>::max();
+                const Range emptyRange{1, 0};
+
+                // Follows operands through zext and adds of constants this many times
+                const int rangeDepth = 4;
+                // Updates of a value before its growing bounds jump to the type limits
+                const int wideningDelay = 3;
+                // Descending rounds that win back precision lost to widening
+                const int narrowingRounds = 2;
+
+                Range full(Type type)
+                {
+                        switch (type)
+                        {
+                        case Type::I1:
+                                return Range{0, 1};
+                        case Type::I8:
+                                return Range{0, 255};
+                        default:
+                                return Range{intMin, intMax};
+                        }
+                }
+
+                Range intersect(Range a, Range b)
+                {
+                        return Range{std::max(a.lo, b.lo), std::min(a.hi, b.hi)};
+                }
+
+                Range join(Range a, Range b)
+                {
+                        if (a.empty())
+                        {
+                                return b;
+                        }
+                        if (b.empty())
+                        {
+                                return a;
+                        }
+                        return Range{std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+                }
+
+                // r if the type holds all of it, otherwise the arithmetic may have wrapped anywhere
+                Range fit(Range r, Type type)
+                {
+                        Range all = full(type);
+                        return r.empty() || (r.lo >= all.lo && r.hi <= all.hi) ? r : all;
+                }
+
+                Predicate negate(Predicate predicate)
+                {
+                        switch (predicate)
+                        {
+                        case Predicate::EQ:
+                                return Predicate::NE;
+                        case Predicate::NE:
+                                return Predicate::EQ;
+                        case Predicate::SLT:
+                                return Predicate::SGE;
+                        case Predicate::SGT:
+                                return Predicate::SLE;
+                        case Predicate::SLE:
+                                return Predicate::SGT;
+                        case Predicate::SGE:
+                                return Predicate::SLT;
+                        case Predicate::ULT:
+                                return Predicate::UGE;
+                        case Predicate::UGT:
+                                return Predicate::ULE;
+                        case Predicate::ULE:
+                                return Predicate::UGT;
+                        default:
+                                return Predicate::ULT;
+                        }
+                }
+
+                // The predicate with its operands exchanged, a < b as b > a
+                Predicate swap(Predicate predicate)
+                {
+                        switch (predicate)
+                        {
+                        case Predicate::SLT:
+                                return Predicate::SGT;
+                        case Predicate::SGT:
+                                return Predicate::SLT;
+                        case Predicate::SLE:
+                                return Predicate::SGE;
+                        case Predicate::SGE:
+                                return Predicate::SLE;
+                        case Predicate::ULT:
+                                return Predicate::UGT;
+                        case Predicate::UGT:
+                                return Predicate::ULT;
+                        case Predicate::ULE:
+                                return Predicate::UGE;
+                        case Predicate::UGE:
+                                return Predicate::ULE;
+                        default:
+                                return predicate;
+                        }
+                }
+
+                // Narrows r, the range of x, knowing that "x predicate y" holds for y in bound
+                Range restrict(Range r, Predicate predicate, Range bound)
+                {
+                        if (bound.empty())
+                        {
+                                return r;
+                        }
+                        switch (predicate)
+                        {
+                        case Predicate::EQ:
+                                return intersect(r, bound);
+                        case Predicate::NE:
+                                if (bound.lo == bound.hi && r.lo == bound.lo)
+                                {
+                                        ++r.lo;
+                                }
+                                else if (bound.lo == bound.hi && r.hi == bound.lo)
+                                {
+                                        --r.hi;
+                                }
+                                return r;
+                        case Predicate::SLT:
+                                return intersect(r, Range{intMin, bound.hi - 1});
+                        case Predicate::SLE:
+                                return intersect(r, Range{intMin, bound.hi});
+                        case Predicate::SGT:
+                                return intersect(r, Range{bound.lo + 1, intMax});
+                        case Predicate::SGE:
+                                return intersect(r, Range{bound.lo, intMax});
+                        // Below a non-negative bound, unsigned, means non-negative too
+                        case Predicate::ULT:
+                                return bound.lo >= 0 ? intersect(r, Range{0, bound.hi - 1}) : r;
+                        case Predicate::ULE:
+                                return bound.lo >= 0 ? intersect(r, Range{0, bound.hi}) : r;
+                        case Predicate::UGT:
+                                return bound.lo >= 0 && r.lo >= 0 ? intersect(r, Range{bound.lo + 1, intMax}) : r;
+                        default:
+                                return bound.lo >= 0 && r.lo >= 0 ? intersect(r, Range{bound.lo, intMax}) : r;
+                        }
+                }
+
+                // "value predicate bound" holds in block and every block it dominates
+                struct Constraint
+                {
+                        Block *block;
+                        Predicate predicate;
+                        Value bound;
+                };
+
+                // A bounds check: the compare of the index against the length, and
+                // the block ending in the branch on it
+                struct Check
+                {
+                        Block *block;
+                        Instruction *compare;
+                };
+
+                // Type of the value an instruction defines, VOID if none is an integer
+                Type resultType(const Instruction &instruction)
+                {
+                        switch (instruction.op)
+                        {
+                        case Opcode::ICMP:
+                                return Type::I1;
+                        case Opcode::ALLOCA:
+                        case Opcode::GEP:
+                        case Opcode::BITCAST:
+                        case Opcode::STORE:
+                        case Opcode::BR:
+                        case Opcode::COND_BR:
+                        case Opcode::RET:
+                        case Opcode::UNREACHABLE:
+                                return Type::VOID;
+                        default:
+                                return instruction.type == Type::I8_PTR || instruction.type == Type::I64
+                                           ? Type::VOID
+                                           : instruction.type;
+                        }
+                }
+
+                // Calls that may print, read or never return must still happen before a failing check
+                bool observable(const Instruction &instruction)
+                {
+                        return instruction.op == Opcode::CALL && std::strncmp(instruction.callee, "llvm.", 5) != 0;
+                }
+
+                void unlink(Block *block, Instruction *instruction)
+                {
+                        Instruction *previous = nullptr;
+                        for (Instruction *i = block->first; i != instruction; i = i->next)
+                        {
+                                previous = i;
+                        }
+                        (previous ? previous->next : block->first) = instruction->next;
+                        if (block->last == instruction)
+                        {
+                                block->last = previous;
+                        }
+                        instruction->next = nullptr;
+                }
+
+                void insertBefore(Block *block, Instruction *position, Instruction *instruction)
+                {
+                        Instruction *previous = nullptr;
+                        for (Instruction *i = block->first; i != position; i = i->next)
+                        {
+                                previous = i;
+                        }
+                        (previous ? previous->next : block->first) = instruction;
+                        instruction->next = position;
+                }
+
+                void replaceEdge(std::vector<Block *> &blocks, Block *from, Block *to)
+                {
+                        std::replace(blocks.begin(), blocks.end(), from, to);
+                }
+
+                void removeEdge(std::vector<Block *> &blocks, Block *block)
+                {
+                        auto found = std::find(blocks.begin(), blocks.end(), block);
+                        if (found != blocks.end())
+                        {
+                                blocks.erase(found);
+                        }
+                }
+
+                /* BoundsCheckElimination class
+                 * Range of every integer temporary of a function, where it is defined,
+                 * and the conditions the branches of the function establish.
+                 */
+                class BoundsCheckElimination
+                {
+                private:
+                        Function &function;
+                        // By temporary: the instruction defining it, its block and its range there
+                        std::vector<Instruction *> definitions;
+                        std::vector<Block *> definedIn;
+                        std::vector<Range> ranges;
+                        std::vector<int> updates;
+                        std::vector<std::vector<Constraint>> constraints;
+                        std::vector<int> uses;
+                        // Preorder and postorder numbers in the dominator tree, by block index
+                        std::vector<int> enter;
+                        std::vector<int> leave;
+
+                        bool dominates(const Block *a, const Block *b) const
+                        {
+                                return enter[a->index] <= enter[b->index] && leave[b->index] <= leave[a->index];
+                        }
+
+                        Range lookup(Value value, Type type) const
+                        {
+                                switch (value.kind)
+                                {
+                                case Value::Kind::CONSTANT:
+                                        return fit(Range{value.id, value.id}, type);
+                                case Value::Kind::TEMP:
+                                        return definitions[value.id] ? ranges[value.id] : full(type);
+                                default:
+                                        return full(type);
+                                }
+                        }
+
+                        // Range of value in block: where it is defined, narrowed by the
+                        // constraints of the blocks that dominate block
+                        Range rangeAt(Value value, Type type, const Block *block, int depth) const
+                        {
+                                Range r = lookup(value, type);
+                                if (value.kind != Value::Kind::TEMP || r.empty())
+                                {
+                                        return r;
+                                }
+                                const Instruction *definition = definitions[value.id];
+                                if (definition && depth > 0)
+                                {
+                                        if (definition->op == Opcode::ZEXT)
+                                        {
+                                                Range source = rangeAt(definition->lhs, definition->sourceType, block, depth - 1);
+                                                r = intersect(r, fit(source, definition->sourceType));
+                                        }
+                                        else if ((definition->op == Opcode::ADD || definition->op == Opcode::SUB) &&
+                                                 definition->type == Type::I32)
+                                        {
+                                                r = intersect(r, offsetAt(*definition, block, depth - 1));
+                                        }
+                                }
+                                if (definition)
+                                {
+                                        for (const Constraint &constraint : constraints[value.id])
+                                        {
+                                                if (dominates(constraint.block, block))
+                                                {
+                                                        r = restrict(r, constraint.predicate, lookup(constraint.bound, Type::I32));
+                                                }
+                                        }
+                                }
+                                return r;
+                        }
+
+                        // Range in block of x + c, x - c or c + x, or everything if neither side is constant
+                        Range offsetAt(const Instruction &instruction, const Block *block, int depth) const
+                        {
+                                bool add = instruction.op == Opcode::ADD;
+                                Value operand = instruction.lhs;
+                                Value offset = instruction.rhs;
+                                if (add && operand.kind == Value::Kind::CONSTANT)
+                                {
+                                        std::swap(operand, offset);
+                                }
+                                if (offset.kind != Value::Kind::CONSTANT)
+                                {
+                                        return full(Type::I32);
+                                }
+                                Range r = rangeAt(operand, Type::I32, block, depth);
+                                std::int64_t c = add ? offset.id : -static_cast<std::int64_t>(offset.id);
+                                return r.empty() ? r : fit(Range{r.lo + c, r.hi + c}, Type::I32);
+                        }
+
+                        Range evaluate(const Instruction &instruction, const Block *block) const
+                        {
+                                Type type = resultType(instruction);
+                                switch (instruction.op)
+                                {
+                                case Opcode::ADD:
+                                case Opcode::SUB:
+                                case Opcode::MUL:
+                                case Opcode::SDIV:
+                                {
+                                        Range a = rangeAt(instruction.lhs, type, block, rangeDepth);
+                                        Range b = rangeAt(instruction.rhs, type, block, rangeDepth);
+                                        if (a.empty() || b.empty())
+                                        {
+                                                return emptyRange;
+                                        }
+                                        if (instruction.op == Opcode::ADD)
+                                        {
+                                                return fit(Range{a.lo + b.lo, a.hi + b.hi}, type);
+                                        }
+                                        if (instruction.op == Opcode::SUB)
+                                        {
+                                                return fit(Range{a.lo - b.hi, a.hi - b.lo}, type);
+                                        }
+                                        // Bytes divide as signed i8, their unsigned view says nothing
+                                        if (instruction.op == Opcode::SDIV && (type != Type::I32 || (b.lo <= 0 && b.hi >= 0)))
+                                        {
+                                                return full(type);
+                                        }
+                                        std::int64_t corners[4];
+                                        for (int k = 0; k < 4; ++k)
+                                        {
+                                                std::int64_t x = k & 1 ? a.hi : a.lo;
+                                                std::int64_t y = k & 2 ? b.hi : b.lo;
+                                                corners[k] = instruction.op == Opcode::MUL ? x * y : x / y;
+                                        }
+                                        return fit(Range{*std::min_element(corners, corners + 4),
+                                                         *std::max_element(corners, corners + 4)},
+                                                   type);
+                                }
+                                case Opcode::ZEXT:
+                                        return fit(rangeAt(instruction.lhs, instruction.sourceType, block, rangeDepth),
+                                                   instruction.sourceType);
+                                case Opcode::TRUNC:
+                                        return fit(rangeAt(instruction.lhs, instruction.sourceType, block, rangeDepth), type);
+                                case Opcode::PHI:
+                                {
+                                        Range r = emptyRange;
+                                        for (int k = 0; k < instruction.incomingCount; ++k)
+                                        {
+                                                const Incoming &in = instruction.incoming[k];
+                                                r = join(r, rangeAt(in.value, type, in.block, rangeDepth));
+                                        }
+                                        return r;
+                                }
+                                default:
+                                        return full(type);
+                                }
+                        }
+
+                        void numberDominatorTree(const DominatorTree &tree)
+                        {
+                                size_t count = tree.order().size();
+                                enter.assign(count, 0);
+                                leave.assign(count, 0);
+                                int clock = 0;
+                                std::vector<std::pair<Block *, size_t>> stack{{tree.order().front(), 0}};
+                                enter[0] = clock++;
+                                while (!stack.empty())
+                                {
+                                        auto &top = stack.back();
+                                        const std::vector<Block *> &children = tree.children(top.first);
+                                        if (top.second < children.size())
+                                        {
+                                                Block *child = children[top.second++];
+                                                enter[child->index] = clock++;
+                                                stack.push_back({child, 0});
+                                        }
+                                        else
+                                        {
+                                                leave[top.first->index] = clock++;
+                                                stack.pop_back();
+                                        }
+                                }
+                        }
+
+                        void findDefinitions(const DominatorTree &tree)
+                        {
+                                definitions.assign(function.tempCount, nullptr);
+                                definedIn.assign(function.tempCount, nullptr);
+                                uses.assign(function.tempCount, 0);
+                                for (Block *block : tree.order())
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                if (i->result.kind == Value::Kind::TEMP && resultType(*i) != Type::VOID)
+                                                {
+                                                        definitions[i->result.id] = i;
+                                                        definedIn[i->result.id] = block;
+                                                }
+                                                i->forEachOperand([&](Value &operand) {
+                                                        if (operand.kind == Value::Kind::TEMP)
+                                                        {
+                                                                ++uses[operand.id];
+                                                        }
+                                                });
+                                        }
+                                }
+                        }
+
+                        // Constrains value, and the byte it extends if it is a zext
+                        void addConstraint(Value value, Predicate predicate, Value bound, Block *block)
+                        {
+                                while (value.kind == Value::Kind::TEMP && definitions[value.id])
+                                {
+                                        constraints[value.id].push_back(Constraint{block, predicate, bound});
+                                        const Instruction *definition = definitions[value.id];
+                                        if (definition->op != Opcode::ZEXT)
+                                        {
+                                                break;
+                                        }
+                                        value = definition->lhs;
+                                }
+                        }
+
+                        // A block entered only by one side of a compare learns the outcome of the compare
+                        void findConstraints(const DominatorTree &tree)
+                        {
+                                constraints.assign(function.tempCount, {});
+                                for (Block *block : tree.order())
+                                {
+                                        if (block->predecessors.size() != 1)
+                                        {
+                                                continue;
+                                        }
+                                        const Instruction *branch = block->predecessors.front()->last;
+                                        if (!branch || branch->op != Opcode::COND_BR || branch->target == branch->otherwise ||
+                                            branch->lhs.kind != Value::Kind::TEMP)
+                                        {
+                                                continue;
+                                        }
+                                        const Instruction *compare = definitions[branch->lhs.id];
+                                        if (!compare || compare->op != Opcode::ICMP || compare->type != Type::I32)
+                                        {
+                                                continue;
+                                        }
+                                        Predicate predicate = branch->target == block ? compare->predicate
+                                                                                      : negate(compare->predicate);
+                                        addConstraint(compare->lhs, predicate, compare->rhs, block);
+                                        addConstraint(compare->rhs, swap(predicate), compare->lhs, block);
+                                }
+                        }
+
+                        // Widens growing ranges to a fixed point, then narrows them back
+                        void computeRanges(const DominatorTree &tree)
+                        {
+                                ranges.assign(function.tempCount, emptyRange);
+                                updates.assign(function.tempCount, 0);
+                                bool changed = true;
+                                while (changed)
+                                {
+                                        changed = false;
+                                        for (Block *block : tree.order())
+                                        {
+                                                for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                                {
+                                                        Type type = resultType(*i);
+                                                        if (type == Type::VOID || i->result.kind != Value::Kind::TEMP)
+                                                        {
+                                                                continue;
+                                                        }
+                                                        Range &r = ranges[i->result.id];
+                                                        Range next = join(r, evaluate(*i, block));
+                                                        if (next == r)
+                                                        {
+                                                                continue;
+                                                        }
+                                                        if (!r.empty() && ++updates[i->result.id] > wideningDelay)
+                                                        {
+                                                                Range all = full(type);
+                                                                next.lo = next.lo < r.lo ? all.lo : next.lo;
+                                                                next.hi = next.hi > r.hi ? all.hi : next.hi;
+                                                        }
+                                                        r = next;
+                                                        changed = true;
+                                                }
+                                        }
+                                }
+
+                                for (int round = 0; round < narrowingRounds; ++round)
+                                {
+                                        for (Block *block : tree.order())
+                                        {
+                                                for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                                {
+                                                        if (resultType(*i) != Type::VOID && i->result.kind == Value::Kind::TEMP)
+                                                        {
+                                                                Range &r = ranges[i->result.id];
+                                                                r = intersect(r, evaluate(*i, block));
+                                                        }
+                                                }
+                                        }
+                                }
+                        }
+
+                        std::vector<Check> findChecks(const DominatorTree &tree) const
+                        {
+                                std::vector<Check> checks;
+                                for (Block *block : tree.order())
+                                {
+                                        const Instruction *branch = block->last;
+                                        if (!branch || branch->op != Opcode::COND_BR || branch->lhs.kind != Value::Kind::TEMP ||
+                                            branch->target->successors.size() != 0 || branch->target->last == nullptr ||
+                                            branch->target->last->op != Opcode::UNREACHABLE)
+                                        {
+                                                continue;
+                                        }
+                                        Instruction *compare = definitions[branch->lhs.id];
+                                        if (compare && compare->op == Opcode::ICMP && compare->predicate == Predicate::UGE &&
+                                            compare->type == Type::I32 && compare->rhs.kind == Value::Kind::CONSTANT &&
+                                            definedIn[branch->lhs.id] == block)
+                                        {
+                                                checks.push_back(Check{block, compare});
+                                        }
+                                }
+                                return checks;
+                        }
+
+                        bool provenInBounds(const Check &check) const
+                        {
+                                Range index = rangeAt(check.compare->lhs, Type::I32, check.block, rangeDepth);
+                                return !index.empty() && index.lo >= 0 && index.hi < check.compare->rhs.id;
+                        }
+
+                        // The check always passes: branch straight on, drop the error edge and the compare
+                        void remove(const Check &check)
+                        {
+                                Instruction *branch = check.block->last;
+                                Block *error = branch->target;
+                                branch->op = Opcode::BR;
+                                branch->target = branch->otherwise;
+                                branch->otherwise = nullptr;
+                                branch->lhs = Value();
+                                removeEdge(check.block->successors, error);
+                                removeEdge(error->predecessors, check.block);
+                                if (--uses[check.compare->result.id] == 0)
+                                {
+                                        unlink(check.block, check.compare);
+                                }
+                        }
+
+                        // The only block that enters the loop headed by block, ending in a
+                        // branch to it; nullptr if block heads no loop or has no such block
+                        Block *preheader(Block *block) const
+                        {
+                                Block *entering = nullptr;
+                                bool loop = false;
+                                for (Block *predecessor : block->predecessors)
+                                {
+                                        if (dominates(block, predecessor))
+                                        {
+                                                loop = true;
+                                        }
+                                        else if (entering)
+                                        {
+                                                return nullptr;
+                                        }
+                                        else
+                                        {
+                                                entering = predecessor;
+                                        }
+                                }
+                                if (!loop || !entering || entering->successors.size() != 1 || entering->last->op != Opcode::BR)
+                                {
+                                        return nullptr;
+                                }
+                                return entering;
+                        }
+
+                        // A check the header runs before anything observable, on an index
+                        // defined outside the loop, passes or fails the same on every iteration
+                        bool invariant(const Check &check) const
+                        {
+                                Value index = check.compare->lhs;
+                                if (index.kind == Value::Kind::TEMP &&
+                                    (!definedIn[index.id] || definedIn[index.id] == check.block ||
+                                     !dominates(definedIn[index.id], check.block)))
+                                {
+                                        return false;
+                                }
+                                for (const Instruction *i = check.block->first; i != check.block->last; i = i->next)
+                                {
+                                        if (observable(*i))
+                                        {
+                                                return false;
+                                        }
+                                }
+                                return true;
+                        }
+
+                        // Moves the check to the end of the preheader, ahead of a new block
+                        // that enters the loop once the check has passed
+                        void hoist(const Check &check, Block *preheader)
+                        {
+                                Block *header = check.block;
+                                Instruction *branch = header->last;
+                                Block *error = branch->target;
+                                branch->op = Opcode::BR;
+                                branch->target = branch->otherwise;
+                                branch->otherwise = nullptr;
+                                branch->lhs = Value();
+                                removeEdge(header->successors, error);
+
+                                ast::Arena &arena = function.storage();
+                                Block *landing = arena.make<Block>(function.labelCount++);
+                                Instruction *enter = arena.make<Instruction>(Opcode::BR);
+                                enter->target = header;
+                                landing->first = landing->last = enter;
+                                landing->predecessors.push_back(preheader);
+                                landing->successors.push_back(header);
+                                replaceEdge(header->predecessors, preheader, landing);
+                                for (Instruction *i = header->first; i != nullptr && i->op == Opcode::PHI; i = i->next)
+                                {
+                                        for (int k = 0; k < i->incomingCount; ++k)
+                                        {
+                                                if (i->incoming[k].block == preheader)
+                                                {
+                                                        i->incoming[k].block = landing;
+                                                }
+                                        }
+                                }
+
+                                Instruction *jump = preheader->last;
+                                unlink(header, check.compare);
+                                insertBefore(preheader, jump, check.compare);
+                                jump->op = Opcode::COND_BR;
+                                jump->lhs = check.compare->result;
+                                jump->target = error;
+                                jump->otherwise = landing;
+                                preheader->successors.assign({error, landing});
+                                replaceEdge(error->predecessors, header, preheader);
+
+                                auto position = std::find(function.blocks.begin(), function.blocks.end(), preheader);
+                                function.blocks.insert(position + 1, landing);
+                        }
+
+                public:
+                        explicit BoundsCheckElimination(Function &function) : function(function) {}
+
+                        BoundsCheckCounts run()
+                        {
+                                BoundsCheckCounts counts;
+                                removeUnreachableBlocks(function);
+                                DominatorTree tree(function);
+                                numberDominatorTree(tree);
+                                findDefinitions(tree);
+                                std::vector<Check> checks = findChecks(tree);
+                                counts.total = static_cast<int>(checks.size());
+                                if (checks.empty())
+                                {
+                                        return counts;
+                                }
+                                findConstraints(tree);
+                                computeRanges(tree);
+
+                                // Decided on the ranges of the original function, every removed check was implied anyway
+                                std::vector<Check> kept;
+                                std::vector<Check> proven;
+                                for (const Check &check : checks)
+                                {
+                                        (provenInBounds(check) ? proven : kept).push_back(check);
+                                }
+                                for (const Check &check : proven)
+                                {
+                                        remove(check);
+                                }
+                                counts.removed = static_cast<int>(proven.size());
+
+                                for (const Check &check : kept)
+                                {
+                                        Block *entering = preheader(check.block);
+                                        if (entering && invariant(check))
+                                        {
+                                                hoist(check, entering);
+                                                ++counts.hoisted;
+                                        }
+                                }
+                                removeUnreachableBlocks(function);
+                                return counts;
+                        }
+                };
+
+        }
+
+        BoundsCheckCounts eliminateBoundsChecks(Function &function)
+        {
+                return BoundsCheckElimination(function).run();
+        }
+
+}
@@ -0,0 +1,27 @@
+#ifndef BOUNDS_CHECKS_HPP
+#define BOUNDS_CHECKS_HPP
+
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // Array bounds checks of one function, and what became of them
+    struct BoundsCheckCounts
+    {
+        int total = 0;
+        int removed = 0;
+        int hoisted = 0;
+    };
+
+    // Removes the array bounds checks that value ranges prove to pass. Ranges
+    // come from constants, arithmetic, phis and the branches that dominate a
+    // check, such as the condition of a counted while loop. A remaining check
+    // at the top of a loop header whose index does not change in the loop moves
+    // to the preheader, where it runs once. A check is a branch on
+    // "icmp uge i32 index, length" to a block that never falls through
+    BoundsCheckCounts eliminateBoundsChecks(Function &function);
+
+}
+
+#endif // BOUNDS_CHECKS_HPP
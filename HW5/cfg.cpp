@@ -0,0 +1,392 @@
+#include "cfg.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                bool hasPhis(const Block *block)
+                {
+                        return block->first != nullptr && block->first->op == Opcode::PHI;
+                }
+
+                // Makes the phis of block name to where they named from
+                void renameIncoming(Function &function, Block *block, const Block *from, Block *to)
+                {
+                        // The entry block needs a name once a phi refers to it
+                        if (to->label < 0 && hasPhis(block))
+                        {
+                                to->label = function.labelCount++;
+                        }
+                        for (Instruction *i = block->first; i != nullptr && i->op == Opcode::PHI; i = i->next)
+                        {
+                                for (int k = 0; k < i->incomingCount; ++k)
+                                {
+                                        if (i->incoming[k].block == from)
+                                        {
+                                                i->incoming[k].block = to;
+                                        }
+                                }
+                        }
+                }
+
+                // Drops one edge from -> to, and the phi entries for from once no edge is left
+                void removeEdge(Block *from, Block *to)
+                {
+                        auto &successors = from->successors;
+                        successors.erase(std::find(successors.begin(), successors.end(), to));
+                        auto &predecessors = to->predecessors;
+                        predecessors.erase(std::find(predecessors.begin(), predecessors.end(), from));
+                        if (std::find(predecessors.begin(), predecessors.end(), from) != predecessors.end())
+                        {
+                                return;
+                        }
+                        for (Instruction *i = to->first; i != nullptr && i->op == Opcode::PHI; i = i->next)
+                        {
+                                Incoming *end = std::remove_if(i->incoming, i->incoming + i->incomingCount,
+                                                               [&](const Incoming &in) { return in.block == from; });
+                                i->incomingCount = static_cast<int>(end - i->incoming);
+                        }
+                }
+
+                // A conditional branch on a constant, or to one block either way, becomes a jump
+                bool foldBranch(Block *block)
+                {
+                        Instruction *branch = block->last;
+                        if (branch == nullptr || branch->op != Opcode::COND_BR)
+                        {
+                                return false;
+                        }
+                        Block *taken = branch->target;
+                        Block *dropped = branch->otherwise;
+                        if (taken != dropped)
+                        {
+                                if (branch->lhs.kind != Value::Kind::CONSTANT)
+                                {
+                                        return false;
+                                }
+                                if (branch->lhs.id == 0)
+                                {
+                                        std::swap(taken, dropped);
+                                }
+                        }
+                        removeEdge(block, dropped);
+                        branch->op = Opcode::BR;
+                        branch->lhs = Value();
+                        branch->target = taken;
+                        branch->otherwise = nullptr;
+                        return true;
+                }
+
+                // Points the predecessors of a block that only jumps on at its
+                // successor. A phi there has one entry per predecessor, so it
+                // can only take over a single predecessor it does not have yet
+                bool bypass(Function &function, Block *block)
+                {
+                        Block *successor = block->successors.front();
+                        if (successor == block)
+                        {
+                                return false;
+                        }
+                        auto &incoming = successor->predecessors;
+                        if (hasPhis(successor))
+                        {
+                                if (block->predecessors.size() != 1 ||
+                                    std::find(incoming.begin(), incoming.end(), block->predecessors.front()) != incoming.end())
+                                {
+                                        return false;
+                                }
+                                renameIncoming(function, successor, block, block->predecessors.front());
+                        }
+
+                        for (Block *predecessor : block->predecessors)
+                        {
+                                Instruction *branch = predecessor->last;
+                                if (branch->target == block)
+                                {
+                                        branch->target = successor;
+                                }
+                                if (branch->otherwise == block)
+                                {
+                                        branch->otherwise = successor;
+                                }
+                                std::replace(predecessor->successors.begin(), predecessor->successors.end(), block, successor);
+                                incoming.push_back(predecessor);
+                        }
+                        incoming.erase(std::find(incoming.begin(), incoming.end(), block));
+                        block->predecessors.clear();
+                        block->successors.clear();
+                        return true;
+                }
+
+                // Appends a block to its only predecessor, when that jumps nowhere else
+                bool merge(Function &function, Block *block)
+                {
+                        // Without a terminator of its own, block cannot take the place of the jump
+                        if (block->predecessors.size() != 1 || hasPhis(block) || !block->isTerminated())
+                        {
+                                return false;
+                        }
+                        Block *predecessor = block->predecessors.front();
+                        if (predecessor == block || predecessor->successors.size() != 1)
+                        {
+                                return false;
+                        }
+
+                        // The jump goes, the code of block takes its place
+                        Instruction *jump = predecessor->last;
+                        if (predecessor->first == jump)
+                        {
+                                predecessor->first = block->first;
+                        }
+                        else
+                        {
+                                Instruction *previous = predecessor->first;
+                                while (previous->next != jump)
+                                {
+                                        previous = previous->next;
+                                }
+                                previous->next = block->first;
+                        }
+                        predecessor->last = block->last;
+
+                        predecessor->successors = block->successors;
+                        for (Block *successor : block->successors)
+                        {
+                                std::replace(successor->predecessors.begin(), successor->predecessors.end(), block,
+                                             predecessor);
+                                renameIncoming(function, successor, block, predecessor);
+                        }
+                        block->first = block->last = nullptr;
+                        block->predecessors.clear();
+                        block->successors.clear();
+                        return true;
+                }
+
+        }
+
+        int removeUnreachableBlocks(Function &function)
+        {
+                for (Block *block : function.blocks)
+                {
+                        block->index = -1;
+                }
+                std::vector<Block *> stack{function.blocks.front()};
+                function.blocks.front()->index = 0;
+                while (!stack.empty())
+                {
+                        Block *block = stack.back();
+                        stack.pop_back();
+                        for (Block *successor : block->successors)
+                        {
+                                if (successor->index < 0)
+                                {
+                                        successor->index = 0;
+                                        stack.push_back(successor);
+                                }
+                        }
+                }
+
+                auto unreachable = [](const Block *block) { return block->index < 0; };
+                auto removed = std::remove_if(function.blocks.begin(), function.blocks.end(), unreachable);
+                int count = static_cast<int>(function.blocks.end() - removed);
+                if (count == 0)
+                {
+                        return 0;
+                }
+                function.blocks.erase(removed, function.blocks.end());
+                for (Block *block : function.blocks)
+                {
+                        auto &predecessors = block->predecessors;
+                        predecessors.erase(std::remove_if(predecessors.begin(), predecessors.end(), unreachable),
+                                           predecessors.end());
+
+                        // Phis of jumping code may name a removed predecessor
+                        for (Instruction *i = block->first; i != nullptr && i->op == Opcode::PHI; i = i->next)
+                        {
+                                Incoming *end = std::remove_if(i->incoming, i->incoming + i->incomingCount,
+                                                               [&](const Incoming &in) { return unreachable(in.block); });
+                                i->incomingCount = static_cast<int>(end - i->incoming);
+                        }
+                }
+                return count;
+        }
+
+        int simplifyControlFlow(Function &function)
+        {
+                std::size_t blocks = function.blocks.size();
+                bool changed = true;
+                while (changed)
+                {
+                        changed = false;
+                        for (Block *block : function.blocks)
+                        {
+                                changed |= foldBranch(block);
+                        }
+                        removeUnreachableBlocks(function);
+
+                        // The entry block has no predecessors, so it is neither bypassed nor
+                        // merged, and neither is a block that does not end in a terminator
+                        for (Block *block : function.blocks)
+                        {
+                                if (block->predecessors.empty() || !block->isTerminated())
+                                {
+                                        continue;
+                                }
+                                if (block->first == block->last && block->first->op == Opcode::BR)
+                                {
+                                        changed |= bypass(function, block);
+                                }
+                                else
+                                {
+                                        changed |= merge(function, block);
+                                }
+                        }
+                        removeUnreachableBlocks(function);
+                }
+                return static_cast<int>(blocks - function.blocks.size());
+        }
+
+        DominatorTree::DominatorTree(Function &function)
+        {
+                for (Block *block : function.blocks)
+                {
+                        block->index = -1;
+                }
+
+                // Postorder by an explicit depth-first walk, deep CFGs would overflow the stack
+                std::vector<Block *> postorder;
+                std::vector<std::pair<Block *, size_t>> stack{{function.blocks.front(), 0}};
+                function.blocks.front()->index = 0;
+                while (!stack.empty())
+                {
+                        auto &top = stack.back();
+                        if (top.second < top.first->successors.size())
+                        {
+                                Block *successor = top.first->successors[top.second++];
+                                if (successor->index < 0)
+                                {
+                                        successor->index = 0;
+                                        stack.push_back({successor, 0});
+                                }
+                        }
+                        else
+                        {
+                                postorder.push_back(top.first);
+                                stack.pop_back();
+                        }
+                }
+                blocks.assign(postorder.rbegin(), postorder.rend());
+                for (size_t i = 0; i < blocks.size(); ++i)
+                {
+                        blocks[i]->index = static_cast<int>(i);
+                }
+
+                // Iterate to the fixed point, every block after its reachable predecessors
+                idoms.assign(blocks.size(), -1);
+                idoms[0] = 0;
+                bool changed = true;
+                while (changed)
+                {
+                        changed = false;
+                        for (size_t i = 1; i < blocks.size(); ++i)
+                        {
+                                int newIdom = -1;
+                                for (const Block *predecessor : blocks[i]->predecessors)
+                                {
+                                        int p = predecessor->index;
+                                        if (p < 0 || idoms[p] < 0)
+                                        {
+                                                continue;
+                                        }
+                                        if (newIdom < 0)
+                                        {
+                                                newIdom = p;
+                                                continue;
+                                        }
+                                        int a = p;
+                                        int b = newIdom;
+                                        while (a != b)
+                                        {
+                                                while (a > b)
+                                                {
+                                                        a = idoms[a];
+                                                }
+                                                while (b > a)
+                                                {
+                                                        b = idoms[b];
+                                                }
+                                        }
+                                        newIdom = a;
+                                }
+                                if (idoms[i] != newIdom)
+                                {
+                                        idoms[i] = newIdom;
+                                        changed = true;
+                                }
+                        }
+                }
+
+                childLists.assign(blocks.size(), {});
+                frontiers.assign(blocks.size(), {});
+                for (size_t i = 1; i < blocks.size(); ++i)
+                {
+                        childLists[idoms[i]].push_back(blocks[i]);
+                }
+                for (size_t i = 0; i < blocks.size(); ++i)
+                {
+                        if (blocks[i]->predecessors.size() < 2)
+                        {
+                                continue;
+                        }
+                        for (const Block *predecessor : blocks[i]->predecessors)
+                        {
+                                int runner = predecessor->index;
+                                while (runner >= 0 && runner != idoms[i])
+                                {
+                                        auto &frontier = frontiers[runner];
+                                        if (frontier.empty() || frontier.back() != blocks[i])
+                                        {
+                                                frontier.push_back(blocks[i]);
+                                        }
+                                        runner = runner == 0 ? -1 : idoms[runner];
+                                }
+                        }
+                }
+        }
+
+        const std::vector<Block *> &DominatorTree::order() const
+        {
+                return blocks;
+        }
+
+        Block *DominatorTree::idom(const Block *block) const
+        {
+                return block->index > 0 ? blocks[idoms[block->index]] : nullptr;
+        }
+
+        const std::vector<Block *> &DominatorTree::children(const Block *block) const
+        {
+                return childLists[block->index];
+        }
+
+        const std::vector<Block *> &DominatorTree::frontier(const Block *block) const
+        {
+                return frontiers[block->index];
+        }
+
+        bool DominatorTree::dominates(const Block *a, const Block *b) const
+        {
+                int target = a->index;
+                int runner = b->index;
+                while (runner > target)
+                {
+                        runner = idoms[runner];
+                }
+                return runner == target;
+        }
+
+}
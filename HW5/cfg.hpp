@@ -0,0 +1,53 @@
+#ifndef CFG_HPP
+#define CFG_HPP
+
+#include <vector>
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // Drops the blocks no path from the entry reaches, such as the code after a
+    // return, their edges and the phi entries that name them. Returns the
+    // number of blocks removed
+    int removeUnreachableBlocks(Function &function);
+
+    // Turns branches on a constant condition into jumps, then removes the
+    // blocks that leaves unreachable, blocks that only jump on, and the jumps
+    // into a block that has no other predecessor, by merging the two. Returns
+    // the number of blocks removed
+    int simplifyControlFlow(Function &function);
+
+    /* DominatorTree class
+     * Immediate dominators and dominance frontiers of the reachable blocks of a
+     * function, after Cooper, Harvey and Kennedy. Numbers every block: its
+     * index is its reverse postorder position, -1 if it is unreachable.
+     * The tree is a snapshot; it must be rebuilt after the CFG changes.
+     */
+    class DominatorTree
+    {
+    private:
+        std::vector<Block *> blocks;
+        std::vector<int> idoms;
+        std::vector<std::vector<Block *>> childLists;
+        std::vector<std::vector<Block *>> frontiers;
+
+    public:
+        explicit DominatorTree(Function &function);
+
+        // Reachable blocks in reverse postorder, the entry block first
+        const std::vector<Block *> &order() const;
+
+        // nullptr for the entry block
+        Block *idom(const Block *block) const;
+
+        const std::vector<Block *> &children(const Block *block) const;
+
+        const std::vector<Block *> &frontier(const Block *block) const;
+
+        bool dominates(const Block *a, const Block *b) const;
+    };
+
+}
+
+#endif // CFG_HPP
@@ -0,0 +1,101 @@
+#include "chunkBuffer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <sys/uio.h>
+
+namespace output {
+    ChunkBuffer::ChunkBuffer() : chunks(), totalSize(0) {}
+
+    char *ChunkBuffer::reserve(std::size_t n) {
+        if (chunks.empty() || chunks.back().capacity - chunks.back().size < n) {
+            std::size_t capacity = std::max(chunkSize, n);
+            chunks.push_back(Chunk{std::unique_ptr<char[]>(new char[capacity]), 0, capacity});
+        }
+        return chunks.back().data.get() + chunks.back().size;
+    }
+
+    void ChunkBuffer::append(const char *data, std::size_t n) {
+        totalSize += n;
+        // Top up the current chunk first, so chunks stay full
+        if (!chunks.empty()) {
+            Chunk &last = chunks.back();
+            std::size_t fits = std::min(n, last.capacity - last.size);
+            std::memcpy(last.data.get() + last.size, data, fits);
+            last.size += fits;
+            data += fits;
+            n -= fits;
+        }
+        if (n > 0) {
+            std::memcpy(reserve(n), data, n);
+            chunks.back().size += n;
+        }
+    }
+
+    void ChunkBuffer::splice(ChunkBuffer &&other) {
+        for (auto &chunk : other.chunks) {
+            chunks.push_back(std::move(chunk));
+        }
+        totalSize += other.totalSize;
+        other.chunks.clear();
+        other.totalSize = 0;
+    }
+
+    std::size_t ChunkBuffer::size() const {
+        return totalSize;
+    }
+
+    bool ChunkBuffer::empty() const {
+        return totalSize == 0;
+    }
+
+    std::string ChunkBuffer::str() const {
+        std::string result;
+        result.reserve(totalSize);
+        for (const auto &chunk : chunks) {
+            result.append(chunk.data.get(), chunk.size);
+        }
+        return result;
+    }
+
+    bool ChunkBuffer::writeTo(int fd) const {
+        std::vector<iovec> pending;
+        pending.reserve(chunks.size());
+        for (const auto &chunk : chunks) {
+            if (chunk.size > 0) {
+                pending.push_back(iovec{chunk.data.get(), chunk.size});
+            }
+        }
+
+        std::size_t first = 0;
+        while (first < pending.size()) {
+            int count = static_cast<int>(std::min<std::size_t>(pending.size() - first, IOV_MAX));
+            ssize_t written = ::writev(fd, pending.data() + first, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            // Skip what was written, a short write may stop in the middle of a chunk
+            std::size_t left = static_cast<std::size_t>(written);
+            while (first < pending.size() && left >= pending[first].iov_len) {
+                left -= pending[first].iov_len;
+                first++;
+            }
+            if (left > 0) {
+                pending[first].iov_base = static_cast<char *>(pending[first].iov_base) + left;
+                pending[first].iov_len -= left;
+            }
+        }
+        return true;
+    }
+
+    std::ostream &operator<<(std::ostream &os, const ChunkBuffer &buffer) {
+        for (const auto &chunk : buffer.chunks) {
+            os.write(chunk.data.get(), chunk.size);
+        }
+        return os;
+    }
+}
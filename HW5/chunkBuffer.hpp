@@ -0,0 +1,83 @@
+#ifndef CHUNK_BUFFER_HPP
+#define CHUNK_BUFFER_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace output {
+    /* ChunkBuffer class
+     * Append-only byte buffer made of fixed-size chunks. Growing it never moves
+     * what was already written, integers are formatted in place with to_chars,
+     * and the chunks go to a file descriptor with writev, without ever being
+     * joined into one string.
+     */
+    class ChunkBuffer {
+    private:
+        struct Chunk {
+            std::unique_ptr<char[]> data;
+            std::size_t size;
+            std::size_t capacity;
+        };
+
+        std::vector<Chunk> chunks;
+        std::size_t totalSize;
+
+        // Makes room for at least n contiguous bytes at the end of the last chunk
+        char *reserve(std::size_t n);
+
+    public:
+        static constexpr std::size_t chunkSize = 64 * 1024;
+
+        ChunkBuffer();
+
+        ChunkBuffer(ChunkBuffer &&) = default;
+        ChunkBuffer &operator=(ChunkBuffer &&) = default;
+
+        void append(const char *data, std::size_t n);
+
+        void append(std::string_view text) {
+            append(text.data(), text.size());
+        }
+
+        void append(char c) {
+            *reserve(1) = c;
+            chunks.back().size++;
+            totalSize++;
+        }
+
+        // Appends the decimal form of an integer
+        template<typename T>
+        void appendInt(T value) {
+            static_assert(std::is_integral<T>::value, "appendInt takes integers only");
+            char *out = reserve(24);
+            char *end = std::to_chars(out, out + 24, value).ptr;
+            chunks.back().size += end - out;
+            totalSize += end - out;
+        }
+
+        // Moves the chunks of other to the end of this buffer, without copying bytes
+        void splice(ChunkBuffer &&other);
+
+        std::size_t size() const;
+
+        bool empty() const;
+
+        // Copies the contents into one string, meant for small buffers and tests
+        std::string str() const;
+
+        // Writes everything to fd with writev. Returns false on a write error
+        bool writeTo(int fd) const;
+
+        friend std::ostream &operator<<(std::ostream &os, const ChunkBuffer &buffer);
+    };
+
+    std::ostream &operator<<(std::ostream &os, const ChunkBuffer &buffer);
+}
+
+#endif //CHUNK_BUFFER_HPP
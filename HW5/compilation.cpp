@@ -0,0 +1,96 @@
+#include "compilation.hpp"
+#include "analyzer.hpp"
+#include "asmPrinter.hpp"
+#include "constantFolder.hpp"
+#include "output.hpp"
+#include "parser.tab.h"
+#include "lex.yy.h"
+
+// Implementing the Compilation class methods
+
+Compilation::Compilation(const std::string &source) : nodeArena(), scanner(nullptr), root(nullptr)
+{
+    yylex_init_extra(this, &scanner);
+    yy_scan_bytes(source.data(), static_cast<int>(source.size()), scanner);
+}
+
+Compilation::~Compilation()
+{
+    yylex_destroy(scanner);
+}
+
+void Compilation::parse()
+{
+    yyparse(*this, scanner);
+}
+
+int Compilation::lineno() const
+{
+    return yyget_lineno(scanner);
+}
+
+ast::Funcs *Compilation::program() const
+{
+    return root;
+}
+
+void Compilation::setProgram(ast::Funcs *program)
+{
+    root = program;
+}
+
+const ast::Arena &Compilation::arena() const
+{
+    return nodeArena;
+}
+
+ast::Arena &Compilation::arena()
+{
+    return nodeArena;
+}
+
+CompileResult compile(const std::string &source, const CompileOptions &options)
+{
+    CompileResult result;
+    Compilation compilation(source);
+
+    try
+    {
+        compilation.parse();
+        if (!options.parseOnly)
+        {
+            if (options.foldConstants)
+            {
+                ConstantFolder folder(compilation.arena());
+                compilation.program()->accept(folder);
+                result.foldedExpressions = folder.getFoldedCount();
+                result.propagatedConstants = folder.getPropagatedCount();
+            }
+            Analyzer analyzer(options.jobs, options.passes);
+            compilation.program()->accept(analyzer);
+            if (options.assembly)
+            {
+                ir::printAssembly(analyzer.getModule(), result.output);
+            }
+            else
+            {
+                analyzer.printOutput(result.output);
+            }
+            result.frameBytes = analyzer.getFrameBytes();
+            result.unsharedFrameBytes = analyzer.getUnsharedFrameBytes();
+            result.passStats = analyzer.getPassStats();
+            result.inlineReport = analyzer.getInlineReport();
+        }
+        result.success = true;
+    }
+    catch (const output::CompileError &error)
+    {
+        result.output = output::ChunkBuffer();
+        result.output.append(error.what());
+    }
+
+    result.arenaNodes = compilation.arena().objectCount();
+    result.arenaBytesUsed = compilation.arena().bytesUsed();
+    result.arenaBytesReserved = compilation.arena().bytesReserved();
+    return result;
+}
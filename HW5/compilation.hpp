@@ -0,0 +1,122 @@
+#ifndef COMPILATION_HPP
+#define COMPILATION_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "chunkBuffer.hpp"
+#include "nodes.hpp"
+#include "output.hpp"
+#include "passes.hpp"
+
+// Handle of the reentrant flex scanner, spelled the way flex spells it
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+/* Compilation class
+ * Holds everything one compilation needs while scanning and parsing: the
+ * scanner state, the arena that owns the AST and the root of the program.
+ * Nothing here is global, so independent compilations may run concurrently.
+ */
+class Compilation
+{
+private:
+    ast::Arena nodeArena;
+    yyscan_t scanner;
+    ast::Funcs *root;
+
+public:
+    // Prepares a scanner over a private copy of the source text
+    explicit Compilation(const std::string &source);
+
+    Compilation(const Compilation &) = delete;
+    Compilation &operator=(const Compilation &) = delete;
+
+    ~Compilation();
+
+    // Parses the whole source. Syntax and lexical errors throw output::CompileError
+    void parse();
+
+    // Constructs an AST node in the arena, stamped with the current source line.
+    // A literal too large for an int is a lexical error on that line
+    // Usage example:
+    //      $$ = ctx.make<ast::Return>($2);
+    template <typename T, typename... Args>
+    T *make(Args &&...args)
+    {
+        T *node;
+        try
+        {
+            node = nodeArena.make<T>(std::forward<Args>(args)...);
+        }
+        catch (const std::out_of_range &)
+        {
+            output::errorLex(lineno());
+        }
+        node->line = lineno();
+        return node;
+    }
+
+    // Line the scanner is currently on
+    int lineno() const;
+
+    // Root of the AST, set by the parser when it reduces the start symbol
+    ast::Funcs *program() const;
+    void setProgram(ast::Funcs *program);
+
+    const ast::Arena &arena() const;
+    ast::Arena &arena();
+};
+
+struct CompileOptions
+{
+    // Stop after parsing, without semantic analysis or code generation
+    bool parseOnly = false;
+    // Fold constant expressions and propagate constant locals before analysis,
+    // --no-fold turns it off
+    bool foldConstants = true;
+    // Threads that analyze and emit the function bodies of the program
+    std::size_t jobs = 1;
+    // Optimizations applied to every function, --no-ssa turns off promoteLocals,
+    // --no-bce eliminateBoundsChecks and --no-simplify simplifyControlFlow
+    ir::PassOptions passes;
+    // Emit x86-64 assembly for the GNU assembler instead of LLVM IR, --asm
+    bool assembly = false;
+};
+
+struct CompileResult
+{
+    // False if compilation stopped at a diagnostic
+    bool success = false;
+    // The generated LLVM code on success, otherwise the diagnostic text
+    output::ChunkBuffer output;
+
+    // Arena statistics, as reported by --stats
+    std::size_t arenaNodes = 0;
+    std::size_t arenaBytesUsed = 0;
+    std::size_t arenaBytesReserved = 0;
+
+    // Bytes of the array slots of all functions, and what they would take
+    // without sharing slots across scopes
+    std::size_t frameBytes = 0;
+    std::size_t unsharedFrameBytes = 0;
+
+    // What the passes did, e.g. the bounds checks they removed
+    ir::PassStats passStats;
+
+    // Expressions folded to a literal, and uses of locals replaced by theirs
+    int foldedExpressions = 0;
+    int propagatedConstants = 0;
+
+    // One line per call of a function of the program, inlined or not and why
+    std::vector<std::string> inlineReport;
+};
+
+// Compiles one FanC program. Safe to call concurrently on independent sources
+CompileResult compile(const std::string &source, const CompileOptions &options = CompileOptions());
+
+#endif // COMPILATION_HPP
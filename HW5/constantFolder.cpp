@@ -0,0 +1,387 @@
+#include "constantFolder.hpp"
+#include <climits>
+#include <cstdint>
+
+namespace {
+
+// Literal value of exp as it is lowered: an int, a byte in 0..255 or a bool
+bool isInt(ast::Exp *exp) {
+    return dynamic_cast<ast::Num *>(exp) != nullptr;
+}
+
+bool isByte(ast::Exp *exp) {
+    auto byte = dynamic_cast<ast::NumB *>(exp);
+    // Out of range byte literals stay for the Analyzer to report
+    return byte && byte->value >= 0 && byte->value <= 255;
+}
+
+int numericValue(ast::Exp *exp) {
+    if (auto num = dynamic_cast<ast::Num *>(exp)) {
+        return num->value;
+    }
+    return static_cast<ast::NumB *>(exp)->value;
+}
+
+// Byte arithmetic is done on i8, whose division and compares are signed
+int signedByte(int value) {
+    return static_cast<std::int8_t>(static_cast<std::uint8_t>(value));
+}
+
+}  // namespace
+
+ConstantFolder::ConstantFolder(ast::Arena &arena)
+    : arena(arena), scopes(), assigned(), propagate(false), result(nullptr),
+      foldedCount(0), propagatedCount(0) {}
+
+ast::Exp *ConstantFolder::fold(ast::Exp *exp) {
+    exp->accept(*this);
+    return result;
+}
+
+void ConstantFolder::foldScoped(ast::Statement *statement) {
+    scopes.emplace_back();
+    statement->accept(*this);
+    scopes.pop_back();
+}
+
+ast::VarDecl *ConstantFolder::lookup(const std::string &name) const {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        auto found = scope->find(name);
+        if (found != scope->end()) {
+            return found->second;
+        }
+    }
+    return nullptr;
+}
+
+ast::Exp *ConstantFolder::intLiteral(int value, int line) {
+    auto literal = arena.make<ast::Num>("0");
+    literal->value = value;
+    literal->line = line;
+    return literal;
+}
+
+ast::Exp *ConstantFolder::byteLiteral(int value, int line) {
+    auto literal = arena.make<ast::NumB>("0");
+    literal->value = value & 0xff;
+    literal->line = line;
+    return literal;
+}
+
+ast::Exp *ConstantFolder::boolLiteral(bool value, int line) {
+    auto literal = arena.make<ast::Bool>(value);
+    literal->line = line;
+    return literal;
+}
+
+void ConstantFolder::visit(ast::Num &node) {
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::NumB &node) {
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::String &node) {
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::Bool &node) {
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::ID &node) {
+    result = &node;
+    ast::VarDecl *decl = propagate ? lookup(node.value) : nullptr;
+    if (!decl || assigned.count(decl)) {
+        return;
+    }
+
+    // The declaration's initializer is already folded, and only a literal
+    // the declared type accepts is a constant. No initializer means zero
+    auto type = static_cast<ast::PrimitiveType *>(decl->type)->type;
+    ast::Exp *init = decl->init_exp;
+    if (type == ast::BuiltInType::INT) {
+        if (!init || isInt(init) || isByte(init)) {
+            result = intLiteral(init ? numericValue(init) : 0, node.line);
+        }
+    } else if (type == ast::BuiltInType::BYTE) {
+        if (!init || isByte(init)) {
+            result = byteLiteral(init ? numericValue(init) : 0, node.line);
+        }
+    } else if (type == ast::BuiltInType::BOOL) {
+        auto literal = dynamic_cast<ast::Bool *>(init);
+        if (!init || literal) {
+            result = boolLiteral(literal && literal->value, node.line);
+        }
+    }
+    if (result != &node) {
+        ++propagatedCount;
+    }
+}
+
+void ConstantFolder::visit(ast::BinOp &node) {
+    node.left = fold(node.left);
+    node.right = fold(node.right);
+    result = &node;
+
+    bool leftByte = isByte(node.left);
+    bool rightByte = isByte(node.right);
+    if ((!leftByte && !isInt(node.left)) || (!rightByte && !isInt(node.right))) {
+        return;
+    }
+    int left = numericValue(node.left);
+    int right = numericValue(node.right);
+
+    if (leftByte && rightByte) {
+        // i8 arithmetic, wrapping at 256
+        switch (node.op) {
+            case ast::BinOpType::ADD:
+                result = byteLiteral(left + right, node.line);
+                break;
+            case ast::BinOpType::SUB:
+                result = byteLiteral(left - right, node.line);
+                break;
+            case ast::BinOpType::MUL:
+                result = byteLiteral(left * right, node.line);
+                break;
+            case ast::BinOpType::DIV:
+                // Division by zero is reported when the program runs, and
+                // sdiv of -128 by -1 overflows
+                left = signedByte(left);
+                right = signedByte(right);
+                if (right == 0 || (left == -128 && right == -1)) {
+                    return;
+                }
+                result = byteLiteral(left / right, node.line);
+                break;
+        }
+    } else {
+        // i32 arithmetic, wrapping at 2^32
+        auto a = static_cast<std::uint32_t>(left);
+        auto b = static_cast<std::uint32_t>(right);
+        switch (node.op) {
+            case ast::BinOpType::ADD:
+                result = intLiteral(static_cast<std::int32_t>(a + b), node.line);
+                break;
+            case ast::BinOpType::SUB:
+                result = intLiteral(static_cast<std::int32_t>(a - b), node.line);
+                break;
+            case ast::BinOpType::MUL:
+                result = intLiteral(static_cast<std::int32_t>(a * b), node.line);
+                break;
+            case ast::BinOpType::DIV:
+                if (right == 0 || (left == INT_MIN && right == -1)) {
+                    return;
+                }
+                result = intLiteral(left / right, node.line);
+                break;
+        }
+    }
+    ++foldedCount;
+}
+
+void ConstantFolder::visit(ast::RelOp &node) {
+    node.left = fold(node.left);
+    node.right = fold(node.right);
+    result = &node;
+
+    bool leftByte = isByte(node.left);
+    bool rightByte = isByte(node.right);
+    if ((!leftByte && !isInt(node.left)) || (!rightByte && !isInt(node.right))) {
+        return;
+    }
+    int left = numericValue(node.left);
+    int right = numericValue(node.right);
+    if (leftByte && rightByte) {
+        left = signedByte(left);
+        right = signedByte(right);
+    }
+
+    bool value = false;
+    switch (node.op) {
+        case ast::RelOpType::EQ:
+            value = left == right;
+            break;
+        case ast::RelOpType::NE:
+            value = left != right;
+            break;
+        case ast::RelOpType::LT:
+            value = left < right;
+            break;
+        case ast::RelOpType::GT:
+            value = left > right;
+            break;
+        case ast::RelOpType::LE:
+            value = left <= right;
+            break;
+        case ast::RelOpType::GE:
+            value = left >= right;
+            break;
+    }
+    result = boolLiteral(value, node.line);
+    ++foldedCount;
+}
+
+void ConstantFolder::visit(ast::Not &node) {
+    node.exp = fold(node.exp);
+    result = &node;
+    if (auto operand = dynamic_cast<ast::Bool *>(node.exp)) {
+        result = boolLiteral(!operand->value, node.line);
+        ++foldedCount;
+    }
+}
+
+void ConstantFolder::visit(ast::And &node) {
+    // Only literal operands fold: a literal false on the left does not drop
+    // the right operand, which may still hold an error to report
+    node.left = fold(node.left);
+    node.right = fold(node.right);
+    result = &node;
+    auto left = dynamic_cast<ast::Bool *>(node.left);
+    auto right = dynamic_cast<ast::Bool *>(node.right);
+    if (left && right) {
+        result = boolLiteral(left->value && right->value, node.line);
+        ++foldedCount;
+    }
+}
+
+void ConstantFolder::visit(ast::Or &node) {
+    node.left = fold(node.left);
+    node.right = fold(node.right);
+    result = &node;
+    auto left = dynamic_cast<ast::Bool *>(node.left);
+    auto right = dynamic_cast<ast::Bool *>(node.right);
+    if (left && right) {
+        result = boolLiteral(left->value || right->value, node.line);
+        ++foldedCount;
+    }
+}
+
+void ConstantFolder::visit(ast::PrimitiveType &) {
+    // Nothing to fold
+}
+
+void ConstantFolder::visit(ast::ArrayType &) {
+    // The length must be written as a literal, so it is not folded
+}
+
+void ConstantFolder::visit(ast::ArrayDereference &node) {
+    node.index = fold(node.index);
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::ArrayAssign &node) {
+    node.index = fold(node.index);
+    node.exp = fold(node.exp);
+}
+
+void ConstantFolder::visit(ast::Cast &node) {
+    node.exp = fold(node.exp);
+    result = &node;
+
+    auto target = node.target_type->type;
+    if (isInt(node.exp) || isByte(node.exp)) {
+        // zext from byte, trunc to byte
+        if (target == ast::BuiltInType::INT) {
+            result = intLiteral(numericValue(node.exp), node.line);
+        } else if (target == ast::BuiltInType::BYTE) {
+            result = byteLiteral(numericValue(node.exp), node.line);
+        }
+    }
+    if (result != &node) {
+        ++foldedCount;
+    }
+}
+
+void ConstantFolder::visit(ast::ExpList &node) {
+    for (auto &exp : node.exps) {
+        exp = fold(exp);
+    }
+}
+
+void ConstantFolder::visit(ast::Call &node) {
+    node.args->accept(*this);
+    result = &node;
+}
+
+void ConstantFolder::visit(ast::CallStatement &node) {
+    node.call->accept(*this);
+}
+
+void ConstantFolder::visit(ast::Statements &node) {
+    scopes.emplace_back();
+    for (auto &stmt : node.statements) {
+        stmt->accept(*this);
+    }
+    scopes.pop_back();
+}
+
+void ConstantFolder::visit(ast::Break &) {}
+
+void ConstantFolder::visit(ast::Continue &) {}
+
+void ConstantFolder::visit(ast::Return &node) {
+    if (node.exp) {
+        node.exp = fold(node.exp);
+    }
+}
+
+void ConstantFolder::visit(ast::If &node) {
+    node.condition = fold(node.condition);
+    foldScoped(node.then);
+    if (node.otherwise) {
+        foldScoped(node.otherwise);
+    }
+}
+
+void ConstantFolder::visit(ast::While &node) {
+    node.condition = fold(node.condition);
+    foldScoped(node.body);
+}
+
+void ConstantFolder::visit(ast::VarDecl &node) {
+    // The initializer does not see the variable it initializes
+    if (node.init_exp) {
+        node.init_exp = fold(node.init_exp);
+    }
+    // Arrays are never constants, a nullptr entry only hides outer names
+    bool scalar = dynamic_cast<ast::PrimitiveType *>(node.type) != nullptr;
+    scopes.back()[node.id->value] = scalar ? &node : nullptr;
+}
+
+void ConstantFolder::visit(ast::Assign &node) {
+    node.exp = fold(node.exp);
+    if (ast::VarDecl *decl = lookup(node.id->value)) {
+        assigned.insert(decl);
+    }
+}
+
+void ConstantFolder::visit(ast::Formal &node) {
+    scopes.back()[node.id->value] = nullptr;
+}
+
+void ConstantFolder::visit(ast::Formals &node) {
+    for (auto &formal : node.formals) {
+        formal->accept(*this);
+    }
+}
+
+void ConstantFolder::visit(ast::FuncDecl &node) {
+    // The first walk folds literals and finds the assigned locals, the second
+    // propagates the others into their uses
+    assigned.clear();
+    for (bool pass : {false, true}) {
+        propagate = pass;
+        scopes.emplace_back();
+        node.formals->accept(*this);
+        node.body->accept(*this);
+        scopes.pop_back();
+    }
+}
+
+void ConstantFolder::visit(ast::Funcs &node) {
+    for (auto &func : node.funcs) {
+        func->accept(*this);
+    }
+}
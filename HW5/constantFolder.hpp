@@ -0,0 +1,96 @@
+#ifndef CONSTANT_FOLDER_HPP
+#define CONSTANT_FOLDER_HPP
+
+#include "visitor.hpp"
+#include "nodes.hpp"
+#include "arena.hpp"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* ConstantFolder class
+ * Rewrites the AST between parsing and analysis. Operations whose operands
+ * are all literals become the literal they compute, with the same wraparound
+ * and signedness as the code the Analyzer emits for them. Uses of a local
+ * that is never assigned after its declaration become its initial literal,
+ * which may fold further. Anything that would be an error is left alone, so
+ * the Analyzer still reports it at the same line.
+ */
+class ConstantFolder : public Visitor
+{
+private:
+    // Owns the literals made by folding
+    ast::Arena &arena;
+    // Locals in scope, innermost scope last. Formals map to nullptr
+    std::vector<std::unordered_map<std::string, ast::VarDecl *>> scopes;
+    // Locals of the current function that some assignment changes
+    std::unordered_set<ast::VarDecl *> assigned;
+    // Off while the first walk of a function collects the assignments
+    bool propagate;
+    // Node that replaces the expression visited last
+    ast::Exp *result;
+    int foldedCount;
+    int propagatedCount;
+
+    // Visits exp and returns the node that takes its place
+    ast::Exp *fold(ast::Exp *exp);
+
+    // Visits a statement in a scope of its own, as the bodies of if and while get
+    void foldScoped(ast::Statement *statement);
+
+    ast::VarDecl *lookup(const std::string &name) const;
+
+    // Literals standing in for the node at line
+    ast::Exp *intLiteral(int value, int line);
+    ast::Exp *byteLiteral(int value, int line);
+    ast::Exp *boolLiteral(bool value, int line);
+
+public:
+    explicit ConstantFolder(ast::Arena &arena);
+
+    // Expressions replaced by the literal they compute
+    int getFoldedCount() const
+    {
+        return foldedCount;
+    }
+    // Uses of locals replaced by their constant value
+    int getPropagatedCount() const
+    {
+        return propagatedCount;
+    }
+
+    // Visitor methods
+    void visit(ast::Num &node) override;
+    void visit(ast::NumB &node) override;
+    void visit(ast::String &node) override;
+    void visit(ast::Bool &node) override;
+    void visit(ast::ID &node) override;
+    void visit(ast::BinOp &node) override;
+    void visit(ast::RelOp &node) override;
+    void visit(ast::Not &node) override;
+    void visit(ast::And &node) override;
+    void visit(ast::Or &node) override;
+    void visit(ast::PrimitiveType &node) override;
+    void visit(ast::ArrayType &node) override;
+    void visit(ast::ArrayDereference &node) override;
+    void visit(ast::ArrayAssign &node) override;
+    void visit(ast::Cast &node) override;
+    void visit(ast::ExpList &node) override;
+    void visit(ast::Call &node) override;
+    void visit(ast::CallStatement &node) override;
+    void visit(ast::Statements &node) override;
+    void visit(ast::Break &node) override;
+    void visit(ast::Continue &node) override;
+    void visit(ast::Return &node) override;
+    void visit(ast::If &node) override;
+    void visit(ast::While &node) override;
+    void visit(ast::VarDecl &node) override;
+    void visit(ast::Assign &node) override;
+    void visit(ast::Formal &node) override;
+    void visit(ast::Formals &node) override;
+    void visit(ast::FuncDecl &node) override;
+    void visit(ast::Funcs &node) override;
+};
+
+#endif // CONSTANT_FOLDER_HPP
@@ -0,0 +1,116 @@
+#include "frameLayout.hpp"
+
+namespace ir
+{
+
+        // Storage size of an array element. i1 elements take a byte each, so
+        // byte and bool arrays can use the same slots
+        static std::size_t elementBytes(Type type)
+        {
+                return type == Type::I32 ? 4 : type == Type::I8_PTR ? 8 : 1;
+        }
+
+        FrameLayout::FrameLayout() : slots(), scopes(), declaredBytes(0) {}
+
+        void FrameLayout::reset()
+        {
+                slots.clear();
+                scopes.assign(1, {});
+                declaredBytes = 0;
+        }
+
+        void FrameLayout::beginScope()
+        {
+                scopes.emplace_back();
+        }
+
+        void FrameLayout::endScope(Builder &builder)
+        {
+                for (int index : scopes.back())
+                {
+                        lifetime(builder, "llvm.lifetime.end.p0i8", slots[index]);
+                        slots[index].live = false;
+                }
+                scopes.pop_back();
+        }
+
+        Value FrameLayout::place(Builder &builder, Type type, int count)
+        {
+                declaredBytes += elementBytes(type) * count;
+
+                // The smallest free slot that is large enough, else the largest one, grown
+                int best = -1;
+                for (size_t i = 0; i < slots.size(); ++i)
+                {
+                        const Instruction *alloca = slots[i].alloca;
+                        if (slots[i].live || elementBytes(alloca->type) != elementBytes(type))
+                        {
+                                continue;
+                        }
+                        if (best < 0)
+                        {
+                                best = static_cast<int>(i);
+                                continue;
+                        }
+                        int bestCount = slots[best].alloca->count;
+                        bool fits = alloca->count >= count;
+                        bool bestFits = bestCount >= count;
+                        if (fits != bestFits ? fits : (fits ? alloca->count < bestCount : alloca->count > bestCount))
+                        {
+                                best = static_cast<int>(i);
+                        }
+                }
+                if (best < 0)
+                {
+                        best = static_cast<int>(slots.size());
+                        slots.push_back(Slot{builder.allocate(builder.temp(), type, count), false});
+                }
+
+                Slot &slot = slots[best];
+                if (slot.alloca->count < count)
+                {
+                        slot.alloca->count = count;
+                }
+                slot.live = true;
+                scopes.back().push_back(best);
+                lifetime(builder, "llvm.lifetime.start.p0i8", slot);
+
+                // byte and bool arrays share slots, each sees the slot as its own type
+                if (slot.alloca->type == type)
+                {
+                        return slot.alloca->result;
+                }
+                Value pointer = builder.temp();
+                builder.cast(Opcode::BITCAST, pointer, slot.alloca->type, slot.alloca->result, type);
+                return pointer;
+        }
+
+        void FrameLayout::lifetime(Builder &builder, const char *marker, const Slot &slot)
+        {
+                // Markers take an i8*; a size of -1 covers the whole alloca, however large it grows
+                Value pointer = slot.alloca->result;
+                if (slot.alloca->type != Type::I8)
+                {
+                        pointer = builder.temp();
+                        builder.cast(Opcode::BITCAST, pointer, slot.alloca->type, slot.alloca->result, Type::I8);
+                }
+                builder.call(Value(), Type::VOID, marker,
+                             {Argument{Type::I64, Value::constant(-1)}, Argument{Type::I8_PTR, pointer}});
+        }
+
+        std::size_t FrameLayout::frameBytes() const
+        {
+                std::size_t bytes = 0;
+                for (const Slot &slot : slots)
+                {
+                        bytes += elementBytes(slot.alloca->type) * slot.alloca->count;
+                }
+                return bytes;
+        }
+
+        std::size_t FrameLayout::unsharedBytes() const
+        {
+                return declaredBytes;
+        }
+
+}
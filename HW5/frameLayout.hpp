@@ -0,0 +1,56 @@
+#ifndef FRAME_LAYOUT_HPP
+#define FRAME_LAYOUT_HPP
+
+#include <cstddef>
+#include <vector>
+#include "ir.hpp"
+
+namespace ir
+{
+
+    /* FrameLayout class
+     * Stack slots of the arrays of one function, assigned while its scopes are
+     * walked. An array takes a free slot of its element size and grows it if
+     * needed, so arrays of scopes that are never open together share one
+     * alloca, byte and bool arrays alike. Every use of a slot is bracketed by llvm.lifetime.start at the
+     * declaration and llvm.lifetime.end when the scope closes.
+     */
+    class FrameLayout
+    {
+    private:
+        struct Slot
+        {
+            Instruction *alloca;
+            bool live;
+        };
+
+        std::vector<Slot> slots;
+        // Slots taken in each open scope, the innermost at the back
+        std::vector<std::vector<int>> scopes;
+        // Bytes of every array declared, as if each had a slot of its own
+        std::size_t declaredBytes;
+
+        void lifetime(Builder &builder, const char *marker, const Slot &slot);
+
+    public:
+        FrameLayout();
+
+        // Starts the layout of a new function, with its outermost scope open
+        void reset();
+
+        void beginScope();
+
+        // Ends the lifetimes of the slots of the innermost scope and frees them
+        void endScope(Builder &builder);
+
+        // Slot for an array of count elements of the given type
+        Value place(Builder &builder, Type type, int count);
+
+        // Bytes the arrays take with and without slot sharing
+        std::size_t frameBytes() const;
+        std::size_t unsharedBytes() const;
+    };
+
+}
+
+#endif // FRAME_LAYOUT_HPP
@@ -0,0 +1,104 @@
+#!/bin/bash
+
+# Usage: ./icount.sh [test directory] [hw5 flags...]
+# Runs every test program under lli twice, compiled with --no-ssa and as is,
+# and compares the number of LLVM instructions each run executes.
+# The test directory defaults to allTests/hw5-tests; extra flags go to both builds.
+
+# Compile the project
+make > /dev/null 2>&1
+
+# Exit if compilation fails
+if [ $? -ne 0 ]; then
+    echo "❌ Compilation failed."
+    exit 1
+fi
+
+COUNT_DIR=$(mktemp -d)
+trap 'rm -rf "$COUNT_DIR"; make clean > /dev/null' EXIT
+
+TEST_DIR=${1:-allTests/hw5-tests}
+[ $# -gt 0 ] && shift
+FLAGS=("$@")
+
+# Adds a global counter bumped at the top of every basic block by the number of
+# instructions in the block, and reports it on stderr before main returns or
+# the program calls exit. Code after a terminator is unreachable and not counted.
+instrument() {
+    awk '
+    # Prints the buffered block with its counter update after the phis.
+    # With hold set the last line is kept back, for the caller to print
+    function flush(hold,    i, n) {
+        n = 0;
+        for (i = 1; i <= count; i++) if (body[i] !~ /^ *$/) n++;
+        for (i = 1; i <= count && body[i] ~ /= phi /; i++) print body[i];
+        if (n > 0 && counted) {
+            k++;
+            printf "%%ic%d = load i64, i64* @.icount\n", k;
+            printf "%%ic%d.n = add i64 %%ic%d, %d\n", k, k, n;
+            printf "store i64 %%ic%d.n, i64* @.icount\n", k;
+        }
+        for (; i <= count - hold; i++) print body[i];
+        count = 0;
+    }
+    function report() {
+        k++;
+        printf "%%ic%d = load i64, i64* @.icount\n", k;
+        printf "call i32 (i32, i8*, ...) @dprintf(i32 2, i8* getelementptr ([18 x i8], [18 x i8]* @.icount_format, i32 0, i32 0), i64 %%ic%d)\n", k;
+    }
+    BEGIN {
+        print "@.icount = global i64 0";
+        print "@.icount_format = constant [18 x i8] c\"instructions %ld\\0A\\00\"";
+        print "declare i32 @dprintf(i32, i8*, ...)";
+    }
+    /^define / { print; inMain = ($0 ~ /@main\(/); inFunction = 1; counted = 1; count = 0; next; }
+    !inFunction { print; next; }
+    /^}$/ { flush(0); print; inFunction = 0; next; }
+    /^[A-Za-z0-9_.]+:$/ { flush(0); print; counted = 1; next; }
+    {
+        if (!counted) { print; next; }
+        body[++count] = $0;
+        if ($0 ~ /^ *(ret |br |unreachable$)/) {
+            if (inMain && $0 ~ /^ *ret /) { flush(1); report(); print $0; }
+            else flush(0);
+            counted = 0;
+        } else if ($0 ~ /call void @exit\(/) {
+            flush(1); report(); print $0;
+        }
+    }
+    '
+}
+
+# Executed instructions of one compiled program, "-" if it did not report
+run_counted() {
+    instrument < "$1" > "$1.counted.ll"
+    timeout 20 lli "$1.counted.ll" < /dev/null > "$1.stdout" 2> "$1.stderr"
+    grep -o "^instructions [0-9]*" "$1.stderr" | tail -1 | cut -d' ' -f2 | grep . || echo "-"
+}
+
+TOTAL_BEFORE=0
+TOTAL_AFTER=0
+printf "%-40s %14s %14s %8s\n" "test" "--no-ssa" "default" "ratio"
+for IN_FILE in "$TEST_DIR"/*.in; do
+    NAME=$(basename "$IN_FILE" .in)
+    ./hw5 --no-ssa "${FLAGS[@]}" < "$IN_FILE" > "$COUNT_DIR/before.ll"
+    ./hw5 "${FLAGS[@]}" < "$IN_FILE" > "$COUNT_DIR/after.ll"
+    BEFORE=$(run_counted "$COUNT_DIR/before.ll")
+    AFTER=$(run_counted "$COUNT_DIR/after.ll")
+
+    # Both builds must behave the same before their counts mean anything
+    if ! cmp -s "$COUNT_DIR/before.ll.stdout" "$COUNT_DIR/after.ll.stdout"; then
+        printf "%-40s %s\n" "$NAME" "❌ output differs"
+        continue
+    fi
+    if [ "$BEFORE" = "-" ] || [ "$AFTER" = "-" ]; then
+        printf "%-40s %14s %14s %8s\n" "$NAME" "$BEFORE" "$AFTER" "-"
+        continue
+    fi
+    TOTAL_BEFORE=$((TOTAL_BEFORE + BEFORE))
+    TOTAL_AFTER=$((TOTAL_AFTER + AFTER))
+    printf "%-40s %14d %14d %8s\n" "$NAME" "$BEFORE" "$AFTER" \
+        "$(awk -v a="$AFTER" -v b="$BEFORE" 'BEGIN { printf "%.3f", a / b }')"
+done
+printf "%-40s %14d %14d %8s\n" "total" "$TOTAL_BEFORE" "$TOTAL_AFTER" \
+    "$(awk -v a="$TOTAL_AFTER" -v b="$TOTAL_BEFORE" 'BEGIN { if (b > 0) printf "%.3f", a / b; else print "-" }')"
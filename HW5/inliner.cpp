@@ -0,0 +1,469 @@
+#include "inliner.hpp"
+#include "arithmetic.hpp"
+#include "cfg.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                int size(const Function &function)
+                {
+                        int count = 0;
+                        for (const Block *block : function.blocks)
+                        {
+                                for (const Instruction *i = block->first; i != nullptr; i = i->next)
+                                {
+                                        ++count;
+                                }
+                        }
+                        return count;
+                }
+
+                bool returns(const Function &function)
+                {
+                        for (const Block *block : function.blocks)
+                        {
+                                if (block->last != nullptr && block->last->op == Opcode::RET)
+                                {
+                                        return true;
+                                }
+                        }
+                        return false;
+                }
+
+                // Strongly connected components of the call graph, after Tarjan.
+                // A component comes after every component it calls into
+                std::vector<std::vector<int>> components(const std::vector<std::vector<int>> &graph)
+                {
+                        int n = static_cast<int>(graph.size());
+                        std::vector<int> order(n, -1);
+                        std::vector<int> low(n, 0);
+                        std::vector<bool> onStack(n, false);
+                        std::vector<int> stack;
+                        std::vector<std::vector<int>> result;
+                        int counter = 0;
+
+                        // An explicit walk, a long chain of calls would overflow the stack
+                        for (int root = 0; root < n; ++root)
+                        {
+                                if (order[root] >= 0)
+                                {
+                                        continue;
+                                }
+                                std::vector<std::pair<int, size_t>> walk{{root, 0}};
+                                order[root] = low[root] = counter++;
+                                stack.push_back(root);
+                                onStack[root] = true;
+                                while (!walk.empty())
+                                {
+                                        int v = walk.back().first;
+                                        size_t &next = walk.back().second;
+                                        if (next < graph[v].size())
+                                        {
+                                                int w = graph[v][next++];
+                                                if (order[w] < 0)
+                                                {
+                                                        order[w] = low[w] = counter++;
+                                                        stack.push_back(w);
+                                                        onStack[w] = true;
+                                                        walk.push_back({w, 0});
+                                                }
+                                                else if (onStack[w])
+                                                {
+                                                        low[v] = std::min(low[v], order[w]);
+                                                }
+                                                continue;
+                                        }
+
+                                        if (low[v] == order[v])
+                                        {
+                                                std::vector<int> component;
+                                                int w;
+                                                do
+                                                {
+                                                        w = stack.back();
+                                                        stack.pop_back();
+                                                        onStack[w] = false;
+                                                        component.push_back(w);
+                                                } while (w != v);
+                                                result.push_back(std::move(component));
+                                        }
+                                        walk.pop_back();
+                                        if (!walk.empty())
+                                        {
+                                                int parent = walk.back().first;
+                                                low[parent] = std::min(low[parent], low[v]);
+                                        }
+                                }
+                        }
+                        return result;
+                }
+
+                void append(Block *block, Instruction *instruction)
+                {
+                        if (block->last)
+                        {
+                                block->last->next = instruction;
+                        }
+                        else
+                        {
+                                block->first = instruction;
+                        }
+                        block->last = instruction;
+                }
+
+                /* CallInliner class
+                 * Replaces one call by a copy of the callee's blocks. The code after
+                 * the call moves to a block of its own, where the copied returns
+                 * jump and a phi merges their values.
+                 */
+                class CallInliner
+                {
+                private:
+                        Function &caller;
+                        const Function &callee;
+                        Block *block;
+                        Instruction *call;
+                        int tempBase;
+                        std::unordered_map<const Block *, Block *> copies;
+
+                        void remap(Value &value)
+                        {
+                                switch (value.kind)
+                                {
+                                case Value::Kind::TEMP:
+                                        value.id += tempBase;
+                                        break;
+                                case Value::Kind::ARGUMENT:
+                                        value = call->arguments[value.id].value;
+                                        break;
+                                case Value::Kind::STRING:
+                                case Value::Kind::STRING_ADDRESS:
+                                        value.id = caller.intern(callee.strings[value.id]);
+                                        break;
+                                default:
+                                        break;
+                                }
+                        }
+
+                        // A copy of the instruction reading the caller's values, and
+                        // with arrays of its own
+                        Instruction *copy(const Instruction *original)
+                        {
+                                ast::Arena &arena = caller.storage();
+                                Instruction *clone = arena.make<Instruction>(*original);
+                                clone->next = nullptr;
+                                // The rets of the copy become jumps, so it holds no tail calls
+                                clone->tail = TailCall::NONE;
+                                if (original->callee)
+                                {
+                                        std::size_t length = std::strlen(original->callee) + 1;
+                                        char *name = static_cast<char *>(arena.allocate(length, 1));
+                                        std::memcpy(name, original->callee, length);
+                                        clone->callee = name;
+                                }
+                                if (original->argumentCount > 0)
+                                {
+                                        clone->arguments = static_cast<Argument *>(arena.allocate(
+                                            sizeof(Argument) * original->argumentCount, alignof(Argument)));
+                                        std::copy(original->arguments, original->arguments + original->argumentCount,
+                                                  clone->arguments);
+                                }
+                                if (original->incomingCount > 0)
+                                {
+                                        clone->incoming = static_cast<Incoming *>(arena.allocate(
+                                            sizeof(Incoming) * original->incomingCount, alignof(Incoming)));
+                                        for (int k = 0; k < original->incomingCount; ++k)
+                                        {
+                                                clone->incoming[k] = Incoming{original->incoming[k].value,
+                                                                              copies.at(original->incoming[k].block)};
+                                        }
+                                }
+                                clone->forEachOperand([this](Value &value) { remap(value); });
+                                remap(clone->result);
+                                if (original->target)
+                                {
+                                        clone->target = copies.at(original->target);
+                                }
+                                if (original->otherwise)
+                                {
+                                        clone->otherwise = copies.at(original->otherwise);
+                                }
+                                return clone;
+                        }
+
+                        void replaceUses(Value from, Value to)
+                        {
+                                for (Block *b : caller.blocks)
+                                {
+                                        for (Instruction *i = b->first; i != nullptr; i = i->next)
+                                        {
+                                                i->forEachOperand([&](Value &value) {
+                                                        if (value.kind == from.kind && value.id == from.id)
+                                                        {
+                                                                value = to;
+                                                        }
+                                                });
+                                        }
+                                }
+                        }
+
+                public:
+                        CallInliner(Function &caller, const Function &callee, Block *block, Instruction *call)
+                            : caller(caller), callee(callee), block(block), call(call), tempBase(caller.tempCount) {}
+
+                        // Returns the block that holds the code after the call
+                        Block *run()
+                        {
+                                ast::Arena &arena = caller.storage();
+                                caller.tempCount += callee.tempCount;
+
+                                // Split the block after the call, which goes away
+                                Block *rest = arena.make<Block>(caller.labelCount++);
+                                Instruction *before = nullptr;
+                                for (Instruction *i = block->first; i != call; i = i->next)
+                                {
+                                        before = i;
+                                }
+                                rest->first = call->next;
+                                rest->last = block->last;
+                                (before ? before->next : block->first) = nullptr;
+                                block->last = before;
+                                rest->successors.swap(block->successors);
+                                for (Block *successor : rest->successors)
+                                {
+                                        std::replace(successor->predecessors.begin(), successor->predecessors.end(), block, rest);
+                                        for (Instruction *i = successor->first; i != nullptr && i->op == Opcode::PHI; i = i->next)
+                                        {
+                                                for (int k = 0; k < i->incomingCount; ++k)
+                                                {
+                                                        if (i->incoming[k].block == block)
+                                                        {
+                                                                i->incoming[k].block = rest;
+                                                        }
+                                                }
+                                        }
+                                }
+
+                                for (const Block *original : callee.blocks)
+                                {
+                                        copies[original] = arena.make<Block>(caller.labelCount++);
+                                }
+
+                                // Allocas join the caller's at the top of its entry block, so
+                                // a call in a loop does not grow the stack
+                                Block *entry = caller.blocks.front();
+                                std::vector<Incoming> returns;
+                                for (const Block *original : callee.blocks)
+                                {
+                                        Block *copied = copies[original];
+                                        for (const Block *predecessor : original->predecessors)
+                                        {
+                                                copied->predecessors.push_back(copies.at(predecessor));
+                                        }
+                                        for (const Block *successor : original->successors)
+                                        {
+                                                copied->successors.push_back(copies.at(successor));
+                                        }
+                                        for (const Instruction *i = original->first; i != nullptr; i = i->next)
+                                        {
+                                                Instruction *clone = copy(i);
+                                                if (clone->op == Opcode::ALLOCA)
+                                                {
+                                                        clone->next = entry->first;
+                                                        entry->first = clone;
+                                                        if (!entry->last)
+                                                        {
+                                                                entry->last = clone;
+                                                        }
+                                                        continue;
+                                                }
+                                                if (clone->op == Opcode::RET)
+                                                {
+                                                        returns.push_back(Incoming{clone->lhs, copied});
+                                                        clone->op = Opcode::BR;
+                                                        clone->type = Type::VOID;
+                                                        clone->lhs = Value();
+                                                        clone->target = rest;
+                                                        copied->successors.push_back(rest);
+                                                        rest->predecessors.push_back(copied);
+                                                }
+                                                append(copied, clone);
+                                        }
+                                }
+
+                                Instruction *jump = arena.make<Instruction>(Opcode::BR);
+                                jump->target = copies[callee.blocks.front()];
+                                append(block, jump);
+                                block->successors.push_back(jump->target);
+                                jump->target->predecessors.push_back(block);
+
+                                // The copies go where the call was, their traps stay last
+                                std::vector<Block *> body;
+                                for (const Block *original : callee.blocks)
+                                {
+                                        Block *copied = copies[original];
+                                        bool trap = copied->last && copied->last->op == Opcode::UNREACHABLE;
+                                        (trap ? caller.blocks : body).push_back(copied);
+                                }
+                                body.push_back(rest);
+                                auto position = std::find(caller.blocks.begin(), caller.blocks.end(), block);
+                                caller.blocks.insert(position + 1, body.begin(), body.end());
+
+                                // The returned value takes the place of the call's result
+                                if (call->result.kind == Value::Kind::TEMP && !returns.empty())
+                                {
+                                        if (returns.size() == 1)
+                                        {
+                                                replaceUses(call->result, returns.front().value);
+                                        }
+                                        else
+                                        {
+                                                Instruction *phi = arena.make<Instruction>(Opcode::PHI);
+                                                phi->type = callee.returnType;
+                                                phi->result = call->result;
+                                                phi->incoming = static_cast<Incoming *>(
+                                                    arena.allocate(sizeof(Incoming) * returns.size(), alignof(Incoming)));
+                                                std::copy(returns.begin(), returns.end(), phi->incoming);
+                                                phi->incomingCount = static_cast<int>(returns.size());
+                                                phi->next = rest->first;
+                                                rest->first = phi;
+                                        }
+                                }
+                                return rest;
+                        }
+                };
+
+        }
+
+        int inlineCalls(Module &module, const PassOptions &options, std::vector<std::string> &report)
+        {
+                int n = static_cast<int>(module.functions.size());
+                std::unordered_map<std::string, int> index;
+                for (int f = 0; f < n; ++f)
+                {
+                        index[module.functions[f]->name] = f;
+                }
+
+                // Calls to the runtime are not part of the graph
+                std::vector<std::vector<int>> graph(n);
+                for (int f = 0; f < n; ++f)
+                {
+                        for (const Block *block : module.functions[f]->blocks)
+                        {
+                                for (const Instruction *i = block->first; i != nullptr; i = i->next)
+                                {
+                                        auto found = i->op == Opcode::CALL ? index.find(i->callee) : index.end();
+                                        if (found != index.end())
+                                        {
+                                                graph[f].push_back(found->second);
+                                        }
+                                }
+                        }
+                }
+                std::vector<std::vector<int>> order = components(graph);
+                std::vector<bool> recursive(n, false);
+                for (const auto &component : order)
+                {
+                        for (int f : component)
+                        {
+                                recursive[f] = component.size() > 1 ||
+                                               std::find(graph[f].begin(), graph[f].end(), f) != graph[f].end();
+                        }
+                }
+
+                std::vector<std::vector<std::string>> lines(n);
+                int inlined = 0;
+                for (const auto &component : order)
+                {
+                        for (int f : component)
+                        {
+                                Function &caller = *module.functions[f];
+
+                                // The calls as written; those that come with inlined code were
+                                // decided in the function they were copied from
+                                std::vector<std::pair<Block *, Instruction *>> sites;
+                                for (Block *block : caller.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                if (i->op == Opcode::CALL && index.count(i->callee))
+                                                {
+                                                        sites.push_back({block, i});
+                                                }
+                                        }
+                                }
+
+                                int changed = 0;
+                                for (size_t s = 0; s < sites.size(); ++s)
+                                {
+                                        int target = index[sites[s].second->callee];
+                                        const Function &callee = *module.functions[target];
+                                        int calleeSize = size(callee);
+                                        std::string line = caller.name + ": call " + std::to_string(s + 1) + " to " +
+                                                           callee.name + " ";
+                                        if (recursive[target])
+                                        {
+                                                line += "not inlined, recursive";
+                                        }
+                                        else if (callee.returnType != Type::VOID && !returns(callee))
+                                        {
+                                                // Nothing would define the result of the call
+                                                line += "not inlined, never returns";
+                                        }
+                                        else if (calleeSize > options.inlineThreshold)
+                                        {
+                                                line += "not inlined, " + std::to_string(calleeSize) +
+                                                        " instructions over the threshold of " +
+                                                        std::to_string(options.inlineThreshold);
+                                        }
+                                        else
+                                        {
+                                                line += "inlined, " + std::to_string(calleeSize) + " instructions";
+                                                Block *block = sites[s].first;
+                                                Block *rest = CallInliner(caller, callee, block, sites[s].second).run();
+                                                // Later calls of the same block now follow the call in rest
+                                                for (size_t later = s + 1; later < sites.size(); ++later)
+                                                {
+                                                        if (sites[later].first == block)
+                                                        {
+                                                                sites[later].first = rest;
+                                                        }
+                                                }
+                                                ++changed;
+                                        }
+                                        lines[f].push_back(std::move(line));
+                                }
+
+                                // Constant arguments fold in the copies, and so do the checks on them
+                                if (changed > 0 && options.simplifyArithmetic)
+                                {
+                                        simplifyArithmetic(caller);
+                                }
+
+                                // Joins the copies to the code around them
+                                if (changed > 0 && options.simplifyControlFlow)
+                                {
+                                        simplifyControlFlow(caller);
+                                }
+                                inlined += changed;
+                        }
+                }
+
+                for (auto &functionLines : lines)
+                {
+                        for (auto &line : functionLines)
+                        {
+                                report.push_back(std::move(line));
+                        }
+                }
+                return inlined;
+        }
+
+}
@@ -0,0 +1,22 @@
+#ifndef INLINER_HPP
+#define INLINER_HPP
+
+#include <string>
+#include <vector>
+#include "ir.hpp"
+#include "passes.hpp"
+
+namespace ir
+{
+
+    // Replaces the calls to functions of at most options.inlineThreshold
+    // instructions by a copy of their body, callees before their callers, so
+    // a callee is measured with its own calls already inlined. Functions on a
+    // cycle of the call graph are never inlined. Appends a line per call site
+    // to report, saying what was done and why. Returns the number of calls
+    // inlined
+    int inlineCalls(Module &module, const PassOptions &options, std::vector<std::string> &report);
+
+}
+
+#endif // INLINER_HPP
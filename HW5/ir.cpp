@@ -0,0 +1,283 @@
+#include "ir.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace ir
+{
+
+        Instruction::Instruction(Opcode op)
+            : op(op), type(Type::VOID), sourceType(Type::VOID), predicate(Predicate::EQ),
+              result(), lhs(), rhs(), count(-1), callee(nullptr), arguments(nullptr),
+              argumentCount(0), tail(TailCall::NONE), incoming(nullptr), incomingCount(0),
+              target(nullptr), otherwise(nullptr), next(nullptr) {}
+
+        bool Instruction::isTerminator() const
+        {
+                return op == Opcode::BR || op == Opcode::COND_BR || op == Opcode::RET || op == Opcode::UNREACHABLE;
+        }
+
+        Block::Block(int label) : label(label), first(nullptr), last(nullptr), index(-1) {}
+
+        bool Block::isTerminated() const
+        {
+                return last != nullptr && last->isTerminator();
+        }
+
+        Function::Function(const std::string &name, Type returnType, const std::vector<Type> &parameters)
+            : arena(), stringIds(), name(name), returnType(returnType), parameters(parameters),
+              blocks(), strings(), tempCount(0), labelCount(0)
+        {
+                blocks.push_back(arena.make<Block>(-1));
+        }
+
+        ast::Arena &Function::storage()
+        {
+                return arena;
+        }
+
+        int Function::intern(const std::string &text)
+        {
+                auto found = stringIds.emplace(text, static_cast<int>(strings.size()));
+                if (found.second)
+                {
+                        strings.push_back(text);
+                }
+                return found.first->second;
+        }
+
+        Builder::Builder() : function(nullptr), current(nullptr), lastAlloca(nullptr) {}
+
+        void Builder::setFunction(Function *function)
+        {
+                this->function = function;
+                current = function->blocks.front();
+                lastAlloca = nullptr;
+        }
+
+        Function *Builder::getFunction() const
+        {
+                return function;
+        }
+
+        bool Builder::isTerminated() const
+        {
+                return current->isTerminated();
+        }
+
+        Value Builder::temp()
+        {
+                return Value::temp(function->tempCount++);
+        }
+
+        Block *Builder::newBlock()
+        {
+                return function->storage().make<Block>(function->labelCount++);
+        }
+
+        void Builder::place(Block *block)
+        {
+                function->blocks.push_back(block);
+                current = block;
+        }
+
+        Value Builder::string(const std::string &text)
+        {
+                return Value::string(function->intern(text));
+        }
+
+        Instruction *Builder::append(Opcode op)
+        {
+                // Code after a terminator starts an unnamed block, as it does in LLVM
+                if (current->isTerminated())
+                {
+                        Block *unnamed = function->storage().make<Block>(-1);
+                        function->blocks.push_back(unnamed);
+                        current = unnamed;
+                }
+                Instruction *instruction = function->storage().make<Instruction>(op);
+                if (current->last)
+                {
+                        current->last->next = instruction;
+                }
+                else
+                {
+                        current->first = instruction;
+                }
+                current->last = instruction;
+                return instruction;
+        }
+
+        void Builder::addEdge(Block *from, Block *to)
+        {
+                from->successors.push_back(to);
+                to->predecessors.push_back(from);
+        }
+
+        Instruction *Builder::allocate(Value result, Type type, int count)
+        {
+                Instruction *instruction = function->storage().make<Instruction>(Opcode::ALLOCA);
+                instruction->result = result;
+                instruction->type = type;
+                instruction->count = count;
+
+                // Linked in after the previous alloca, ahead of any code of the entry block
+                Block *entry = function->blocks.front();
+                Instruction *&link = lastAlloca ? lastAlloca->next : entry->first;
+                instruction->next = link;
+                link = instruction;
+                if (entry->last == lastAlloca)
+                {
+                        entry->last = instruction;
+                }
+                lastAlloca = instruction;
+                return instruction;
+        }
+
+        void Builder::load(Value result, Type type, Value pointer)
+        {
+                Instruction *instruction = append(Opcode::LOAD);
+                instruction->result = result;
+                instruction->type = type;
+                instruction->lhs = pointer;
+        }
+
+        void Builder::store(Type type, Value value, Value pointer)
+        {
+                Instruction *instruction = append(Opcode::STORE);
+                instruction->type = type;
+                instruction->lhs = value;
+                instruction->rhs = pointer;
+        }
+
+        void Builder::binary(Opcode op, Value result, Type type, Value lhs, Value rhs)
+        {
+                Instruction *instruction = append(op);
+                instruction->result = result;
+                instruction->type = type;
+                instruction->lhs = lhs;
+                instruction->rhs = rhs;
+        }
+
+        void Builder::icmp(Value result, Predicate predicate, Type type, Value lhs, Value rhs)
+        {
+                Instruction *instruction = append(Opcode::ICMP);
+                instruction->result = result;
+                instruction->predicate = predicate;
+                instruction->type = type;
+                instruction->lhs = lhs;
+                instruction->rhs = rhs;
+        }
+
+        void Builder::cast(Opcode op, Value result, Type sourceType, Value value, Type type)
+        {
+                Instruction *instruction = append(op);
+                instruction->result = result;
+                instruction->sourceType = sourceType;
+                instruction->lhs = value;
+                instruction->type = type;
+        }
+
+        void Builder::gep(Value result, Type elementType, Value base, Value index)
+        {
+                Instruction *instruction = append(Opcode::GEP);
+                instruction->result = result;
+                instruction->type = elementType;
+                instruction->lhs = base;
+                instruction->rhs = index;
+        }
+
+        void Builder::call(Value result, Type returnType, const std::string &callee,
+                           const std::vector<Argument> &arguments)
+        {
+                Instruction *instruction = append(Opcode::CALL);
+                instruction->result = result;
+                instruction->type = returnType;
+
+                ast::Arena &arena = function->storage();
+                char *name = static_cast<char *>(arena.allocate(callee.size() + 1, 1));
+                std::memcpy(name, callee.c_str(), callee.size() + 1);
+                instruction->callee = name;
+
+                if (!arguments.empty())
+                {
+                        instruction->arguments = static_cast<Argument *>(
+                            arena.allocate(sizeof(Argument) * arguments.size(), alignof(Argument)));
+                        std::copy(arguments.begin(), arguments.end(), instruction->arguments);
+                }
+                instruction->argumentCount = static_cast<int>(arguments.size());
+        }
+
+        void Builder::phi(Value result, Type type, const std::vector<Incoming> &incoming)
+        {
+                Instruction *instruction = append(Opcode::PHI);
+                instruction->result = result;
+                instruction->type = type;
+                instruction->incoming = static_cast<Incoming *>(function->storage().allocate(
+                    sizeof(Incoming) * incoming.size(), alignof(Incoming)));
+                std::copy(incoming.begin(), incoming.end(), instruction->incoming);
+                instruction->incomingCount = static_cast<int>(incoming.size());
+        }
+
+        void Builder::br(Block *target)
+        {
+                Instruction *instruction = append(Opcode::BR);
+                instruction->target = target;
+                addEdge(current, target);
+        }
+
+        void Builder::condBr(Value condition, Block *target, Block *otherwise)
+        {
+                Instruction *instruction = append(Opcode::COND_BR);
+                instruction->lhs = condition;
+                instruction->target = target;
+                instruction->otherwise = otherwise;
+                addEdge(current, target);
+                addEdge(current, otherwise);
+        }
+
+        void Builder::br(BranchList &list)
+        {
+                Instruction *instruction = append(Opcode::BR);
+                list.push_back(Patch{current, instruction, false});
+        }
+
+        void Builder::condBr(Value condition, BranchList &trueList, BranchList &falseList)
+        {
+                Instruction *instruction = append(Opcode::COND_BR);
+                instruction->lhs = condition;
+                trueList.push_back(Patch{current, instruction, false});
+                falseList.push_back(Patch{current, instruction, true});
+        }
+
+        void Builder::backpatch(const BranchList &list, Block *target)
+        {
+                for (const Patch &patch : list)
+                {
+                        auto &successors = patch.from->successors;
+                        if (patch.otherwise)
+                        {
+                                patch.branch->otherwise = target;
+                                successors.push_back(target);
+                        }
+                        else
+                        {
+                                patch.branch->target = target;
+                                successors.insert(successors.begin(), target);
+                        }
+                        target->predecessors.push_back(patch.from);
+                }
+        }
+
+        void Builder::ret(Type type, Value value)
+        {
+                Instruction *instruction = append(Opcode::RET);
+                instruction->type = type;
+                instruction->lhs = value;
+        }
+
+        void Builder::unreachable()
+        {
+                append(Opcode::UNREACHABLE);
+        }
+
+}
@@ -0,0 +1,349 @@
+#ifndef IR_HPP
+#define IR_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "arena.hpp"
+
+namespace ir
+{
+
+    // Types of IR values, one per LLVM type the compiler emits
+    enum class Type
+    {
+        VOID,
+        I1,
+        I8,
+        I32,
+        I64,
+        I8_PTR
+    };
+
+    /* Value class
+     * Operand of an instruction. Temporaries, arguments and strings are
+     * identified by integers local to their function; the printer turns
+     * them into %tN, %N and @.strN names.
+     */
+    class Value
+    {
+    public:
+        enum class Kind
+        {
+            NONE,
+            TEMP,
+            CONSTANT,
+            ARGUMENT,
+            NULLPTR,
+            // A string constant, the global array itself
+            STRING,
+            // Constant address of the first character of a string constant
+            STRING_ADDRESS
+        };
+
+        Kind kind;
+        int id;
+
+        Value() : kind(Kind::NONE), id(0) {}
+
+        Value(Kind kind, int id) : kind(kind), id(id) {}
+
+        static Value temp(int id) { return Value(Kind::TEMP, id); }
+
+        static Value constant(int value) { return Value(Kind::CONSTANT, value); }
+
+        static Value argument(int index) { return Value(Kind::ARGUMENT, index); }
+
+        static Value null() { return Value(Kind::NULLPTR, 0); }
+
+        static Value string(int id) { return Value(Kind::STRING, id); }
+
+        static Value stringAddress(int id) { return Value(Kind::STRING_ADDRESS, id); }
+
+        bool isNone() const { return kind == Kind::NONE; }
+
+        bool operator==(const Value &other) const { return kind == other.kind && id == other.id; }
+
+        bool operator!=(const Value &other) const { return !(*this == other); }
+    };
+
+    enum class Opcode
+    {
+        ALLOCA,
+        LOAD,
+        STORE,
+        ADD,
+        SUB,
+        MUL,
+        SDIV,
+        AND,
+        OR,
+        XOR,
+        SHL,
+        LSHR,
+        ASHR,
+        ICMP,
+        ZEXT,
+        SEXT,
+        TRUNC,
+        BITCAST,
+        GEP,
+        CALL,
+        BR,
+        COND_BR,
+        RET,
+        PHI,
+        UNREACHABLE
+    };
+
+    enum class Predicate
+    {
+        EQ,
+        NE,
+        SLT,
+        SGT,
+        SLE,
+        SGE,
+        // Unsigned, the analyzer emits them for array bounds checks only
+        ULT,
+        UGT,
+        ULE,
+        UGE
+    };
+
+    class Block;
+
+    // How a call may reuse its caller's frame: TAIL is a hint, MUST guarantees
+    // it and needs the ret of the call's value right after it
+    enum class TailCall
+    {
+        NONE,
+        TAIL,
+        MUST
+    };
+
+    // Argument of a call instruction
+    struct Argument
+    {
+        Type type;
+        Value value;
+    };
+
+    // Incoming value of a phi instruction, one per predecessor of its block
+    struct Incoming
+    {
+        Value value;
+        Block *block;
+    };
+
+    /* Instruction class
+     * One instruction, allocated in its function's arena and linked into its block.
+     * Operand use by opcode:
+     *      ALLOCA      type, count (-1 for a single element)
+     *      LOAD        type, lhs = pointer
+     *      STORE       type, lhs = value, rhs = pointer
+     *      ADD..ASHR   type, lhs, rhs
+     *      ICMP        predicate, type of the operands, lhs, rhs
+     *      ZEXT SEXT TRUNC
+     *                  sourceType, lhs, type = target type
+     *      BITCAST     lhs, sourceType and type = element types of the pointers
+     *      GEP         type = element type, lhs = base, rhs = index.
+     *                  A STRING base addresses its first character
+     *      CALL        type = return type, callee, arguments, tail
+     *      BR          target
+     *      COND_BR     lhs = condition, target, otherwise
+     *      RET         type (VOID for ret void), lhs
+     *      PHI         type, incoming
+     *      UNREACHABLE ends a block that never falls through, e.g. after exit
+     */
+    class Instruction
+    {
+    public:
+        Opcode op;
+        Type type;
+        Type sourceType;
+        Predicate predicate;
+        Value result;
+        Value lhs;
+        Value rhs;
+        int count;
+        const char *callee;
+        Argument *arguments;
+        int argumentCount;
+        TailCall tail;
+        Incoming *incoming;
+        int incomingCount;
+        Block *target;
+        Block *otherwise;
+        Instruction *next;
+
+        explicit Instruction(Opcode op);
+
+        bool isTerminator() const;
+
+        // Calls f on every value the instruction reads; a store's pointer and a
+        // load's pointer included
+        template <typename F>
+        void forEachOperand(F f)
+        {
+            f(lhs);
+            f(rhs);
+            for (int i = 0; i < argumentCount; ++i)
+            {
+                f(arguments[i].value);
+            }
+            for (int i = 0; i < incomingCount; ++i)
+            {
+                f(incoming[i].value);
+            }
+        }
+    };
+
+    /* Block class
+     * Basic block. Labeled blocks print as label_N; a block with no label is
+     * either the entry block or code that follows a terminator, which LLVM
+     * turns into an unnamed block of its own.
+     */
+    class Block
+    {
+    public:
+        // Label number, -1 for an unlabeled block
+        int label;
+        Instruction *first;
+        Instruction *last;
+        // CFG edges, in the order the branches name them, once they are backpatched
+        std::vector<Block *> successors;
+        std::vector<Block *> predecessors;
+        // Scratch number for the passes, e.g. the reverse postorder position
+        int index;
+
+        explicit Block(int label);
+
+        bool isTerminated() const;
+    };
+
+    /* Function class
+     * A function definition: its signature, its blocks in layout order, and
+     * the strings it uses, each text once. Temporaries, labels and strings are
+     * numbered from zero in every function; the printer pools the strings of
+     * all functions.
+     */
+    class Function
+    {
+    private:
+        ast::Arena arena;
+        // Number of each text in strings
+        std::unordered_map<std::string, int> stringIds;
+
+    public:
+        std::string name;
+        Type returnType;
+        std::vector<Type> parameters;
+        std::vector<Block *> blocks;
+        std::vector<std::string> strings;
+        int tempCount;
+        int labelCount;
+
+        Function(const std::string &name, Type returnType, const std::vector<Type> &parameters);
+
+        Function(const Function &) = delete;
+        Function &operator=(const Function &) = delete;
+
+        // Storage for the blocks and instructions of this function
+        ast::Arena &storage();
+
+        // Number of text among the strings, added if it is new
+        int intern(const std::string &text);
+    };
+
+    /* Module class
+     * The whole program: its functions, in source order.
+     */
+    class Module
+    {
+    public:
+        std::vector<std::unique_ptr<Function>> functions;
+    };
+
+    // A branch whose target is not known yet: which block it leaves and which
+    // of its targets is left open
+    struct Patch
+    {
+        Block *from;
+        Instruction *branch;
+        bool otherwise;
+    };
+
+    // Branches of jumping code still waiting for a target, e.g. every branch
+    // taken when a condition is false. Builder::backpatch fills them in
+    using BranchList = std::vector<Patch>;
+
+    /* Builder class
+     * Appends instructions to a function. Temporaries and labels are handed out
+     * separately from the instructions that define them, so numbering follows
+     * the order in which they are requested.
+     * Usage example:
+     *      ir::Value sum = builder.temp();
+     *      builder.binary(ir::Opcode::ADD, sum, ir::Type::I32, a, b);
+     */
+    class Builder
+    {
+    private:
+        Function *function;
+        Block *current;
+        // End of the alloca section at the top of the entry block
+        Instruction *lastAlloca;
+
+        Instruction *append(Opcode op);
+        void addEdge(Block *from, Block *to);
+
+    public:
+        Builder();
+
+        // Starts emitting into a new function, at its entry block
+        void setFunction(Function *function);
+
+        Function *getFunction() const;
+
+        // Whether the block being emitted into already ends in a terminator
+        bool isTerminated() const;
+
+        // A temporary not used before
+        Value temp();
+
+        // A labeled block not used before. It is laid out when placed
+        Block *newBlock();
+
+        // Lays out block after the current one and continues emitting into it
+        void place(Block *block);
+
+        // The string constant of the function with this text, registered on first use
+        Value string(const std::string &text);
+
+        // Stack slots always go to the alloca section of the entry block, so a
+        // declaration inside a loop reuses one slot and LLVM can promote it
+        Instruction *allocate(Value result, Type type, int count = -1);
+        void load(Value result, Type type, Value pointer);
+        void store(Type type, Value value, Value pointer);
+        void binary(Opcode op, Value result, Type type, Value lhs, Value rhs);
+        void icmp(Value result, Predicate predicate, Type type, Value lhs, Value rhs);
+        void cast(Opcode op, Value result, Type sourceType, Value value, Type type);
+        void gep(Value result, Type elementType, Value base, Value index);
+        void call(Value result, Type returnType, const std::string &callee,
+                  const std::vector<Argument> &arguments);
+        void phi(Value result, Type type, const std::vector<Incoming> &incoming);
+        void br(Block *target);
+        void condBr(Value condition, Block *target, Block *otherwise);
+        // Branches whose targets are decided later, recorded in the given lists
+        void br(BranchList &list);
+        void condBr(Value condition, BranchList &trueList, BranchList &falseList);
+        // Points every branch of the list at target
+        void backpatch(const BranchList &list, Block *target);
+        void ret(Type type, Value value = Value());
+        void unreachable();
+    };
+
+}
+
+#endif // IR_HPP
@@ -0,0 +1,496 @@
+#include "irPrinter.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ir
+{
+
+        // Branch weights of a check, the side that ends in a trap taken once in 2000
+        static const char branchWeights[] =
+            "!0 = !{!\"branch_weights\", i32 1, i32 2000}\n"
+            "!1 = !{!\"branch_weights\", i32 2000, i32 1}\n";
+
+        // Runtime support the generated code calls into
+        static const char runtime[] =
+            "declare i32 @scanf(i8*, ...)\n\n"
+            "declare i32 @printf(i8*, ...)\n\n"
+            "declare void @exit(i32) cold noreturn\n\n"
+            "declare void @llvm.lifetime.start.p0i8(i64, i8*)\n\n"
+            "declare void @llvm.lifetime.end.p0i8(i64, i8*)\n\n"
+            "declare void @llvm.memset.p0i8.i32(i8*, i8, i32, i1)\n\n"
+            "@.int_specifier_scan = constant [3 x i8] c\"%d\\00\"\n\n"
+            "@.int_specifier = constant [4 x i8] c\"%d\\0A\\00\"\n\n"
+            "@.str_specifier = constant [4 x i8] c\"%s\\0A\\00\"\n\n\n"
+            "define i32 @readi(i32) {\n\n"
+            "    %ret_val = alloca i32\n\n"
+            "    %spec_ptr = getelementptr [3 x i8], [3 x i8]* @.int_specifier_scan, i32 0, i32 0\n\n"
+            "    call i32 (i8*, ...) @scanf(i8* %spec_ptr, i32* %ret_val)\n\n"
+            "    %val = load i32, i32* %ret_val\n\n"
+            "    ret i32 %val\n\n"
+            "}\n\n\n"
+            "define void @printi(i32) {\n\n"
+            "    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.int_specifier, i32 0, i32 0\n\n"
+            "    call i32 (i8*, ...) @printf(i8* %spec_ptr, i32 %0)\n\n"
+            "    ret void\n\n"
+            "}\n\n\n"
+            "define void @print(i8*) {\n\n"
+            "    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.str_specifier, i32 0, i32 0\n\n"
+            "    call i32 (i8*, ...) @printf(i8* %spec_ptr, i8* %0)\n\n"
+            "    ret void\n\n"
+            "}\n\n\n";
+
+        static void markUsed(const Value &value, std::vector<bool> &used)
+        {
+                if (value.kind == Value::Kind::STRING || value.kind == Value::Kind::STRING_ADDRESS)
+                {
+                        used[value.id] = true;
+                }
+        }
+
+        // Which strings of the function its remaining code still refers to
+        static std::vector<bool> usedStrings(const Function &function)
+        {
+                std::vector<bool> used(function.strings.size(), false);
+                for (const Block *block : function.blocks)
+                {
+                        for (const Instruction *i = block->first; i != nullptr; i = i->next)
+                        {
+                                markUsed(i->lhs, used);
+                                markUsed(i->rhs, used);
+                                for (int k = 0; k < i->argumentCount; ++k)
+                                {
+                                        markUsed(i->arguments[k].value, used);
+                                }
+                        }
+                }
+                return used;
+        }
+
+        /* FunctionPrinter class
+         * Prints one function, shifting its local numbers by the counts of the
+         * functions printed before it. Its strings print as the globals of the
+         * module's string pool.
+         */
+        class FunctionPrinter
+        {
+        private:
+            const Function &function;
+            output::ChunkBuffer &out;
+            int tempBase;
+            int labelBase;
+            // Pool number of each string of the function
+            const std::vector<int> &globals;
+
+        public:
+            FunctionPrinter(const Function &function, output::ChunkBuffer &out,
+                            int tempBase, int labelBase, const std::vector<int> &globals)
+                : function(function), out(out), tempBase(tempBase), labelBase(labelBase),
+                  globals(globals) {}
+
+            void type(Type type)
+            {
+                switch (type)
+                {
+                case Type::VOID:
+                        out.append("void");
+                        break;
+                case Type::I1:
+                        out.append("i1");
+                        break;
+                case Type::I8:
+                        out.append("i8");
+                        break;
+                case Type::I32:
+                        out.append("i32");
+                        break;
+                case Type::I64:
+                        out.append("i64");
+                        break;
+                case Type::I8_PTR:
+                        out.append("i8*");
+                        break;
+                }
+            }
+
+            // [N x i8] of a string constant, N counting the terminating zero
+            void stringType(int id)
+            {
+                out.append('[');
+                out.appendInt(function.strings[id].size() + 1);
+                out.append(" x i8]");
+            }
+
+            void value(Value value)
+            {
+                switch (value.kind)
+                {
+                case Value::Kind::NONE:
+                        break;
+                case Value::Kind::TEMP:
+                        out.append("%t");
+                        out.appendInt(value.id + tempBase);
+                        break;
+                case Value::Kind::CONSTANT:
+                        out.appendInt(value.id);
+                        break;
+                case Value::Kind::ARGUMENT:
+                        out.append('%');
+                        out.appendInt(value.id);
+                        break;
+                case Value::Kind::NULLPTR:
+                        out.append("null");
+                        break;
+                case Value::Kind::STRING:
+                        out.append("@.str");
+                        out.appendInt(globals[value.id]);
+                        break;
+                case Value::Kind::STRING_ADDRESS:
+                        out.append("getelementptr (");
+                        stringType(value.id);
+                        out.append(", ");
+                        stringType(value.id);
+                        out.append("* ");
+                        this->value(Value::string(value.id));
+                        out.append(", i32 0, i32 0)");
+                        break;
+                }
+            }
+
+            void label(const Block *block)
+            {
+                out.append("%label_");
+                out.appendInt(block->label + labelBase);
+            }
+
+            // "T v, T* p", the operands of load and store
+            void typedPointer(Type elementType, Value pointer)
+            {
+                type(elementType);
+                out.append(", ");
+                type(elementType);
+                out.append("* ");
+                value(pointer);
+            }
+
+            void instruction(const Instruction &instruction)
+            {
+                if (!instruction.result.isNone())
+                {
+                        value(instruction.result);
+                        out.append(" = ");
+                }
+                switch (instruction.op)
+                {
+                case Opcode::ALLOCA:
+                        out.append("alloca ");
+                        type(instruction.type);
+                        if (instruction.count >= 0)
+                        {
+                                out.append(", i32 ");
+                                out.appendInt(instruction.count);
+                        }
+                        break;
+                case Opcode::LOAD:
+                        out.append("load ");
+                        typedPointer(instruction.type, instruction.lhs);
+                        break;
+                case Opcode::STORE:
+                        out.append("store ");
+                        type(instruction.type);
+                        out.append(' ');
+                        value(instruction.lhs);
+                        out.append(", ");
+                        type(instruction.type);
+                        out.append("* ");
+                        value(instruction.rhs);
+                        break;
+                case Opcode::ADD:
+                case Opcode::SUB:
+                case Opcode::MUL:
+                case Opcode::SDIV:
+                case Opcode::AND:
+                case Opcode::OR:
+                case Opcode::XOR:
+                case Opcode::SHL:
+                case Opcode::LSHR:
+                case Opcode::ASHR:
+                        out.append(binaryName(instruction.op));
+                        out.append(' ');
+                        type(instruction.type);
+                        out.append(' ');
+                        value(instruction.lhs);
+                        out.append(", ");
+                        value(instruction.rhs);
+                        break;
+                case Opcode::ICMP:
+                        out.append("icmp ");
+                        out.append(predicateName(instruction.predicate));
+                        out.append(' ');
+                        type(instruction.type);
+                        out.append(' ');
+                        value(instruction.lhs);
+                        out.append(", ");
+                        value(instruction.rhs);
+                        break;
+                case Opcode::ZEXT:
+                case Opcode::SEXT:
+                case Opcode::TRUNC:
+                        out.append(instruction.op == Opcode::ZEXT   ? "zext "
+                                   : instruction.op == Opcode::SEXT ? "sext "
+                                                                    : "trunc ");
+                        type(instruction.sourceType);
+                        out.append(' ');
+                        value(instruction.lhs);
+                        out.append(" to ");
+                        type(instruction.type);
+                        break;
+                case Opcode::BITCAST:
+                        out.append("bitcast ");
+                        type(instruction.sourceType);
+                        out.append("* ");
+                        value(instruction.lhs);
+                        out.append(" to ");
+                        type(instruction.type);
+                        out.append('*');
+                        break;
+                case Opcode::GEP:
+                        out.append("getelementptr ");
+                        if (instruction.lhs.kind == Value::Kind::STRING)
+                        {
+                                stringType(instruction.lhs.id);
+                                out.append(", ");
+                                stringType(instruction.lhs.id);
+                                out.append("* ");
+                                value(instruction.lhs);
+                                out.append(", i32 0, i32 0");
+                        }
+                        else
+                        {
+                                typedPointer(instruction.type, instruction.lhs);
+                                out.append(", i32 ");
+                                value(instruction.rhs);
+                        }
+                        break;
+                case Opcode::CALL:
+                        if (instruction.tail == TailCall::TAIL)
+                        {
+                                out.append("tail ");
+                        }
+                        else if (instruction.tail == TailCall::MUST)
+                        {
+                                out.append("musttail ");
+                        }
+                        out.append("call ");
+                        type(instruction.type);
+                        out.append(" @");
+                        out.append(instruction.callee);
+                        out.append('(');
+                        for (int i = 0; i < instruction.argumentCount; ++i)
+                        {
+                                if (i > 0)
+                                {
+                                        out.append(", ");
+                                }
+                                type(instruction.arguments[i].type);
+                                out.append(' ');
+                                value(instruction.arguments[i].value);
+                        }
+                        out.append(')');
+                        break;
+                case Opcode::BR:
+                        out.append("br label ");
+                        label(instruction.target);
+                        break;
+                case Opcode::COND_BR:
+                        out.append("br i1 ");
+                        value(instruction.lhs);
+                        out.append(", label ");
+                        label(instruction.target);
+                        out.append(", label ");
+                        label(instruction.otherwise);
+                        if (traps(instruction.target))
+                        {
+                                out.append(", !prof !0");
+                        }
+                        else if (traps(instruction.otherwise))
+                        {
+                                out.append(", !prof !1");
+                        }
+                        break;
+                case Opcode::PHI:
+                        out.append("phi ");
+                        type(instruction.type);
+                        for (int i = 0; i < instruction.incomingCount; ++i)
+                        {
+                                out.append(i > 0 ? ", [ " : " [ ");
+                                value(instruction.incoming[i].value);
+                                out.append(", ");
+                                label(instruction.incoming[i].block);
+                                out.append(" ]");
+                        }
+                        break;
+                case Opcode::RET:
+                        out.append("ret ");
+                        type(instruction.type);
+                        if (instruction.type != Type::VOID)
+                        {
+                                out.append(' ');
+                                value(instruction.lhs);
+                        }
+                        break;
+                case Opcode::UNREACHABLE:
+                        out.append("unreachable");
+                        break;
+                }
+                out.append('\n');
+            }
+
+            // Blocks that never fall through only exit the program, e.g. on a failed check
+            static bool traps(const Block *block)
+            {
+                return block->last != nullptr && block->last->op == Opcode::UNREACHABLE;
+            }
+
+            static const char *binaryName(Opcode op)
+            {
+                switch (op)
+                {
+                case Opcode::ADD:
+                        return "add";
+                case Opcode::SUB:
+                        return "sub";
+                case Opcode::MUL:
+                        return "mul";
+                case Opcode::SDIV:
+                        return "sdiv";
+                case Opcode::AND:
+                        return "and";
+                case Opcode::OR:
+                        return "or";
+                case Opcode::SHL:
+                        return "shl";
+                case Opcode::LSHR:
+                        return "lshr";
+                case Opcode::ASHR:
+                        return "ashr";
+                default:
+                        return "xor";
+                }
+            }
+
+            static const char *predicateName(Predicate predicate)
+            {
+                switch (predicate)
+                {
+                case Predicate::EQ:
+                        return "eq";
+                case Predicate::NE:
+                        return "ne";
+                case Predicate::SLT:
+                        return "slt";
+                case Predicate::SGT:
+                        return "sgt";
+                case Predicate::SLE:
+                        return "sle";
+                case Predicate::SGE:
+                        return "sge";
+                case Predicate::ULT:
+                        return "ult";
+                case Predicate::UGT:
+                        return "ugt";
+                case Predicate::ULE:
+                        return "ule";
+                default:
+                        return "uge";
+                }
+            }
+
+            void print()
+            {
+                out.append("define ");
+                type(function.returnType);
+                out.append(" @");
+                out.append(function.name);
+                out.append('(');
+                for (size_t i = 0; i < function.parameters.size(); ++i)
+                {
+                        if (i > 0)
+                        {
+                                out.append(", ");
+                        }
+                        type(function.parameters[i]);
+                }
+                out.append(") {\n");
+
+                for (const Block *block : function.blocks)
+                {
+                        if (block->label >= 0)
+                        {
+                                out.append("label_");
+                                out.appendInt(block->label + labelBase);
+                                out.append(":\n");
+                        }
+                        for (const Instruction *i = block->first; i != nullptr; i = i->next)
+                        {
+                                instruction(*i);
+                        }
+                }
+                out.append("}\n\n");
+            }
+
+            // Defines the string as the next global of the pool
+            void defineString(int id)
+            {
+                value(Value::string(id));
+                out.append(" = private unnamed_addr constant ");
+                stringType(id);
+                out.append(" c\"");
+                out.append(function.strings[id]);
+                out.append("\\00\"");
+            }
+        };
+
+        void print(const Module &module, output::ChunkBuffer &out)
+        {
+                // One global per distinct text, whichever functions use it. All of
+                // them go on the first line, back to back. Strings only removed
+                // code used get none
+                std::unordered_map<std::string, int> pool;
+                std::vector<std::vector<int>> globals(module.functions.size());
+                for (size_t f = 0; f < module.functions.size(); ++f)
+                {
+                        const Function &function = *module.functions[f];
+                        FunctionPrinter printer(function, out, 0, 0, globals[f]);
+                        std::vector<bool> used = usedStrings(function);
+                        for (size_t id = 0; id < function.strings.size(); ++id)
+                        {
+                                if (!used[id])
+                                {
+                                        globals[f].push_back(-1);
+                                        continue;
+                                }
+                                auto found = pool.emplace(function.strings[id], static_cast<int>(pool.size()));
+                                globals[f].push_back(found.first->second);
+                                if (found.second)
+                                {
+                                        printer.defineString(static_cast<int>(id));
+                                }
+                        }
+                }
+                out.append('\n');
+                out.append(runtime);
+
+                int tempBase = 0;
+                int labelBase = 0;
+                for (size_t f = 0; f < module.functions.size(); ++f)
+                {
+                        const Function &function = *module.functions[f];
+                        FunctionPrinter(function, out, tempBase, labelBase, globals[f]).print();
+                        tempBase += function.tempCount;
+                        labelBase += function.labelCount;
+                }
+                out.append(branchWeights);
+        }
+
+}
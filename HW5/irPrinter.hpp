@@ -0,0 +1,18 @@
+#ifndef IR_PRINTER_HPP
+#define IR_PRINTER_HPP
+
+#include "chunkBuffer.hpp"
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // Prints the module as LLVM assembly: the string constants, the runtime
+    // functions, then every function of the program. Temporaries and labels
+    // are numbered across the whole module in function order; each distinct
+    // string text is one private global, shared by every function using it.
+    void print(const Module &module, output::ChunkBuffer &out);
+
+}
+
+#endif // IR_PRINTER_HPP
@@ -0,0 +1,403 @@
+#include "linearScan.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace ir
+{
+
+        int valueIndex(const Function &function, Value value)
+        {
+                if (value.kind == Value::Kind::TEMP)
+                {
+                        return value.id;
+                }
+                if (value.kind == Value::Kind::ARGUMENT)
+                {
+                        return function.tempCount + value.id;
+                }
+                return -1;
+        }
+
+        namespace
+        {
+
+                /* ValueSet class
+                 * Set of values of one function, a bit each.
+                 */
+                class ValueSet
+                {
+                private:
+                    std::vector<std::uint64_t> words;
+
+                public:
+                    explicit ValueSet(int size) : words((size + 63) / 64, 0) {}
+
+                    void insert(int value)
+                    {
+                            words[value / 64] |= std::uint64_t(1) << (value % 64);
+                    }
+
+                    bool contains(int value) const
+                    {
+                            return (words[value / 64] >> (value % 64)) & 1;
+                    }
+
+                    // Adds the values of other that are not in removed; true if that added any
+                    bool uniteExcept(const ValueSet &other, const ValueSet &removed)
+                    {
+                            bool changed = false;
+                            for (size_t i = 0; i < words.size(); ++i)
+                            {
+                                    std::uint64_t added = other.words[i] & ~removed.words[i] & ~words[i];
+                                    if (added != 0)
+                                    {
+                                            words[i] |= added;
+                                            changed = true;
+                                    }
+                            }
+                            return changed;
+                    }
+
+                    template <typename F>
+                    void forEach(F f) const
+                    {
+                            for (size_t i = 0; i < words.size(); ++i)
+                            {
+                                    for (std::uint64_t word = words[i]; word != 0; word &= word - 1)
+                                    {
+                                            f(static_cast<int>(i * 64 + __builtin_ctzll(word)));
+                                    }
+                            }
+                    }
+                };
+
+                // Lifetime markers are the only calls that emit no code
+                bool isCall(const Instruction *instruction)
+                {
+                        return instruction->op == Opcode::CALL &&
+                               std::strncmp(instruction->callee, "llvm.lifetime.", 14) != 0;
+                }
+
+                // Instructions whose result starts as a copy of their first operand
+                bool copiesOperand(Opcode op)
+                {
+                        switch (op)
+                        {
+                        case Opcode::ADD:
+                        case Opcode::SUB:
+                        case Opcode::MUL:
+                        case Opcode::AND:
+                        case Opcode::OR:
+                        case Opcode::XOR:
+                        case Opcode::SHL:
+                        case Opcode::LSHR:
+                        case Opcode::ASHR:
+                        case Opcode::ZEXT:
+                        case Opcode::SEXT:
+                        case Opcode::TRUNC:
+                        case Opcode::BITCAST:
+                                return true;
+                        default:
+                                return false;
+                        }
+                }
+
+                /* LinearScan class
+                 * Numbers the instructions two positions apart in layout order, with a
+                 * position of its own for the start and the end of every block. Phis
+                 * take effect at the start of their block and their incoming values
+                 * are used at the end of the predecessor. A live range runs from the
+                 * first to the last position its value is defined, used or live at.
+                 */
+                class LinearScan
+                {
+                private:
+                    const Function &function;
+                    const std::vector<bool> &located;
+                    const std::vector<int> &preferred;
+                    int registers;
+                    int preserved;
+                    int valueCount;
+                    // Live range of each value, start -1 if it has none
+                    std::vector<int> starts;
+                    std::vector<int> ends;
+                    // Positions of the calls, ascending
+                    std::vector<int> calls;
+                    // Values each value would share a register with
+                    std::vector<std::vector<int>> partners;
+                    Allocation allocation;
+
+                    int index(Value value) const
+                    {
+                            int i = valueIndex(function, value);
+                            return i >= 0 && located[i] ? i : -1;
+                    }
+
+                    void extend(int value, int position)
+                    {
+                            if (starts[value] < 0 || position < starts[value])
+                            {
+                                    starts[value] = position;
+                            }
+                            ends[value] = std::max(ends[value], position);
+                    }
+
+                    void pair(int a, int b)
+                    {
+                            if (a >= 0 && b >= 0)
+                            {
+                                    partners[a].push_back(b);
+                                    partners[b].push_back(a);
+                            }
+                    }
+
+                    void computeRanges()
+                    {
+                            size_t count = function.blocks.size();
+                            std::unordered_map<const Block *, size_t> order;
+                            for (size_t i = 0; i < count; ++i)
+                            {
+                                    order[function.blocks[i]] = i;
+                            }
+
+                            // Values used before any definition in the block, values defined in
+                            // it, and values the phis of its successors take from it
+                            std::vector<ValueSet> uses(count, ValueSet(valueCount));
+                            std::vector<ValueSet> defs(count, ValueSet(valueCount));
+                            std::vector<ValueSet> phiUses(count, ValueSet(valueCount));
+                            for (size_t b = 0; b < count; ++b)
+                            {
+                                    for (Instruction *i = function.blocks[b]->first; i != nullptr; i = i->next)
+                                    {
+                                            int result = index(i->result);
+                                            if (i->op == Opcode::PHI)
+                                            {
+                                                    for (int k = 0; k < i->incomingCount; ++k)
+                                                    {
+                                                            int value = index(i->incoming[k].value);
+                                                            auto from = order.find(i->incoming[k].block);
+                                                            if (value >= 0 && from != order.end())
+                                                            {
+                                                                    phiUses[from->second].insert(value);
+                                                            }
+                                                            pair(result, value);
+                                                    }
+                                            }
+                                            else
+                                            {
+                                                    i->forEachOperand([&](Value operand) {
+                                                            int value = index(operand);
+                                                            if (value >= 0 && !defs[b].contains(value))
+                                                            {
+                                                                    uses[b].insert(value);
+                                                            }
+                                                    });
+                                                    if (copiesOperand(i->op))
+                                                    {
+                                                            pair(result, index(i->lhs));
+                                                    }
+                                            }
+                                            if (result >= 0)
+                                            {
+                                                    defs[b].insert(result);
+                                            }
+                                    }
+                            }
+
+                            std::vector<ValueSet> liveIn(count, ValueSet(valueCount));
+                            std::vector<ValueSet> liveOut(phiUses);
+                            ValueSet none(valueCount);
+                            for (bool changed = true; changed;)
+                            {
+                                    changed = false;
+                                    for (size_t b = count; b-- > 0;)
+                                    {
+                                            for (const Block *successor : function.blocks[b]->successors)
+                                            {
+                                                    auto to = order.find(successor);
+                                                    if (to != order.end())
+                                                    {
+                                                            liveOut[b].uniteExcept(liveIn[to->second], none);
+                                                    }
+                                            }
+                                            changed |= liveIn[b].uniteExcept(uses[b], none);
+                                            changed |= liveIn[b].uniteExcept(liveOut[b], defs[b]);
+                                    }
+                            }
+
+                            int position = 0;
+                            for (int k = 0; k < static_cast<int>(function.parameters.size()); ++k)
+                            {
+                                    extend(function.tempCount + k, 0);
+                            }
+                            for (size_t b = 0; b < count; ++b)
+                            {
+                                    int start = position;
+                                    position += 2;
+                                    liveIn[b].forEach([&](int value) { extend(value, start); });
+                                    for (Instruction *i = function.blocks[b]->first; i != nullptr; i = i->next)
+                                    {
+                                            int result = index(i->result);
+                                            if (i->op == Opcode::PHI)
+                                            {
+                                                    if (result >= 0)
+                                                    {
+                                                            extend(result, start);
+                                                    }
+                                                    continue;
+                                            }
+                                            i->forEachOperand([&](Value operand) {
+                                                    int value = index(operand);
+                                                    if (value >= 0)
+                                                    {
+                                                            extend(value, position);
+                                                    }
+                                            });
+                                            if (result >= 0)
+                                            {
+                                                    extend(result, position);
+                                            }
+                                            if (isCall(i))
+                                            {
+                                                    calls.push_back(position);
+                                            }
+                                            position += 2;
+                                    }
+                                    int end = position;
+                                    position += 2;
+                                    liveOut[b].forEach([&](int value) { extend(value, end); });
+                            }
+
+                            // A value never used still takes its register for a moment, so
+                            // nothing defined at the same position shares it
+                            for (int value = 0; value < valueCount; ++value)
+                            {
+                                    if (starts[value] >= 0 && ends[value] == starts[value])
+                                    {
+                                            ends[value] = starts[value] + 1;
+                                    }
+                            }
+                    }
+
+                    bool acrossCall(int value) const
+                    {
+                            auto call = std::upper_bound(calls.begin(), calls.end(), starts[value]);
+                            return call != calls.end() && *call < ends[value];
+                    }
+
+                    void spill(int value)
+                    {
+                            allocation.registers[value] = -1;
+                            allocation.slots[value] = allocation.slotCount++;
+                    }
+
+                public:
+                    LinearScan(const Function &function, const std::vector<bool> &located,
+                               const std::vector<int> &preferred, int registers, int preserved)
+                        : function(function), located(located), preferred(preferred),
+                          registers(registers), preserved(preserved),
+                          valueCount(function.tempCount + static_cast<int>(function.parameters.size())),
+                          starts(valueCount, -1), ends(valueCount, -1), partners(valueCount)
+                    {
+                            allocation.registers.assign(valueCount, -1);
+                            allocation.slots.assign(valueCount, -1);
+                            allocation.used.assign(registers, false);
+                    }
+
+                    Allocation run()
+                    {
+                            computeRanges();
+
+                            std::vector<int> queue;
+                            for (int value = 0; value < valueCount; ++value)
+                            {
+                                    if (starts[value] >= 0)
+                                    {
+                                            queue.push_back(value);
+                                    }
+                            }
+                            std::sort(queue.begin(), queue.end(), [&](int a, int b) {
+                                    return starts[a] != starts[b] ? starts[a] < starts[b] : a < b;
+                            });
+
+                            // Values holding a register, by ascending end. A range ending
+                            // where another starts leaves its register to it: operands are
+                            // read before the result is written
+                            std::vector<int> active;
+                            std::vector<bool> free(registers, true);
+                            for (int value : queue)
+                            {
+                                    while (!active.empty() && ends[active.front()] <= starts[value])
+                                    {
+                                            free[allocation.registers[active.front()]] = true;
+                                            active.erase(active.begin());
+                                    }
+
+                                    int first = acrossCall(value) ? registers - preserved : 0;
+                                    auto usable = [&](int reg) { return reg >= first && free[reg]; };
+                                    int chosen = -1;
+                                    if (preferred[value] >= 0 && usable(preferred[value]))
+                                    {
+                                            chosen = preferred[value];
+                                    }
+                                    for (size_t k = 0; chosen < 0 && k < partners[value].size(); ++k)
+                                    {
+                                            int reg = allocation.registers[partners[value][k]];
+                                            if (reg >= 0 && usable(reg))
+                                            {
+                                                    chosen = reg;
+                                            }
+                                    }
+                                    for (int reg = first; chosen < 0 && reg < registers; ++reg)
+                                    {
+                                            if (free[reg])
+                                            {
+                                                    chosen = reg;
+                                            }
+                                    }
+
+                                    if (chosen < 0)
+                                    {
+                                            // Of the value and the active ones it could take the
+                                            // register of, the one that lives longest goes to memory
+                                            auto victim = active.end();
+                                            for (auto a = active.begin(); a != active.end(); ++a)
+                                            {
+                                                    if (allocation.registers[*a] >= first &&
+                                                        (victim == active.end() || ends[*a] > ends[*victim]))
+                                                    {
+                                                            victim = a;
+                                                    }
+                                            }
+                                            if (victim == active.end() || ends[*victim] <= ends[value])
+                                            {
+                                                    spill(value);
+                                                    continue;
+                                            }
+                                            chosen = allocation.registers[*victim];
+                                            spill(*victim);
+                                            active.erase(victim);
+                                    }
+
+                                    allocation.registers[value] = chosen;
+                                    allocation.used[chosen] = true;
+                                    free[chosen] = false;
+                                    active.insert(std::upper_bound(active.begin(), active.end(), value,
+                                                                   [&](int a, int b) { return ends[a] < ends[b]; }),
+                                                  value);
+                            }
+                            return allocation;
+                    }
+                };
+
+        }
+
+        Allocation allocateRegisters(const Function &function, const std::vector<bool> &located,
+                                     const std::vector<int> &preferred, int registers, int preserved)
+        {
+                return LinearScan(function, located, preferred, registers, preserved).run();
+        }
+
+}
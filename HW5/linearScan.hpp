@@ -0,0 +1,42 @@
+#ifndef LINEAR_SCAN_HPP
+#define LINEAR_SCAN_HPP
+
+#include <vector>
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // Number of a temporary or argument among the values of a function that
+    // may need a location: temporaries first, then the arguments. -1 for
+    // constants, strings and nothing
+    int valueIndex(const Function &function, Value value);
+
+    // Where every value of a function lives, for the whole of its live range
+    struct Allocation
+    {
+        // Register of each value, -1 if it is spilled or has no location
+        std::vector<int> registers;
+        // Stack slot of each spilled value, -1 otherwise
+        std::vector<int> slots;
+        int slotCount = 0;
+        // Registers holding some value of the function
+        std::vector<bool> used;
+    };
+
+    // Linear scan register allocation, after Poletto and Sarkar, over live
+    // ranges without holes in block layout order. located tells which values
+    // need a location; the others, e.g. stack addresses the backend folds
+    // into operands, are neither allocated nor kept live. Registers are
+    // numbered from 0 to registers - 1, and the last preserved of them are the
+    // only ones a call leaves alone: a value live across a call gets one of
+    // those or a stack slot. preferred gives a register to try first for a
+    // value, -1 for none; besides, phis and their incoming values, and
+    // results and their first operand, share a register when they can, so
+    // the copies between them disappear
+    Allocation allocateRegisters(const Function &function, const std::vector<bool> &located,
+                                 const std::vector<int> &preferred, int registers, int preserved);
+
+}
+
+#endif // LINEAR_SCAN_HPP
@@ -0,0 +1,667 @@
+#include "loopInvariants.hpp"
+#include "cfg.hpp"
+#include "mem2reg.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                // Blocks that print an error and exit; memory no longer matters there
+                bool isTrap(const Block *block)
+                {
+                        return block->last != nullptr && block->last->op == Opcode::UNREACHABLE;
+                }
+
+                void unlink(Block *block, Instruction *instruction)
+                {
+                        Instruction *previous = nullptr;
+                        for (Instruction *i = block->first; i != instruction; i = i->next)
+                        {
+                                previous = i;
+                        }
+                        (previous ? previous->next : block->first) = instruction->next;
+                        if (block->last == instruction)
+                        {
+                                block->last = previous;
+                        }
+                        instruction->next = nullptr;
+                }
+
+                void insertBefore(Block *block, Instruction *position, Instruction *instruction)
+                {
+                        Instruction *previous = nullptr;
+                        for (Instruction *i = block->first; i != position; i = i->next)
+                        {
+                                previous = i;
+                        }
+                        (previous ? previous->next : block->first) = instruction;
+                        instruction->next = position;
+                }
+
+                // Points the branch at the end of from to to instead of target
+                void retarget(Block *from, Block *target, Block *to)
+                {
+                        Instruction *branch = from->last;
+                        if (branch->target == target)
+                        {
+                                branch->target = to;
+                        }
+                        if (branch->otherwise == target)
+                        {
+                                branch->otherwise = to;
+                        }
+                        std::replace(from->successors.begin(), from->successors.end(), target, to);
+                }
+
+                void renameIncoming(Block *block, const Block *from, Block *to)
+                {
+                        for (Instruction *i = block->first; i != nullptr && i->op == Opcode::PHI; i = i->next)
+                        {
+                                for (int k = 0; k < i->incomingCount; ++k)
+                                {
+                                        if (i->incoming[k].block == from)
+                                        {
+                                                i->incoming[k].block = to;
+                                        }
+                                }
+                        }
+                }
+
+                // A natural loop: its header, the blocks of its body in reverse
+                // postorder, and the one block that enters it
+                struct Loop
+                {
+                        Block *header;
+                        std::vector<Block *> blocks;
+                        std::vector<bool> member;
+                        Block *preheader;
+
+                        bool contains(const Block *block) const
+                        {
+                                return block->index >= 0 && member[block->index];
+                        }
+                };
+
+                /* LoopInvariantMotion class
+                 * The loops of a function, innermost first, and where each
+                 * temporary is defined, kept up to date as instructions move.
+                 */
+                class LoopInvariantMotion
+                {
+                private:
+                        Function &function;
+                        bool promoteElements;
+                        LoopInvariantCounts counts;
+                        // By temporary: the instruction defining it and its block
+                        std::vector<Instruction *> definition;
+                        std::vector<Block *> definedIn;
+                        // Temporaries a branch to an error block tests, the compares of the checks
+                        std::vector<bool> guards;
+
+                        // A block heads a loop when it dominates one of its predecessors
+                        std::vector<Loop> findLoops(const DominatorTree &tree) const
+                        {
+                                const std::vector<Block *> &order = tree.order();
+                                std::vector<Loop> loops;
+                                for (Block *header : order)
+                                {
+                                        Loop loop{header, {}, std::vector<bool>(order.size(), false), nullptr};
+                                        std::vector<Block *> work;
+                                        for (Block *predecessor : header->predecessors)
+                                        {
+                                                if (predecessor->index >= 0 && tree.dominates(header, predecessor))
+                                                {
+                                                        work.push_back(predecessor);
+                                                }
+                                        }
+                                        if (work.empty())
+                                        {
+                                                continue;
+                                        }
+                                        loop.member[header->index] = true;
+                                        while (!work.empty())
+                                        {
+                                                Block *block = work.back();
+                                                work.pop_back();
+                                                if (block->index < 0 || loop.member[block->index])
+                                                {
+                                                        continue;
+                                                }
+                                                loop.member[block->index] = true;
+                                                for (Block *predecessor : block->predecessors)
+                                                {
+                                                        work.push_back(predecessor);
+                                                }
+                                        }
+                                        for (Block *block : order)
+                                        {
+                                                if (loop.member[block->index])
+                                                {
+                                                        loop.blocks.push_back(block);
+                                                }
+                                        }
+                                        for (Block *predecessor : header->predecessors)
+                                        {
+                                                if (!loop.contains(predecessor))
+                                                {
+                                                        loop.preheader = predecessor;
+                                                }
+                                        }
+                                        loops.push_back(std::move(loop));
+                                }
+                                std::stable_sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b) {
+                                        return a.blocks.size() < b.blocks.size();
+                                });
+                                return loops;
+                        }
+
+                        Block *newBlock(Block *target)
+                        {
+                                ast::Arena &arena = function.storage();
+                                Block *block = arena.make<Block>(function.labelCount++);
+                                Instruction *jump = arena.make<Instruction>(Opcode::BR);
+                                jump->target = target;
+                                block->first = block->last = jump;
+                                block->successors.push_back(target);
+                                return block;
+                        }
+
+                        // Makes a block that only jumps to the header the one way into
+                        // the loop. Phis of the header that several entering blocks
+                        // feed get a phi of their own in it
+                        bool addPreheader(const Loop &loop)
+                        {
+                                Block *header = loop.header;
+                                std::vector<Block *> entering;
+                                for (Block *predecessor : header->predecessors)
+                                {
+                                        if (!loop.contains(predecessor))
+                                        {
+                                                entering.push_back(predecessor);
+                                        }
+                                }
+                                if (entering.empty() || (entering.size() == 1 && entering[0]->successors.size() == 1 &&
+                                                         entering[0]->last->op == Opcode::BR))
+                                {
+                                        return false;
+                                }
+
+                                Block *preheader = newBlock(header);
+                                ast::Arena &arena = function.storage();
+                                for (Instruction *phi = header->first; phi != nullptr && phi->op == Opcode::PHI; phi = phi->next)
+                                {
+                                        std::vector<Incoming> inside;
+                                        std::vector<Incoming> outside;
+                                        for (int k = 0; k < phi->incomingCount; ++k)
+                                        {
+                                                bool enters = std::find(entering.begin(), entering.end(), phi->incoming[k].block) != entering.end();
+                                                (enters ? outside : inside).push_back(phi->incoming[k]);
+                                        }
+                                        Value merged = outside.front().value;
+                                        if (entering.size() > 1)
+                                        {
+                                                Instruction *join = arena.make<Instruction>(Opcode::PHI);
+                                                join->type = phi->type;
+                                                join->result = Value::temp(function.tempCount++);
+                                                join->incoming = static_cast<Incoming *>(
+                                                    arena.allocate(sizeof(Incoming) * outside.size(), alignof(Incoming)));
+                                                std::copy(outside.begin(), outside.end(), join->incoming);
+                                                join->incomingCount = static_cast<int>(outside.size());
+                                                insertBefore(preheader, preheader->first, join);
+                                                merged = join->result;
+                                        }
+                                        inside.push_back(Incoming{merged, preheader});
+                                        phi->incoming = static_cast<Incoming *>(
+                                            arena.allocate(sizeof(Incoming) * inside.size(), alignof(Incoming)));
+                                        std::copy(inside.begin(), inside.end(), phi->incoming);
+                                        phi->incomingCount = static_cast<int>(inside.size());
+                                }
+
+                                for (Block *block : entering)
+                                {
+                                        retarget(block, header, preheader);
+                                        preheader->predecessors.push_back(block);
+                                        // The entry block needs a name once a phi refers to it
+                                        if (block->label < 0 && entering.size() > 1)
+                                        {
+                                                block->label = function.labelCount++;
+                                        }
+                                }
+                                auto &predecessors = header->predecessors;
+                                predecessors.erase(std::remove_if(predecessors.begin(), predecessors.end(),
+                                                                  [&](Block *block) { return !loop.contains(block); }),
+                                                   predecessors.end());
+                                predecessors.push_back(preheader);
+                                function.blocks.insert(std::find(function.blocks.begin(), function.blocks.end(), header),
+                                                       preheader);
+                                ++counts.preheaders;
+                                return true;
+                        }
+
+                        // Splits the edges out of the loop into blocks entered from
+                        // outside it too, so code can run on leaving the loop only
+                        bool dedicateExits(const Loop &loop)
+                        {
+                                for (Block *block : loop.blocks)
+                                {
+                                        for (Block *exit : block->successors)
+                                        {
+                                                if (loop.contains(exit) || isTrap(exit) ||
+                                                    std::all_of(exit->predecessors.begin(), exit->predecessors.end(),
+                                                                [&](const Block *b) { return loop.contains(b); }))
+                                                {
+                                                        continue;
+                                                }
+                                                Block *edge = newBlock(exit);
+                                                retarget(block, exit, edge);
+                                                edge->predecessors.push_back(block);
+                                                std::replace(exit->predecessors.begin(), exit->predecessors.end(), block, edge);
+                                                renameIncoming(exit, block, edge);
+                                                function.blocks.insert(std::find(function.blocks.begin(), function.blocks.end(), exit),
+                                                                       edge);
+                                                return true;
+                                        }
+                                }
+                                return false;
+                        }
+
+                        void findDefinitions()
+                        {
+                                definition.assign(function.tempCount, nullptr);
+                                definedIn.assign(function.tempCount, nullptr);
+                                guards.assign(function.tempCount, false);
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                define(i, block);
+                                                if (i->op == Opcode::COND_BR && i->lhs.kind == Value::Kind::TEMP &&
+                                                    (isTrap(i->target) || isTrap(i->otherwise)))
+                                                {
+                                                        guards[i->lhs.id] = true;
+                                                }
+                                        }
+                                }
+                        }
+
+                        void define(Instruction *instruction, Block *block)
+                        {
+                                if (instruction->result.kind == Value::Kind::TEMP)
+                                {
+                                        definition[instruction->result.id] = instruction;
+                                        definedIn[instruction->result.id] = block;
+                                }
+                        }
+
+                        Instruction *add(Block *block, Instruction *position, Opcode op, Type type)
+                        {
+                                Instruction *instruction = function.storage().make<Instruction>(op);
+                                instruction->type = type;
+                                if (op == Opcode::LOAD || op == Opcode::ALLOCA)
+                                {
+                                        instruction->result = Value::temp(function.tempCount++);
+                                        definition.push_back(instruction);
+                                        definedIn.push_back(block);
+                                        guards.push_back(false);
+                                }
+                                insertBefore(block, position, instruction);
+                                return instruction;
+                        }
+
+                        // The alloca a pointer points into, nullptr if it is not one
+                        Instruction *rootOf(Value pointer) const
+                        {
+                                while (pointer.kind == Value::Kind::TEMP && definition[pointer.id])
+                                {
+                                        Instruction *defining = definition[pointer.id];
+                                        if (defining->op == Opcode::ALLOCA)
+                                        {
+                                                return defining;
+                                        }
+                                        if (defining->op != Opcode::GEP && defining->op != Opcode::BITCAST)
+                                        {
+                                                return nullptr;
+                                        }
+                                        pointer = defining->lhs;
+                                }
+                                return nullptr;
+                        }
+
+                        // The element of its alloca a pointer addresses when that is a
+                        // constant in bounds, -1 otherwise. A scalar slot is element 0
+                        int elementOf(Value pointer) const
+                        {
+                                Instruction *root = rootOf(pointer);
+                                if (!root)
+                                {
+                                        return -1;
+                                }
+                                const Instruction *defining = definition[pointer.id];
+                                if (defining->op == Opcode::GEP)
+                                {
+                                        int index = defining->rhs.id;
+                                        bool direct = rootOf(defining->lhs) == root && definition[defining->lhs.id]->op != Opcode::GEP;
+                                        return direct && defining->rhs.kind == Value::Kind::CONSTANT && index >= 0 &&
+                                                       index < std::max(root->count, 1)
+                                                   ? index
+                                                   : -1;
+                                }
+                                return root->count < 0 ? 0 : -1;
+                        }
+
+                        // Allocas the loop may write: stored to, or handed to a call
+                        // such as memset or a lifetime marker
+                        std::vector<const Instruction *> written(const Loop &loop) const
+                        {
+                                std::vector<const Instruction *> roots;
+                                for (Block *block : loop.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                if (i->op == Opcode::STORE)
+                                                {
+                                                        roots.push_back(rootOf(i->rhs));
+                                                }
+                                                for (int k = 0; k < i->argumentCount; ++k)
+                                                {
+                                                        if (Instruction *root = rootOf(i->arguments[k].value))
+                                                        {
+                                                                roots.push_back(root);
+                                                        }
+                                                }
+                                        }
+                                }
+                                return roots;
+                        }
+
+                        bool invariant(const Loop &loop, const Value &value) const
+                        {
+                                return value.kind != Value::Kind::TEMP || !definedIn[value.id] ||
+                                       !loop.contains(definedIn[value.id]);
+                        }
+
+                        // Whether the instruction gives the same value on every
+                        // iteration and may run where the loop would not
+                        bool hoistable(const Loop &loop, Instruction *instruction,
+                                       const std::vector<const Instruction *> &writes) const
+                        {
+                                switch (instruction->op)
+                                {
+                                case Opcode::ADD:
+                                case Opcode::SUB:
+                                case Opcode::MUL:
+                                case Opcode::AND:
+                                case Opcode::OR:
+                                case Opcode::XOR:
+                                case Opcode::SHL:
+                                case Opcode::LSHR:
+                                case Opcode::ASHR:
+                                case Opcode::ZEXT:
+                                case Opcode::SEXT:
+                                case Opcode::TRUNC:
+                                case Opcode::BITCAST:
+                                case Opcode::GEP:
+                                        break;
+                                case Opcode::ICMP:
+                                        if (guards[instruction->result.id])
+                                        {
+                                                return false;
+                                        }
+                                        break;
+                                case Opcode::SDIV:
+                                {
+                                        // Neither by zero nor the one overflowing quotient
+                                        int divisor = instruction->rhs.id;
+                                        int minusOne = instruction->type == Type::I8 ? 255 : -1;
+                                        if (instruction->rhs.kind != Value::Kind::CONSTANT || divisor == 0 ||
+                                            divisor == -1 || divisor == minusOne)
+                                        {
+                                                return false;
+                                        }
+                                        break;
+                                }
+                                case Opcode::LOAD:
+                                {
+                                        const Instruction *root = rootOf(instruction->lhs);
+                                        if (!root || elementOf(instruction->lhs) < 0 ||
+                                            std::find(writes.begin(), writes.end(), nullptr) != writes.end() ||
+                                            std::find(writes.begin(), writes.end(), root) != writes.end())
+                                        {
+                                                return false;
+                                        }
+                                        break;
+                                }
+                                default:
+                                        return false;
+                                }
+                                bool operands = true;
+                                instruction->forEachOperand([&](Value &value) { operands = operands && invariant(loop, value); });
+                                return operands;
+                        }
+
+                        void hoist(const Loop &loop)
+                        {
+                                std::vector<const Instruction *> writes = written(loop);
+                                Block *preheader = loop.preheader;
+                                for (Block *block : loop.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr;)
+                                        {
+                                                Instruction *next = i->next;
+                                                if (hoistable(loop, i, writes))
+                                                {
+                                                        unlink(block, i);
+                                                        insertBefore(preheader, preheader->last, i);
+                                                        definedIn[i->result.id] = preheader;
+                                                        ++counts.hoisted;
+                                                }
+                                                i = next;
+                                        }
+                                }
+                        }
+
+                        // Keeps each array element with a constant index the loop
+                        // stores to in a slot of its own, which promoteLocals turns into
+                        // a register. Only arrays the loop reaches through such
+                        // elements alone qualify
+                        bool promote(const Loop &loop)
+                        {
+                                // By alloca, the loads and stores of its elements in the loop
+                                std::vector<Instruction *> roots;
+                                std::vector<std::vector<Instruction *>> accesses;
+                                std::vector<bool> excluded;
+                                auto indexOf = [&](Instruction *root) {
+                                        auto found = std::find(roots.begin(), roots.end(), root);
+                                        if (found != roots.end())
+                                        {
+                                                return static_cast<size_t>(found - roots.begin());
+                                        }
+                                        roots.push_back(root);
+                                        accesses.emplace_back();
+                                        excluded.push_back(false);
+                                        return roots.size() - 1;
+                                };
+                                for (Block *block : loop.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                Value *pointer = i->op == Opcode::LOAD    ? &i->lhs
+                                                                 : i->op == Opcode::STORE ? &i->rhs
+                                                                                          : nullptr;
+                                                if (pointer)
+                                                {
+                                                        if (Instruction *root = rootOf(*pointer))
+                                                        {
+                                                                size_t r = indexOf(root);
+                                                                accesses[r].push_back(i);
+                                                                excluded[r] = excluded[r] || root->count < 0 ||
+                                                                              elementOf(*pointer) < 0 ||
+                                                                              !invariant(loop, *pointer);
+                                                        }
+                                                }
+                                                for (int k = 0; k < i->argumentCount; ++k)
+                                                {
+                                                        if (Instruction *root = rootOf(i->arguments[k].value))
+                                                        {
+                                                                excluded[indexOf(root)] = true;
+                                                        }
+                                                }
+                                        }
+                                }
+
+                                std::vector<Block *> exits;
+                                for (Block *block : loop.blocks)
+                                {
+                                        for (Block *exit : block->successors)
+                                        {
+                                                if (!loop.contains(exit) && !isTrap(exit) &&
+                                                    std::find(exits.begin(), exits.end(), exit) == exits.end())
+                                                {
+                                                        exits.push_back(exit);
+                                                }
+                                        }
+                                }
+
+                                bool changed = false;
+                                for (size_t r = 0; r < roots.size(); ++r)
+                                {
+                                        if (excluded[r])
+                                        {
+                                                continue;
+                                        }
+                                        // Elements the loop stores to, with the type it accesses them as
+                                        std::vector<int> elements;
+                                        for (Instruction *i : accesses[r])
+                                        {
+                                                int element = elementOf(i->op == Opcode::LOAD ? i->lhs : i->rhs);
+                                                if (i->op == Opcode::STORE &&
+                                                    std::find(elements.begin(), elements.end(), element) == elements.end())
+                                                {
+                                                        elements.push_back(element);
+                                                }
+                                        }
+                                        for (int element : elements)
+                                        {
+                                                changed = promote(loop, roots[r], accesses[r], element, exits) || changed;
+                                        }
+                                }
+                                return changed;
+                        }
+
+                        bool promote(const Loop &loop, const Instruction *root, const std::vector<Instruction *> &accesses,
+                                     int element, const std::vector<Block *> &exits)
+                        {
+                                // Accesses of elements promoted before now go to their slots
+                                std::vector<Instruction *> uses;
+                                for (Instruction *i : accesses)
+                                {
+                                        Value pointer = i->op == Opcode::LOAD ? i->lhs : i->rhs;
+                                        if (rootOf(pointer) != root || elementOf(pointer) != element)
+                                        {
+                                                continue;
+                                        }
+                                        if (!uses.empty() && uses.front()->type != i->type)
+                                        {
+                                                return false;
+                                        }
+                                        uses.push_back(i);
+                                }
+                                Type type = uses.front()->type;
+                                Value pointer = uses.front()->op == Opcode::LOAD ? uses.front()->lhs : uses.front()->rhs;
+
+                                Block *entry = function.blocks.front();
+                                Instruction *slot = add(entry, entry->first, Opcode::ALLOCA, type);
+                                Block *preheader = loop.preheader;
+                                Instruction *initial = add(preheader, preheader->last, Opcode::LOAD, type);
+                                initial->lhs = pointer;
+                                Instruction *keep = add(preheader, preheader->last, Opcode::STORE, type);
+                                keep->lhs = initial->result;
+                                keep->rhs = slot->result;
+
+                                for (Instruction *i : uses)
+                                {
+                                        (i->op == Opcode::LOAD ? i->lhs : i->rhs) = slot->result;
+                                }
+
+                                // Back in memory on the way out, after the phis of the exit
+                                for (Block *exit : exits)
+                                {
+                                        Instruction *position = exit->first;
+                                        while (position->op == Opcode::PHI)
+                                        {
+                                                position = position->next;
+                                        }
+                                        Instruction *last = add(exit, position, Opcode::LOAD, type);
+                                        last->lhs = slot->result;
+                                        Instruction *store = add(exit, position, Opcode::STORE, type);
+                                        store->lhs = last->result;
+                                        store->rhs = pointer;
+                                }
+                                ++counts.promoted;
+                                return true;
+                        }
+
+                public:
+                        LoopInvariantMotion(Function &function, bool promoteElements)
+                            : function(function), promoteElements(promoteElements) {}
+
+                        LoopInvariantCounts run()
+                        {
+                                removeUnreachableBlocks(function);
+
+                                // Every change to the CFG renumbers the blocks and may
+                                // nest the new block in an enclosing loop
+                                for (bool changed = true; changed;)
+                                {
+                                        changed = false;
+                                        DominatorTree tree(function);
+                                        for (const Loop &loop : findLoops(tree))
+                                        {
+                                                if (addPreheader(loop) || dedicateExits(loop))
+                                                {
+                                                        changed = true;
+                                                        break;
+                                                }
+                                        }
+                                }
+
+                                DominatorTree tree(function);
+                                std::vector<Loop> loops = findLoops(tree);
+                                if (loops.empty())
+                                {
+                                        return counts;
+                                }
+                                findDefinitions();
+                                for (const Loop &loop : loops)
+                                {
+                                        if (!loop.preheader)
+                                        {
+                                                continue;
+                                        }
+                                        hoist(loop);
+                                        // Loads of the other elements may be invariant now
+                                        if (promoteElements && promote(loop))
+                                        {
+                                                hoist(loop);
+                                        }
+                                }
+                                if (counts.promoted > 0)
+                                {
+                                        promoteLocals(function);
+                                }
+                                return counts;
+                        }
+                };
+
+        }
+
+        LoopInvariantCounts hoistLoopInvariants(Function &function, bool promoteElements)
+        {
+                return LoopInvariantMotion(function, promoteElements).run();
+        }
+
+}
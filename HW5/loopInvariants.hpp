@@ -0,0 +1,30 @@
+#ifndef LOOP_INVARIANTS_HPP
+#define LOOP_INVARIANTS_HPP
+
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // What loop invariant code motion did to one function
+    struct LoopInvariantCounts
+    {
+        int hoisted = 0;
+        int promoted = 0;
+        int preheaders = 0;
+    };
+
+    // Gives every natural loop a preheader and exit blocks of its own, then
+    // moves the computations whose operands do not change in the loop to the
+    // preheader, innermost loops first. Arithmetic and casts always move; a
+    // division only by a constant that cannot trap, a load only from an
+    // element known to be in bounds and not written in the loop. Compares of
+    // bounds checks stay, eliminateBoundsChecks hoists whole checks. With
+    // promoteElements, an array element with a constant index that the loop
+    // stores to lives in a register instead: loaded in the preheader and
+    // stored back on the way out
+    LoopInvariantCounts hoistLoopInvariants(Function &function, bool promoteElements);
+
+}
+
+#endif // LOOP_INVARIANTS_HPP
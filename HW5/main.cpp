@@ -1,19 +1,148 @@
-#include "output.hpp"
-#include "nodes.hpp"
-#include "analyzer.hpp"
+#include "compilation.hpp"
+#include "batch.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unistd.h>
 
-// Extern from the bison-generated parser
-extern int yyparse();
+int main(int argc, char *argv[])
+{
+    bool stats = false;
+    bool inlineReport = false;
+    bool cseReport = false;
+    const char *batchList = nullptr;
+    std::size_t jobs = 0;
+    CompileOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--stats") == 0)
+        {
+            stats = true;
+        }
+        else if (std::strcmp(argv[i], "--parse-only") == 0)
+        {
+            options.parseOnly = true;
+        }
+        else if (std::strcmp(argv[i], "--no-ssa") == 0)
+        {
+            options.passes.promoteLocals = false;
+        }
+        else if (std::strcmp(argv[i], "--no-bce") == 0)
+        {
+            options.passes.eliminateBoundsChecks = false;
+        }
+        else if (std::strcmp(argv[i], "--no-licm") == 0)
+        {
+            options.passes.hoistLoopInvariants = false;
+        }
+        else if (std::strcmp(argv[i], "--no-cse") == 0)
+        {
+            options.passes.numberValues = false;
+        }
+        else if (std::strcmp(argv[i], "--no-arith") == 0)
+        {
+            options.passes.simplifyArithmetic = false;
+        }
+        else if (std::strcmp(argv[i], "--no-simplify") == 0)
+        {
+            options.passes.simplifyControlFlow = false;
+        }
+        else if (std::strcmp(argv[i], "--no-fold") == 0)
+        {
+            options.foldConstants = false;
+        }
+        else if (std::strcmp(argv[i], "--no-tail-calls") == 0)
+        {
+            options.passes.eliminateTailCalls = false;
+        }
+        else if (std::strcmp(argv[i], "--no-inline") == 0)
+        {
+            options.passes.inlineThreshold = 0;
+        }
+        else if (std::strcmp(argv[i], "--inline-threshold") == 0 && i + 1 < argc)
+        {
+            options.passes.inlineThreshold = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--asm") == 0)
+        {
+            options.assembly = true;
+        }
+        else if (std::strcmp(argv[i], "--inline-report") == 0)
+        {
+            inlineReport = true;
+        }
+        else if (std::strcmp(argv[i], "--cse-report") == 0)
+        {
+            cseReport = true;
+        }
+        else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            batchList = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            jobs = std::strtoul(argv[++i], nullptr, 10);
+        }
+    }
 
-extern std::shared_ptr<ast::Node> program;
+    // hw5 --batch list.txt [-j N]: one .ll per listed file, see batch.hpp.
+    // Otherwise -j N spreads the functions of the one program over N threads
+    if (batchList != nullptr)
+    {
+        return runBatch(batchList, jobs != 0 ? jobs : std::thread::hardware_concurrency(), options);
+    }
+    options.jobs = jobs != 0 ? jobs : 1;
 
-int main()
-{
-    // Parse the input. The result is stored in the global variable `program`
-    yyparse();
+    // The whole program is read up front, each compilation scans its own copy
+    std::string source((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+
+    // Either the generated code or the diagnostic, both go to stdout
+    CompileResult result = compile(source, options);
+    bool written = result.output.writeTo(STDOUT_FILENO);
 
-    // Print the AST using the PrintVisitor
-    Analyzer analyzer;
-    program->accept(analyzer);
-    analyzer.printOutput();
+    // Statistics go to stderr so they never mix with the generated code
+    if (stats)
+    {
+        std::cerr << "arena: " << result.arenaNodes << " nodes, "
+                  << result.arenaBytesUsed << " bytes used, "
+                  << result.arenaBytesReserved << " bytes reserved" << std::endl;
+        std::cerr << "frames: " << result.frameBytes << " bytes of arrays, "
+                  << result.unsharedFrameBytes << " without slot sharing" << std::endl;
+        std::cerr << "bounds checks: " << result.passStats.boundsChecksRemoved << " of "
+                  << result.passStats.boundsChecks << " removed, "
+                  << result.passStats.boundsChecksHoisted << " hoisted out of loops" << std::endl;
+        std::cerr << "loop invariants: " << result.passStats.loopInvariantsHoisted << " instructions hoisted, "
+                  << result.passStats.elementsPromoted << " array elements kept in registers, "
+                  << result.passStats.preheadersAdded << " preheaders added" << std::endl;
+        std::cerr << "value numbering: " << result.passStats.expressionsEliminated << " expressions and "
+                  << result.passStats.loadsEliminated << " loads eliminated, "
+                  << result.passStats.branchesFolded << " decided branches folded" << std::endl;
+        std::cerr << "arithmetic: " << result.passStats.arithmeticSimplified << " instructions simplified, "
+                  << result.passStats.strengthReduced << " strength reduced, "
+                  << result.passStats.deadInstructionsRemoved << " dead instructions removed" << std::endl;
+        std::cerr << "control flow: " << result.passStats.blocksRemoved << " blocks removed" << std::endl;
+        std::cerr << "constants: " << result.foldedExpressions << " expressions folded, "
+                  << result.propagatedConstants << " uses of constant locals replaced" << std::endl;
+        std::cerr << "tail calls: " << result.passStats.tailCallsEliminated << " turned into loops, "
+                  << result.passStats.tailCallsMarked << " marked" << std::endl;
+        std::cerr << "inlining: " << result.passStats.callsInlined << " calls inlined" << std::endl;
+    }
+    if (inlineReport)
+    {
+        for (const std::string &line : result.inlineReport)
+        {
+            std::cerr << line << std::endl;
+        }
+    }
+    if (cseReport)
+    {
+        for (const std::string &line : result.passStats.valueNumberingReport)
+        {
+            std::cerr << line << std::endl;
+        }
+    }
+    return written ? 0 : 1;
 }
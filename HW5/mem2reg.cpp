@@ -0,0 +1,429 @@
+#include "mem2reg.hpp"
+#include "cfg.hpp"
+#include <utility>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                /* Promotion class
+                 * State of one promotion: the candidate variables, the phis placed for
+                 * them and the value each removed load was replaced by.
+                 */
+                class Promotion
+                {
+                private:
+                        Function &function;
+                        // Variable number of each temporary that is a promotable alloca, else -1
+                        std::vector<int> variableOf;
+                        std::vector<Type> types;
+                        // Value a removed load or phi stands for, indexed by temporary
+                        std::vector<Value> replacement;
+                        // Phis of each block, by reverse postorder position, with their variable
+                        std::vector<std::vector<std::pair<Instruction *, int>>> phis;
+
+                        int variableOfPointer(Value pointer) const
+                        {
+                                if (pointer.kind != Value::Kind::TEMP || pointer.id >= static_cast<int>(variableOf.size()))
+                                {
+                                        return -1;
+                                }
+                                return variableOf[pointer.id];
+                        }
+
+                        Value resolve(Value value) const
+                        {
+                                while (value.kind == Value::Kind::TEMP && value.id < static_cast<int>(replacement.size()) &&
+                                       !replacement[value.id].isNone())
+                                {
+                                        value = replacement[value.id];
+                                }
+                                return value;
+                        }
+
+                        // Value of a variable read before any store, which FanC never does
+                        static Value undefined(Type type)
+                        {
+                                return type == Type::I8_PTR ? Value::null() : Value::constant(0);
+                        }
+
+                        void findVariables()
+                        {
+                                variableOf.assign(function.tempCount, -1);
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                if (i->op == Opcode::ALLOCA && i->count < 0 && i->result.kind == Value::Kind::TEMP)
+                                                {
+                                                        variableOf[i->result.id] = static_cast<int>(types.size());
+                                                        types.push_back(i->type);
+                                                }
+                                        }
+                                }
+
+                                // A slot whose address is used other than by a load or a store stays in memory
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                Value *pointer = i->op == Opcode::LOAD    ? &i->lhs
+                                                                 : i->op == Opcode::STORE ? &i->rhs
+                                                                                          : nullptr;
+                                                i->forEachOperand([&](Value &operand) {
+                                                        if (&operand != pointer && variableOfPointer(operand) >= 0)
+                                                        {
+                                                                variableOf[operand.id] = -1;
+                                                        }
+                                                });
+                                        }
+                                }
+                        }
+
+                        void placePhis(const DominatorTree &tree)
+                        {
+                                const std::vector<Block *> &order = tree.order();
+                                size_t count = order.size();
+                                size_t variables = types.size();
+
+                                // Blocks that store each variable, and blocks that read it before storing it
+                                std::vector<std::vector<Block *>> definitions(variables);
+                                std::vector<std::vector<Block *>> upwardUses(variables);
+                                std::vector<int> seenIn(variables, -1);
+                                std::vector<int> definedIn(variables, -1);
+                                for (Block *block : order)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                bool load = i->op == Opcode::LOAD;
+                                                if (!load && i->op != Opcode::STORE)
+                                                {
+                                                        continue;
+                                                }
+                                                int variable = variableOfPointer(load ? i->lhs : i->rhs);
+                                                if (variable < 0)
+                                                {
+                                                        continue;
+                                                }
+                                                if (seenIn[variable] != block->index)
+                                                {
+                                                        seenIn[variable] = block->index;
+                                                        if (load)
+                                                        {
+                                                                upwardUses[variable].push_back(block);
+                                                        }
+                                                }
+                                                if (!load && definedIn[variable] != block->index)
+                                                {
+                                                        definedIn[variable] = block->index;
+                                                        definitions[variable].push_back(block);
+                                                }
+                                        }
+                                }
+
+                                phis.assign(count, {});
+                                // Per block marks, stamped with the variable being processed
+                                std::vector<int> defines(count, -1);
+                                std::vector<int> live(count, -1);
+                                std::vector<int> hasPhi(count, -1);
+                                std::vector<Block *> worklist;
+                                for (size_t v = 0; v < variables; ++v)
+                                {
+                                        int variable = static_cast<int>(v);
+                                        if (definitions[v].empty() && upwardUses[v].empty())
+                                        {
+                                                continue;
+                                        }
+                                        for (Block *block : definitions[v])
+                                        {
+                                                defines[block->index] = variable;
+                                        }
+
+                                        // Live-in blocks: upward uses, then backwards up to the stores
+                                        worklist = upwardUses[v];
+                                        for (Block *block : worklist)
+                                        {
+                                                live[block->index] = variable;
+                                        }
+                                        while (!worklist.empty())
+                                        {
+                                                Block *block = worklist.back();
+                                                worklist.pop_back();
+                                                for (Block *predecessor : block->predecessors)
+                                                {
+                                                        int p = predecessor->index;
+                                                        if (defines[p] != variable && live[p] != variable)
+                                                        {
+                                                                live[p] = variable;
+                                                                worklist.push_back(predecessor);
+                                                        }
+                                                }
+                                        }
+
+                                        // Iterated dominance frontier of the stores, limited to live-in blocks
+                                        worklist = definitions[v];
+                                        while (!worklist.empty())
+                                        {
+                                                Block *block = worklist.back();
+                                                worklist.pop_back();
+                                                for (Block *join : tree.frontier(block))
+                                                {
+                                                        int j = join->index;
+                                                        if (hasPhi[j] == variable || live[j] != variable)
+                                                        {
+                                                                continue;
+                                                        }
+                                                        hasPhi[j] = variable;
+                                                        phis[j].push_back({insertPhi(join, types[v]), variable});
+                                                        if (defines[j] != variable)
+                                                        {
+                                                                worklist.push_back(join);
+                                                        }
+                                                }
+                                        }
+                                }
+                        }
+
+                        Instruction *insertPhi(Block *block, Type type)
+                        {
+                                ast::Arena &arena = function.storage();
+                                Instruction *phi = arena.make<Instruction>(Opcode::PHI);
+                                phi->type = type;
+                                phi->result = Value::temp(function.tempCount++);
+                                phi->incomingCount = static_cast<int>(block->predecessors.size());
+                                phi->incoming = static_cast<Incoming *>(
+                                    arena.allocate(sizeof(Incoming) * block->predecessors.size(), alignof(Incoming)));
+                                for (size_t i = 0; i < block->predecessors.size(); ++i)
+                                {
+                                        Block *predecessor = block->predecessors[i];
+                                        // The entry block needs a name once a phi refers to it
+                                        if (predecessor->label < 0)
+                                        {
+                                                predecessor->label = function.labelCount++;
+                                        }
+                                        phi->incoming[i] = Incoming{Value(), predecessor};
+                                }
+                                phi->next = block->first;
+                                block->first = phi;
+                                if (!block->last)
+                                {
+                                        block->last = phi;
+                                }
+                                return phi;
+                        }
+
+                        // Replaces loads and stores of the block by the current values, and fills
+                        // in the phis of its successors
+                        void renameBlock(Block *block, std::vector<Value> &current,
+                                         std::vector<std::pair<int, Value>> &undo)
+                        {
+                                for (auto &phi : phis[block->index])
+                                {
+                                        undo.push_back({phi.second, current[phi.second]});
+                                        current[phi.second] = phi.first->result;
+                                }
+
+                                Instruction *previous = nullptr;
+                                for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                {
+                                        bool removed = false;
+                                        if (i->op == Opcode::ALLOCA)
+                                        {
+                                                removed = variableOfPointer(i->result) >= 0;
+                                        }
+                                        else if (i->op == Opcode::LOAD)
+                                        {
+                                                int variable = variableOfPointer(i->lhs);
+                                                if (variable >= 0)
+                                                {
+                                                        replacement[i->result.id] = current[variable];
+                                                        removed = true;
+                                                }
+                                        }
+                                        else if (i->op == Opcode::STORE)
+                                        {
+                                                int variable = variableOfPointer(i->rhs);
+                                                if (variable >= 0)
+                                                {
+                                                        undo.push_back({variable, current[variable]});
+                                                        current[variable] = resolve(i->lhs);
+                                                        removed = true;
+                                                }
+                                        }
+                                        if (!removed)
+                                        {
+                                                previous = i;
+                                                continue;
+                                        }
+                                        if (previous)
+                                        {
+                                                previous->next = i->next;
+                                        }
+                                        else
+                                        {
+                                                block->first = i->next;
+                                        }
+                                        if (block->last == i)
+                                        {
+                                                block->last = previous;
+                                        }
+                                }
+
+                                for (Block *successor : block->successors)
+                                {
+                                        for (auto &phi : phis[successor->index])
+                                        {
+                                                for (int k = 0; k < phi.first->incomingCount; ++k)
+                                                {
+                                                        if (phi.first->incoming[k].block == block)
+                                                        {
+                                                                phi.first->incoming[k].value = current[phi.second];
+                                                        }
+                                                }
+                                        }
+                                }
+                        }
+
+                        void rename(const DominatorTree &tree)
+                        {
+                                std::vector<Value> current;
+                                for (Type type : types)
+                                {
+                                        current.push_back(undefined(type));
+                                }
+                                replacement.assign(function.tempCount, Value());
+
+                                // Preorder walk of the dominator tree; undo restores the values on the way up
+                                std::vector<std::pair<int, Value>> undo;
+                                struct Frame
+                                {
+                                        Block *block;
+                                        size_t child;
+                                        size_t undoMark;
+                                };
+                                std::vector<Frame> stack;
+                                Block *entry = tree.order().front();
+                                stack.push_back({entry, 0, undo.size()});
+                                renameBlock(entry, current, undo);
+                                while (!stack.empty())
+                                {
+                                        Frame &top = stack.back();
+                                        const std::vector<Block *> &children = tree.children(top.block);
+                                        if (top.child < children.size())
+                                        {
+                                                Block *child = children[top.child++];
+                                                stack.push_back({child, 0, undo.size()});
+                                                renameBlock(child, current, undo);
+                                                continue;
+                                        }
+                                        while (undo.size() > top.undoMark)
+                                        {
+                                                current[undo.back().first] = undo.back().second;
+                                                undo.pop_back();
+                                        }
+                                        stack.pop_back();
+                                }
+                        }
+
+                        // Drops phis whose incoming values are all the same, or the phi itself
+                        void removeTrivialPhis()
+                        {
+                                bool changed = true;
+                                while (changed)
+                                {
+                                        changed = false;
+                                        for (auto &blockPhis : phis)
+                                        {
+                                                for (auto &phi : blockPhis)
+                                                {
+                                                        Instruction *instruction = phi.first;
+                                                        if (!replacement[instruction->result.id].isNone())
+                                                        {
+                                                                continue;
+                                                        }
+                                                        Value same;
+                                                        bool trivial = true;
+                                                        for (int k = 0; k < instruction->incomingCount && trivial; ++k)
+                                                        {
+                                                                Value value = resolve(instruction->incoming[k].value);
+                                                                if (value == instruction->result || value == same)
+                                                                {
+                                                                        continue;
+                                                                }
+                                                                trivial = same.isNone();
+                                                                same = value;
+                                                        }
+                                                        if (trivial && !same.isNone())
+                                                        {
+                                                                replacement[instruction->result.id] = same;
+                                                                changed = true;
+                                                        }
+                                                }
+                                        }
+                                }
+
+                                for (Block *block : function.blocks)
+                                {
+                                        while (block->first && block->first->op == Opcode::PHI &&
+                                               !replacement[block->first->result.id].isNone())
+                                        {
+                                                block->first = block->first->next;
+                                        }
+                                        for (Instruction *i = block->first;
+                                             i != nullptr && i->next != nullptr && i->next->op == Opcode::PHI;)
+                                        {
+                                                if (!replacement[i->next->result.id].isNone())
+                                                {
+                                                        i->next = i->next->next;
+                                                }
+                                                else
+                                                {
+                                                        i = i->next;
+                                                }
+                                        }
+                                }
+                        }
+
+                public:
+                        explicit Promotion(Function &function) : function(function) {}
+
+                        int run()
+                        {
+                                removeUnreachableBlocks(function);
+                                findVariables();
+                                int promoted = 0;
+                                for (int variable : variableOf)
+                                {
+                                        promoted += variable >= 0;
+                                }
+                                if (promoted == 0)
+                                {
+                                        return 0;
+                                }
+
+                                DominatorTree tree(function);
+                                placePhis(tree);
+                                rename(tree);
+                                removeTrivialPhis();
+
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                i->forEachOperand([&](Value &operand) { operand = resolve(operand); });
+                                        }
+                                }
+                                return promoted;
+                        }
+                };
+
+        }
+
+        int promoteLocals(Function &function)
+        {
+                return Promotion(function).run();
+        }
+
+}
@@ -0,0 +1,16 @@
+#ifndef MEM2REG_HPP
+#define MEM2REG_HPP
+
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // Promotes every scalar alloca that is only loaded and stored to SSA values,
+    // placing phis only where the variable is live (pruned SSA). Unreachable
+    // blocks are removed first. Returns the number of allocas promoted
+    int promoteLocals(Function &function);
+
+}
+
+#endif // MEM2REG_HPP
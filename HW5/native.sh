@@ -0,0 +1,89 @@
+#!/bin/bash
+
+# Usage: ./native.sh [test directory] [hw5 flags...]
+# Builds every test program twice: with --asm, assembled and linked by as and
+# ld alone, and through LLVM IR, llc -O0 and gcc. Checks that both binaries
+# print the same, then compares how long each build took and how long each
+# binary runs (best of three runs).
+# The test directory defaults to benchmarks; extra flags go to both builds.
+
+# Compile the project
+make > /dev/null 2>&1
+
+# Exit if compilation fails
+if [ $? -ne 0 ]; then
+    echo "❌ Compilation failed."
+    exit 1
+fi
+
+BUILD_DIR=$(mktemp -d)
+trap 'rm -rf "$BUILD_DIR"; make clean > /dev/null' EXIT
+
+TEST_DIR=${1:-benchmarks}
+[ $# -gt 0 ] && shift
+FLAGS=("$@")
+
+now() {
+    date +%s%N
+}
+
+# Milliseconds between two readings of now
+elapsed() {
+    awk -v a="$1" -v b="$2" 'BEGIN { printf "%.2f", (b - a) / 1000000 }'
+}
+
+# Best of three runs of a binary, in milliseconds; its output goes to $2
+best_run() {
+    local best="" start stop time
+    for _ in 1 2 3; do
+        start=$(now)
+        timeout 20 "$1" < /dev/null > "$2" 2>&1
+        stop=$(now)
+        time=$(elapsed "$start" "$stop")
+        best=$(awk -v a="$time" -v b="$best" 'BEGIN { print (b == "" || a < b) ? a : b }')
+    done
+    echo "$best"
+}
+
+ratio() {
+    awk -v a="$1" -v b="$2" 'BEGIN { if (b > 0) printf "%.3f", a / b; else print "-" }'
+}
+
+TOTALS=(0 0 0 0)
+printf "%-24s %10s %10s %8s %10s %10s %8s\n" "test" "as+ld ms" "llc ms" "ratio" "native ms" "-O0 ms" "ratio"
+for IN_FILE in "$TEST_DIR"/*.in; do
+    NAME=$(basename "$IN_FILE" .in)
+
+    START=$(now)
+    ./hw5 --asm "${FLAGS[@]}" < "$IN_FILE" > "$BUILD_DIR/native.s" &&
+        as -o "$BUILD_DIR/native.o" "$BUILD_DIR/native.s" &&
+        ld -o "$BUILD_DIR/native" "$BUILD_DIR/native.o"
+    NATIVE_BUILT=$?
+    MIDDLE=$(now)
+    ./hw5 "${FLAGS[@]}" < "$IN_FILE" > "$BUILD_DIR/llvm.ll" &&
+        llc -O0 -relocation-model=pic -o "$BUILD_DIR/llvm.s" "$BUILD_DIR/llvm.ll" &&
+        gcc -o "$BUILD_DIR/llvm" "$BUILD_DIR/llvm.s"
+    LLVM_BUILT=$?
+    STOP=$(now)
+
+    if [ $NATIVE_BUILT -ne 0 ] || [ $LLVM_BUILT -ne 0 ]; then
+        printf "%-24s %s\n" "$NAME" "❌ build failed"
+        continue
+    fi
+    NATIVE_BUILD=$(elapsed "$START" "$MIDDLE")
+    LLVM_BUILD=$(elapsed "$MIDDLE" "$STOP")
+    NATIVE_RUN=$(best_run "$BUILD_DIR/native" "$BUILD_DIR/native.stdout")
+    LLVM_RUN=$(best_run "$BUILD_DIR/llvm" "$BUILD_DIR/llvm.stdout")
+
+    # Both binaries must behave the same before their times mean anything
+    if ! cmp -s "$BUILD_DIR/native.stdout" "$BUILD_DIR/llvm.stdout"; then
+        printf "%-24s %s\n" "$NAME" "❌ output differs"
+        continue
+    fi
+    TOTALS=($(awk -v t="${TOTALS[*]}" -v a="$NATIVE_BUILD" -v b="$LLVM_BUILD" -v c="$NATIVE_RUN" -v d="$LLVM_RUN" \
+        'BEGIN { split(t, s, " "); print s[1] + a, s[2] + b, s[3] + c, s[4] + d }'))
+    printf "%-24s %10s %10s %8s %10s %10s %8s\n" "$NAME" "$NATIVE_BUILD" "$LLVM_BUILD" \
+        "$(ratio "$NATIVE_BUILD" "$LLVM_BUILD")" "$NATIVE_RUN" "$LLVM_RUN" "$(ratio "$NATIVE_RUN" "$LLVM_RUN")"
+done
+printf "%-24s %10s %10s %8s %10s %10s %8s\n" "total" "${TOTALS[0]}" "${TOTALS[1]}" \
+    "$(ratio "${TOTALS[0]}" "${TOTALS[1]}")" "${TOTALS[2]}" "${TOTALS[3]}" "$(ratio "${TOTALS[2]}" "${TOTALS[3]}")"
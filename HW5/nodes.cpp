@@ -1,13 +1,10 @@
 #include "nodes.hpp"
 #include <string>
-#include <utility>
-
-extern int yylineno;
 
 namespace ast
 {
 
-        Node::Node() : line(yylineno) {}
+        Node::Node() : line(0) {}
 
         Num::Num(const char *str) : Exp(), value(std::stoi(str)) {}
 
@@ -23,104 +20,83 @@ namespace ast
 
         ID::ID(const char *str) : Exp(), value(str) {}
 
-        BinOp::BinOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, BinOpType op)
-            : Exp(), left(std::move(left)), right(std::move(right)), op(op) {}
-
-        RelOp::RelOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, RelOpType op)
-            : Exp(), left(std::move(left)), right(std::move(right)), op(op) {}
+        BinOp::BinOp(Exp *left, Exp *right, BinOpType op)
+            : Exp(), left(left), right(right), op(op) {}
 
-        PrimitiveType::PrimitiveType(BuiltInType type) : Node(), type(type) {}
+        RelOp::RelOp(Exp *left, Exp *right, RelOpType op)
+            : Exp(), left(left), right(right), op(op) {}
 
-        ArrayType::ArrayType(BuiltInType type, std::shared_ptr<Exp> length) : Node(), type(type), length(length) {}
+        PrimitiveType::PrimitiveType(BuiltInType type) : Type(), type(type) {}
 
-        Cast::Cast(std::shared_ptr<Exp> exp, std::shared_ptr<PrimitiveType> target_type)
-            : Exp(), exp(std::move(exp)), target_type(std::move(target_type)) {}
+        ArrayType::ArrayType(BuiltInType type, Exp *length) : Type(), type(type), length(length) {}
 
-        Not::Not(std::shared_ptr<Exp> exp) : Exp(), exp(std::move(exp)) {}
+        Cast::Cast(Exp *exp, PrimitiveType *target_type)
+            : Exp(), exp(exp), target_type(target_type) {}
 
-        And::And(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right)
-            : Exp(), left(std::move(left)), right(std::move(right)) {}
+        Not::Not(Exp *exp) : Exp(), exp(exp) {}
 
-        Or::Or(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right)
-            : Exp(), left(std::move(left)), right(std::move(right)) {}
+        And::And(Exp *left, Exp *right)
+            : Exp(), left(left), right(right) {}
 
-        ExpList::ExpList(std::shared_ptr<Exp> exp) : Node(), exps({std::move(exp)}) {}
+        Or::Or(Exp *left, Exp *right)
+            : Exp(), left(left), right(right) {}
 
-        void ExpList::push_front(const std::shared_ptr<Exp> &exp)
-        {
-                exps.insert(exps.begin(), exp);
-        }
+        ExpList::ExpList(Exp *exp) : Node(), exps({exp}) {}
 
-        void ExpList::push_back(const std::shared_ptr<Exp> &exp)
+        void ExpList::push_back(Exp *exp)
         {
                 exps.push_back(exp);
         }
 
-        Call::Call(std::shared_ptr<ID> func_id, std::shared_ptr<ExpList> args)
-            : Exp(), func_id(std::move(func_id)), args(std::move(args)) {}
+        Call::Call(ID *func_id, ExpList *args)
+            : Exp(), func_id(func_id), args(args) {}
 
-        Call::Call(std::shared_ptr<ID> func_id)
-            : Exp(), func_id(std::move(func_id)), args(std::make_shared<ExpList>()) {}
+        CallStatement::CallStatement(Call *call) : Statement(), call(call) {}
 
-        Statements::Statements(std::shared_ptr<Statement> statement) : Statement(), statements({std::move(statement)}) {}
-
-        void Statements::push_front(const std::shared_ptr<Statement> &statement)
-        {
-                statements.insert(statements.begin(), statement);
-        }
+        Statements::Statements(Statement *statement) : Statement(), statements({statement}) {}
 
-        void Statements::push_back(const std::shared_ptr<Statement> &statement)
+        void Statements::push_back(Statement *statement)
         {
                 statements.push_back(statement);
         }
 
-        Return::Return(std::shared_ptr<Exp> exp) : Statement(), exp(std::move(exp)) {}
+        Return::Return(Exp *exp) : Statement(), exp(exp) {}
 
-        If::If(std::shared_ptr<Exp> condition, std::shared_ptr<Statement> then, std::shared_ptr<Statement> otherwise)
-            : Statement(), condition(std::move(condition)), then(std::move(then)), otherwise(std::move(otherwise)) {}
+        If::If(Exp *condition, Statement *then, Statement *otherwise)
+            : Statement(), condition(condition), then(then), otherwise(otherwise) {}
 
-        While::While(std::shared_ptr<Exp> condition, std::shared_ptr<Statement> body)
-            : Statement(), condition(std::move(condition)),
-              body(std::move(body)) {}
+        While::While(Exp *condition, Statement *body)
+            : Statement(), condition(condition),
+              body(body) {}
 
-        VarDecl::VarDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> type, std::shared_ptr<Exp> init_exp)
-            : Statement(), id(std::move(std::move(id))), type(std::move(type)), init_exp(std::move(init_exp)) {}
+        VarDecl::VarDecl(ID *id, Type *type, Exp *init_exp)
+            : Statement(), id(id), type(type), init_exp(init_exp) {}
 
-        Assign::Assign(std::shared_ptr<ID> id, std::shared_ptr<Exp> exp)
-            : Statement(), id(std::move(id)), exp(std::move(exp)) {}
+        Assign::Assign(ID *id, Exp *exp)
+            : Statement(), id(id), exp(exp) {}
 
-        ArrayAssign::ArrayAssign(std::shared_ptr<ID> id, std::shared_ptr<Exp> exp, std::shared_ptr<Exp> index)
-            : Statement(), id(std::move(id)), exp(std::move(exp)), index(std::move(index)) {}
+        ArrayAssign::ArrayAssign(ID *id, Exp *exp, Exp *index)
+            : Statement(), id(id), exp(exp), index(index) {}
 
-        ArrayDereference::ArrayDereference(std::shared_ptr<ID> id, std::shared_ptr<Exp> index)
-            : Exp(), id(std::move(id)), index(std::move(index)) {}
+        ArrayDereference::ArrayDereference(ID *id, Exp *index)
+            : Exp(), id(id), index(index) {}
 
-        Formal::Formal(std::shared_ptr<ID> id, std::shared_ptr<Type> type)
-            : Node(), id(std::move(id)), type(std::move(type)) {}
+        Formal::Formal(ID *id, Type *type)
+            : Node(), id(id), type(type) {}
 
-        Formals::Formals(std::shared_ptr<Formal> formal) : Node(), formals({std::move(formal)}) {}
+        Formals::Formals(Formal *formal) : Node(), formals({formal}) {}
 
-        void Formals::push_front(const std::shared_ptr<Formal> &formal)
-        {
-                formals.insert(formals.begin(), formal);
-        }
-
-        void Formals::push_back(const std::shared_ptr<Formal> &formal)
+        void Formals::push_back(Formal *formal)
         {
                 formals.push_back(formal);
         }
 
-        FuncDecl::FuncDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> return_type, std::shared_ptr<Formals> formals, std::shared_ptr<Statements> body)
-            : Node(), id(std::move(id)), return_type(std::move(return_type)), formals(std::move(formals)), body(std::move(body)) {}
+        FuncDecl::FuncDecl(ID *id, Type *return_type, Formals *formals, Statements *body)
+            : Node(), id(id), return_type(return_type), formals(formals), body(body) {}
 
-        Funcs::Funcs(std::shared_ptr<FuncDecl> func) : Node(), funcs({std::move(func)}) {}
-
-        void Funcs::push_front(const std::shared_ptr<FuncDecl> &func)
-        {
-                funcs.insert(funcs.begin(), func);
-        }
+        Funcs::Funcs(FuncDecl *func) : Node(), funcs({func}) {}
 
-        void Funcs::push_back(const std::shared_ptr<FuncDecl> &func)
+        void Funcs::push_back(FuncDecl *func)
         {
                 funcs.push_back(func);
         }
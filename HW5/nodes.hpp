@@ -1,10 +1,11 @@
 #ifndef NODES_HPP
 #define NODES_HPP
 
-#include <memory>
 #include <string>
 #include <vector>
 #include "visitor.hpp"
+#include "arena.hpp"
+#include "ir.hpp"
 
 namespace ast
 {
@@ -39,16 +40,19 @@ namespace ast
         STRING
     };
 
-    /* Base class for all AST nodes */
+    /* Base class for all AST nodes
+     * Nodes are allocated from an ast::Arena and are never deleted one by one,
+     * so child links are plain pointers owned by that arena.
+     */
     class Node
     {
     public:
         // Line number in the source code
         int line;
         
-        std::string reg;
+        ir::Value reg;
         
-        // Use this constructor only while parsing in bison or flex
+        // The line is stamped by Compilation::make once the node is built
         Node();
 
         // Accept method for visitor pattern
@@ -56,7 +60,7 @@ namespace ast
     };
 
     /* Base class for all expressions */
-    class Exp : virtual public Node
+    class Exp : public Node
     {
     public:
         ast::BuiltInType type;
@@ -64,7 +68,7 @@ namespace ast
     };
 
     /* Base class for all statements */
-    class Statement : virtual public Node
+    class Statement : public Node
     {
     };
 
@@ -153,14 +157,14 @@ namespace ast
     {
     public:
         // Left operand
-        std::shared_ptr<Exp> left;
+        Exp *left;
         // Right operand
-        std::shared_ptr<Exp> right;
+        Exp *right;
         // Operation
         BinOpType op;
 
         // Constructor that receives the left and right operands and the operation
-        BinOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, BinOpType op);
+        BinOp(Exp *left, Exp *right, BinOpType op);
 
         void accept(Visitor &visitor) override
         {
@@ -173,14 +177,14 @@ namespace ast
     {
     public:
         // Left operand
-        std::shared_ptr<Exp> left;
+        Exp *left;
         // Right operand
-        std::shared_ptr<Exp> right;
+        Exp *right;
         // Operation
         RelOpType op;
 
         // Constructor that receives the left and right operands and the operation
-        RelOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, RelOpType op);
+        RelOp(Exp *left, Exp *right, RelOpType op);
 
         void accept(Visitor &visitor) override
         {
@@ -193,10 +197,10 @@ namespace ast
     {
     public:
         // Operand
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
 
         // Constructor that receives the operand
-        explicit Not(std::shared_ptr<Exp> exp);
+        explicit Not(Exp *exp);
 
         void accept(Visitor &visitor) override
         {
@@ -209,12 +213,12 @@ namespace ast
     {
     public:
         // Left operand
-        std::shared_ptr<Exp> left;
+        Exp *left;
         // Right operand
-        std::shared_ptr<Exp> right;
+        Exp *right;
 
         // Constructor that receives the left and right operands
-        And(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right);
+        And(Exp *left, Exp *right);
 
         void accept(Visitor &visitor) override
         {
@@ -227,12 +231,12 @@ namespace ast
     {
     public:
         // Left operand
-        std::shared_ptr<Exp> left;
+        Exp *left;
         // Right operand
-        std::shared_ptr<Exp> right;
+        Exp *right;
 
         // Constructor that receives the left and right operands
-        Or(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right);
+        Or(Exp *left, Exp *right);
 
         void accept(Visitor &visitor) override
         {
@@ -244,12 +248,12 @@ namespace ast
     {
     public:
         // Identifier of the array
-        std::shared_ptr<ID> id;
+        ID *id;
         // Index expression of the array
-        std::shared_ptr<Exp> index;
+        Exp *index;
 
         // Constructor that receives the identifier and the index expression
-        ArrayDereference(std::shared_ptr<ID> id, std::shared_ptr<Exp> index);
+        ArrayDereference(ID *id, Exp *index);
 
         void accept(Visitor &visitor) override
         {
@@ -257,7 +261,7 @@ namespace ast
         }
     };
 
-    class Type : virtual public Node
+    class Type : public Node
     {
     public:
         Type() = default;
@@ -284,10 +288,10 @@ namespace ast
     {
     public:
         BuiltInType type;
-        std::shared_ptr<Exp> length;
+        Exp *length;
 
         // Constructor that receives the type
-        explicit ArrayType(BuiltInType type, std::shared_ptr<Exp> length);
+        explicit ArrayType(BuiltInType type, Exp *length);
 
         void accept(Visitor &visitor) override
         {
@@ -300,12 +304,12 @@ namespace ast
     {
     public:
         // Expression to be cast
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
         // Target type
-        std::shared_ptr<PrimitiveType> target_type;
+        PrimitiveType *target_type;
 
         // Constructor that receives the expression and the target type
-        Cast(std::shared_ptr<Exp> exp, std::shared_ptr<PrimitiveType> type);
+        Cast(Exp *exp, PrimitiveType *type);
 
         void accept(Visitor &visitor) override
         {
@@ -318,19 +322,16 @@ namespace ast
     {
     public:
         // List of expressions
-        std::vector<std::shared_ptr<Exp>> exps;
+        std::vector<Exp *> exps;
 
         // Constructor that receives no expressions
         ExpList() = default;
 
         // Constructor that receives the first expression
-        explicit ExpList(std::shared_ptr<Exp> exp);
-
-        // Method to add an expression at the beginning of the list
-        void push_front(const std::shared_ptr<Exp> &exp);
+        explicit ExpList(Exp *exp);
 
         // Method to add an expression at the end of the list
-        void push_back(const std::shared_ptr<Exp> &exp);
+        void push_back(Exp *exp);
 
         void accept(Visitor &visitor) override
         {
@@ -339,19 +340,32 @@ namespace ast
     };
 
     /* Function call */
-    class Call : public Exp, public Statement
+    class Call : public Exp
     {
     public:
         // Function identifier
-        std::shared_ptr<ID> func_id;
+        ID *func_id;
         // List of arguments as expressions
-        std::shared_ptr<ExpList> args;
+        ExpList *args;
 
         // Constructor that receives the function identifier and the list of arguments
-        Call(std::shared_ptr<ID> func_id, std::shared_ptr<ExpList> args);
+        Call(ID *func_id, ExpList *args);
+
+        void accept(Visitor &visitor) override
+        {
+            visitor.visit(*this);
+        }
+    };
 
-        // Constructor that receives only the function identifier (for parameterless functions)
-        explicit Call(std::shared_ptr<ID> func_id);
+    /* Function call used as a statement */
+    class CallStatement : public Statement
+    {
+    public:
+        // The call expression, whose result is discarded
+        Call *call;
+
+        // Constructor that receives the call expression
+        explicit CallStatement(Call *call);
 
         void accept(Visitor &visitor) override
         {
@@ -364,19 +378,16 @@ namespace ast
     {
     public:
         // List of statements
-        std::vector<std::shared_ptr<Statement>> statements;
+        std::vector<Statement *> statements;
 
         // Constructor that receives no statements
         Statements() = default;
 
         // Constructor that receives the first statement
-        explicit Statements(std::shared_ptr<Statement> statement);
-
-        // Method to add a statement at the beginning of the list
-        void push_front(const std::shared_ptr<Statement> &statement);
+        explicit Statements(Statement *statement);
 
         // Method to add a statement at the end of the list
-        void push_back(const std::shared_ptr<Statement> &statement);
+        void push_back(Statement *statement);
 
         void accept(Visitor &visitor) override
         {
@@ -407,10 +418,10 @@ namespace ast
     {
     public:
         // Expression to be returned. If the return is expressionless, this field is nullptr
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
 
         // Constructor that receives the expression to be returned
-        explicit Return(std::shared_ptr<Exp> exp = nullptr);
+        explicit Return(Exp *exp = nullptr);
 
         void accept(Visitor &visitor) override
         {
@@ -423,15 +434,14 @@ namespace ast
     {
     public:
         // Condition expression
-        std::shared_ptr<Exp> condition;
+        Exp *condition;
         // Statement to be executed if the condition is true
-        std::shared_ptr<Statement> then;
+        Statement *then;
         // Statement to be executed if the condition is false. For an if statement without else, this field is nullptr
-        std::shared_ptr<Statement> otherwise;
+        Statement *otherwise;
 
         // Constructor that receives the condition, the statement to be executed if the condition is true, and the statement to be executed if the condition is false
-        If(std::shared_ptr<Exp> condition, std::shared_ptr<Statement> then,
-           std::shared_ptr<Statement> otherwise = nullptr);
+        If(Exp *condition, Statement *then, Statement *otherwise = nullptr);
 
         void accept(Visitor &visitor) override
         {
@@ -444,12 +454,12 @@ namespace ast
     {
     public:
         // Condition expression
-        std::shared_ptr<Exp> condition;
+        Exp *condition;
         // Statement to be executed while the condition is true
-        std::shared_ptr<Statement> body;
+        Statement *body;
 
         // Constructor that receives the condition and the statement to be executed while the condition is true
-        While(std::shared_ptr<Exp> condition, std::shared_ptr<Statement> body);
+        While(Exp *condition, Statement *body);
 
         void accept(Visitor &visitor) override
         {
@@ -462,14 +472,14 @@ namespace ast
     {
     public:
         // Identifier of the variable
-        std::shared_ptr<ID> id;
+        ID *id;
         // Type of the variable
-        std::shared_ptr<Type> type;
+        Type *type;
         // Initial value of the variable. If the variable is not initialized, this field is nullptr
-        std::shared_ptr<Exp> init_exp;
+        Exp *init_exp;
 
         // Constructor that receives the identifier, the type, and the initial value expression
-        VarDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> type, std::shared_ptr<Exp> init_exp = nullptr);
+        VarDecl(ID *id, Type *type, Exp *init_exp = nullptr);
 
         void accept(Visitor &visitor) override
         {
@@ -482,12 +492,12 @@ namespace ast
     {
     public:
         // Identifier of the variable
-        std::shared_ptr<ID> id;
+        ID *id;
         // Expression to be assigned
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
 
         // Constructor that receives the identifier and the expression to be assigned
-        Assign(std::shared_ptr<ID> id, std::shared_ptr<Exp> exp);
+        Assign(ID *id, Exp *exp);
 
         void accept(Visitor &visitor) override
         {
@@ -499,14 +509,14 @@ namespace ast
     {
     public:
         // Identifier of the variable
-        std::shared_ptr<ID> id;
+        ID *id;
         // Index expression of the array
-        std::shared_ptr<Exp> index;
+        Exp *index;
         // Expression to be assigned
-        std::shared_ptr<Exp> exp;
+        Exp *exp;
 
         // Constructor that receives the identifier and the expression to be assigned
-        ArrayAssign(std::shared_ptr<ID> id, std::shared_ptr<Exp> exp, std::shared_ptr<Exp> index);
+        ArrayAssign(ID *id, Exp *exp, Exp *index);
 
         void accept(Visitor &visitor) override
         {
@@ -519,12 +529,12 @@ namespace ast
     {
     public:
         // Identifier of the parameter
-        std::shared_ptr<ID> id;
+        ID *id;
         // Type of the parameter
-        std::shared_ptr<Type> type;
+        Type *type;
 
         // Constructor that receives the identifier and the type
-        Formal(std::shared_ptr<ID> id, std::shared_ptr<Type> type);
+        Formal(ID *id, Type *type);
 
         void accept(Visitor &visitor) override
         {
@@ -537,19 +547,16 @@ namespace ast
     {
     public:
         // List of formal parameters
-        std::vector<std::shared_ptr<Formal>> formals;
+        std::vector<Formal *> formals;
 
         // Constructor that receives no parameters
         Formals() = default;
 
         // Constructor that receives the first formal parameter
-        explicit Formals(std::shared_ptr<Formal> formal);
-
-        // Method to add a formal parameter at the beginning of the list
-        void push_front(const std::shared_ptr<Formal> &formal);
+        explicit Formals(Formal *formal);
 
         // Method to add a formal parameter at the end of the list
-        void push_back(const std::shared_ptr<Formal> &formal);
+        void push_back(Formal *formal);
 
         void accept(Visitor &visitor) override
         {
@@ -562,16 +569,16 @@ namespace ast
     {
     public:
         // Identifier of the function
-        std::shared_ptr<ID> id;
+        ID *id;
         // Return type of the function
-        std::shared_ptr<Type> return_type;
+        Type *return_type;
         // List of formal parameters
-        std::shared_ptr<Formals> formals;
+        Formals *formals;
         // Body of the function
-        std::shared_ptr<Statements> body;
+        Statements *body;
 
         // Constructor that receives the identifier, the return type, the list of formal parameters, and the body
-        FuncDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> return_type, std::shared_ptr<Formals> formals, std::shared_ptr<Statements> body);
+        FuncDecl(ID *id, Type *return_type, Formals *formals, Statements *body);
 
         void accept(Visitor &visitor) override
         {
@@ -584,19 +591,16 @@ namespace ast
     {
     public:
         // List of function declarations
-        std::vector<std::shared_ptr<FuncDecl>> funcs;
+        std::vector<FuncDecl *> funcs;
 
         // Constructor that receives no function declarations
         Funcs() = default;
 
         // Constructor that receives the first function declaration
-        explicit Funcs(std::shared_ptr<FuncDecl> func);
-
-        // Method to add a function declaration at the beginning of the list
-        void push_front(const std::shared_ptr<FuncDecl> &func);
+        explicit Funcs(FuncDecl *func);
 
         // Method to add a function declaration at the end of the list
-        void push_back(const std::shared_ptr<FuncDecl> &func);
+        void push_back(FuncDecl *func);
 
         void accept(Visitor &visitor) override
         {
@@ -605,9 +609,7 @@ namespace ast
     };
 }
 
-#define YYSTYPE std::shared_ptr<ast::Node>
-
 #endif // NODES_HPP
 
-// ArrayType:      Type {$$ = make_shared<ast::ArrayType>(dynamic_pointer_cast<ast::PrimitiveType>($1)->type, nullptr);}
+// ArrayType:      Type {$$ = arena.make<ast::ArrayType>(dynamic_cast<ast::PrimitiveType *>($1)->type, nullptr);}
 //  ;
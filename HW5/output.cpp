@@ -23,82 +23,98 @@ namespace output {
 
     /* Error handling functions */
 
+    CompileError::CompileError(const std::string &message) : std::runtime_error(message) {}
+
     void errorLex(int lineno) {
-        std::cout << "line " << lineno << ": lexical error\n";
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ": lexical error\n";
+        throw CompileError(message.str());
     }
 
     void errorSyn(int lineno) {
-        std::cout << "line " << lineno << ": syntax error\n";
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ": syntax error\n";
+        throw CompileError(message.str());
     }
 
     void errorUndef(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " variable " << id << " is not defined" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ":" << " variable " << id << " is not defined" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorDefAsFunc(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " symbol " << id << " is a function" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ":" << " symbol " << id << " is a function" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorDefAsVar(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " symbol " << id << " is a variable" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ":" << " symbol " << id << " is a variable" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorDef(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " symbol " << id << " is already defined" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ":" << " symbol " << id << " is already defined" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorUndefFunc(int lineno, const std::string &id) {
-        std::cout << "line " << lineno << ":" << " function " << id << " is not defined" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ":" << " function " << id << " is not defined" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorMismatch(int lineno) {
-        std::cout << "line " << lineno << ":" << " type mismatch" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ":" << " type mismatch" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorPrototypeMismatch(int lineno, const std::string &id, std::vector<std::string> &paramTypes) {
-        std::cout << "line " << lineno << ": prototype mismatch, function " << id << " expects parameters (";
+        std::ostringstream message;
+        message << "line " << lineno << ": prototype mismatch, function " << id << " expects parameters (";
 
         for (int i = 0; i < paramTypes.size(); ++i) {
-            std::cout << paramTypes[i];
+            message << paramTypes[i];
             if (i != paramTypes.size() - 1)
-                std::cout << ",";
+                message << ",";
         }
 
-        std::cout << ")" << std::endl;
-        exit(0);
+        message << ")" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorUnexpectedBreak(int lineno) {
-        std::cout << "line " << lineno << ":" << " unexpected break statement" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ":" << " unexpected break statement" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorUnexpectedContinue(int lineno) {
-        std::cout << "line " << lineno << ":" << " unexpected continue statement" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ":" << " unexpected continue statement" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorMainMissing() {
-        std::cout << "Program has no 'void main()' function" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "Program has no 'void main()' function" << std::endl;
+        throw CompileError(message.str());
     }
 
     void errorByteTooLarge(int lineno, const int value) {
-        std::cout << "line " << lineno << ": byte value " << value << " out of range" << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ": byte value " << value << " out of range" << std::endl;
+        throw CompileError(message.str());
     }
 
     void ErrorInvalidAssignArray(int lineno, const std::string &id_arr) {
-        std::cout << "line " << lineno << ": invalid assignment to array " << id_arr << std::endl;
-        exit(0);
+        std::ostringstream message;
+        message << "line " << lineno << ": invalid assignment to array " << id_arr << std::endl;
+        throw CompileError(message.str());
     }
 
     /* ScopePrinter class */
@@ -151,40 +167,4 @@ namespace output {
         os << "---end global scope---" << std::endl;
         return os;
     }
-
-    /* CodeBuffer class */
-
-    CodeBuffer::CodeBuffer() : labelCount(0), varCount(0), stringCount(0) {}
-
-    std::string CodeBuffer::freshLabel() {
-        return "%label_" + std::to_string(labelCount++);
-    }
-
-    std::string CodeBuffer::freshVar() {
-        return "%t" + std::to_string(varCount++);
-    }
-
-    std::string CodeBuffer::emitString(const std::string &str) {
-        std::string var = "@.str" + std::to_string(stringCount++);
-        globalsBuffer << var << " = constant [" << str.length() + 1 << " x i8] c\"" << str << "\\00\"";
-        return var;
-    }
-
-    void CodeBuffer::emit(const std::string &str) {
-        buffer << str << std::endl;
-    }
-
-    void CodeBuffer::emitLabel(const std::string &label) {
-        buffer << label.substr(1) << ":" << std::endl;
-    }
-
-    CodeBuffer &CodeBuffer::operator<<(std::ostream &(*manip)(std::ostream &)) {
-        buffer << manip;
-        return *this;
-    }
-
-    std::ostream &operator<<(std::ostream &os, const CodeBuffer &buffer) {
-        os << buffer.globalsBuffer.str() << std::endl << buffer.buffer.str();
-        return os;
-    }
 }
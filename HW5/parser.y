@@ -2,25 +2,53 @@
 
 #include "nodes.hpp"
 #include "output.hpp"
+#include "compilation.hpp"
 
-// bison declarations
-extern int yylineno;
-extern int yylex();
+// Keep the parser stacks off the heap, so a diagnostic thrown mid-parse leaks nothing
+#define YYSTACK_USE_ALLOCA 1
 
-void yyerror(const char*);
-
-// root of the AST, set by the parser and used by other parts of the compiler
-std::shared_ptr<ast::Node> program;
-//std::shared_ptr<ast::Node> node_ptr;
+void yyerror(Compilation &ctx, yyscan_t, const char*);
 
 using namespace std;
-// Commented out because we're using %union instead
-// #define YYSTYPE std::shared_ptr<ast::Node>
-extern char* yytext;
 %}
 
-// Define the union for semantic values
+%code requires {
+#include "nodes.hpp"
+
+class Compilation;
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+}
 
+// Reentrant parser: all state lives in the Compilation and the scanner handle
+%define api.pure full
+%parse-param {Compilation &ctx} {yyscan_t scanner}
+%lex-param {yyscan_t scanner}
+
+// The flex header needs YYSTYPE, so it goes after the generated definitions
+%code {
+#include "lex.yy.h"
+}
+
+// Define the union for semantic values
+%union {
+    ast::BinOpType binOp;
+    ast::RelOpType relOp;
+    ast::Exp *exp;
+    ast::ID *id;
+    ast::PrimitiveType *primitiveType;
+    ast::ExpList *expList;
+    ast::Call *call;
+    ast::Statement *statement;
+    ast::Statements *statements;
+    ast::Formal *formal;
+    ast::Formals *formals;
+    ast::FuncDecl *funcDecl;
+    ast::Funcs *funcs;
+}
 
 %token VOID
 %token INT
@@ -40,18 +68,18 @@ extern char* yytext;
 %token RBRACE
 %token LBRACK
 %token RBRACK
-%token ID
-%token NUM
-%token NUM_B
-%token STRING
+%token <id> ID
+%token <exp> NUM
+%token <exp> NUM_B
+%token <exp> STRING
 
 %left OR
 %left AND
 %right ASSIGN
-%left RELOP_LOW
-%left RELOP_HIGH
-%left BINOP_LOW
-%left BINOP_HIGH
+%left <relOp> RELOP_LOW
+%left <relOp> RELOP_HIGH
+%left <binOp> BINOP_LOW
+%left <binOp> BINOP_HIGH
 %right NOT
 
 %nonassoc IFX
@@ -62,180 +90,128 @@ extern char* yytext;
 %precedence CASTING
 
 // Define the types for non-terminals
-//%type <node_ptr> Program Funcs FuncDecl RetType Formals FormalsList FormalDecl Statements Statement Call ExpList Type Exp
+%type <funcs> Funcs
+%type <funcDecl> FuncDecl
+%type <primitiveType> RetType Type
+%type <formals> Formals FormalsList
+%type <formal> FormalDecl
+%type <statements> Statements
+%type <statement> Statement
+%type <call> Call
+%type <expList> ExpList
+%type <exp> Exp
 
 %%
 
 // While reducing the start variable, set the root of the AST
-Program:  Funcs { program = $1; }
+Program:  Funcs { ctx.setProgram($1); }
 ;
 
-Funcs:                  { $$ = std::make_shared<ast::Funcs>(); }
-|   FuncDecl Funcs      { 
-                            auto funcs = std::dynamic_pointer_cast<ast::Funcs>($2);
-                            funcs->push_front(std::dynamic_pointer_cast<ast::FuncDecl>($1));
-                            $$ = funcs;
+Funcs:                  { $$ = ctx.make<ast::Funcs>(); }
+|   Funcs FuncDecl      { 
+                            $1->push_back($2);
+                            $$ = $1;
                         }
 ;
 
 FuncDecl:  RetType ID LPAREN Formals RPAREN LBRACE Statements RBRACE
         { 
-            $$ = std::make_shared<ast::FuncDecl>(
-                std::dynamic_pointer_cast<ast::ID>($2),
-                std::dynamic_pointer_cast<ast::Type>($1),
-                std::dynamic_pointer_cast<ast::Formals>($4),
-                std::dynamic_pointer_cast<ast::Statements>($7)
-            );
+            $$ = ctx.make<ast::FuncDecl>($2, $1, $4, $7);
         }
 ;
 
 RetType:  Type { $$ = $1; }
-|   VOID { $$ = std::make_shared<ast::PrimitiveType>(ast::BuiltInType::VOID); }
+|   VOID { $$ = ctx.make<ast::PrimitiveType>(ast::BuiltInType::VOID); }
 ;
 
-Formals:  { $$ = std::make_shared<ast::Formals>(); }
+Formals:  { $$ = ctx.make<ast::Formals>(); }
 |   FormalsList { $$ = $1; }
 ;
 
-FormalsList:  FormalDecl { $$ = std::make_shared<ast::Formals>(std::dynamic_pointer_cast<ast::Formal>($1));}
-|   FormalDecl COMMA FormalsList { 
-            auto formalsList = std::dynamic_pointer_cast<ast::Formals>($3);
-            formalsList->push_front(std::dynamic_pointer_cast<ast::Formal>($1));
-            $$ = formalsList;
+FormalsList:  FormalDecl { $$ = ctx.make<ast::Formals>($1); }
+|   FormalsList COMMA FormalDecl { 
+            $1->push_back($3);
+            $$ = $1;
         }
 ;
 
 FormalDecl:  Type ID { 
-                $$ = std::make_shared<ast::Formal>(
-                    std::dynamic_pointer_cast<ast::ID>($2),
-                    std::dynamic_pointer_cast<ast::Type>($1)
-                );
+                $$ = ctx.make<ast::Formal>($2, $1);
             }
 ;
 
-Statements:  Statement {$$ = std::make_shared<ast::Statements>(std::dynamic_pointer_cast<ast::Statement>($1));}
+Statements:  Statement { $$ = ctx.make<ast::Statements>($1); }
 |   Statements Statement { 
-                            auto statements = std::dynamic_pointer_cast<ast::Statements>($1);
-                            statements->push_back(std::dynamic_pointer_cast<ast::Statement>($2));
-                            $$ = statements;
+                            $1->push_back($2);
+                            $$ = $1;
                         }
 ;
 
 Statement:  LBRACE Statements RBRACE { $$ = $2; }
 |   Type ID SC { 
-            $$ = std::make_shared<ast::VarDecl>(
-                std::dynamic_pointer_cast<ast::ID>($2),
-                std::dynamic_pointer_cast<ast::Type>($1)
-            );
+            $$ = ctx.make<ast::VarDecl>($2, $1);
         }
 |   Type ID ASSIGN Exp SC { 
-            $$ = std::make_shared<ast::VarDecl>(
-                std::dynamic_pointer_cast<ast::ID>($2),
-                std::dynamic_pointer_cast<ast::Type>($1),
-                std::dynamic_pointer_cast<ast::Exp>($4)
-            );
+            $$ = ctx.make<ast::VarDecl>($2, $1, $4);
         }
 |   ID ASSIGN Exp SC { 
-            $$ = std::make_shared<ast::Assign>(
-                std::dynamic_pointer_cast<ast::ID>($1),
-                std::dynamic_pointer_cast<ast::Exp>($3)
-            );
+            $$ = ctx.make<ast::Assign>($1, $3);
         }
 |   ID LBRACK Exp RBRACK ASSIGN Exp SC { 
-            $$ = std::make_shared<ast::ArrayAssign>(
-                std::dynamic_pointer_cast<ast::ID>($1),
-                std::dynamic_pointer_cast<ast::Exp>($6),
-                std::dynamic_pointer_cast<ast::Exp>($3)
-            );
+            $$ = ctx.make<ast::ArrayAssign>($1, $6, $3);
         }
 |   Type ID LBRACK Exp RBRACK SC { 
-            auto primitiveType = std::dynamic_pointer_cast<ast::PrimitiveType>($1);
-            auto type = std::make_shared<ast::ArrayType>(
-                primitiveType->type,
-                std::dynamic_pointer_cast<ast::Exp>($4)
-            );
-            $$ = std::make_shared<ast::VarDecl>(
-                std::dynamic_pointer_cast<ast::ID>($2),
-                type
-            );
+            auto type = ctx.make<ast::ArrayType>($1->type, $4);
+            $$ = ctx.make<ast::VarDecl>($2, type);
         }
-|   Call SC { $$ = $1; }
-|   RETURN SC { $$ = std::make_shared<ast::Return>(); }
+|   Call SC { $$ = ctx.make<ast::CallStatement>($1); }
+|   RETURN SC { $$ = ctx.make<ast::Return>(); }
 |   RETURN Exp SC { 
-            $$ = std::make_shared<ast::Return>(
-                std::dynamic_pointer_cast<ast::Exp>($2)
-            );
+            $$ = ctx.make<ast::Return>($2);
         }
 |   IF LPAREN Exp RPAREN Statement %prec IFX { 
-            $$ = std::make_shared<ast::If>(
-                std::dynamic_pointer_cast<ast::Exp>($3),
-                std::dynamic_pointer_cast<ast::Statement>($5)
-            );
+            $$ = ctx.make<ast::If>($3, $5);
         }
 |   IF LPAREN Exp RPAREN Statement ELSE Statement { 
-            $$ = std::make_shared<ast::If>(
-                std::dynamic_pointer_cast<ast::Exp>($3),
-                std::dynamic_pointer_cast<ast::Statement>($5),
-                std::dynamic_pointer_cast<ast::Statement>($7)
-            );
+            $$ = ctx.make<ast::If>($3, $5, $7);
         }
 |   WHILE LPAREN Exp RPAREN Statement { 
-            $$ = std::make_shared<ast::While>(
-                std::dynamic_pointer_cast<ast::Exp>($3),
-                std::dynamic_pointer_cast<ast::Statement>($5)
-            );
+            $$ = ctx.make<ast::While>($3, $5);
         }
-|   BREAK SC { $$ = std::make_shared<ast::Break>(); }
-|   CONTINUE SC { $$ = std::make_shared<ast::Continue>(); }
+|   BREAK SC { $$ = ctx.make<ast::Break>(); }
+|   CONTINUE SC { $$ = ctx.make<ast::Continue>(); }
 ;
 
 Call:  ID LPAREN ExpList RPAREN { 
-            $$ = std::make_shared<ast::Call>(
-                std::dynamic_pointer_cast<ast::ID>($1),
-                std::dynamic_pointer_cast<ast::ExpList>($3)
-            );
+            $$ = ctx.make<ast::Call>($1, $3);
         }
 |   ID LPAREN RPAREN { 
-            $$ = std::make_shared<ast::Call>(
-                std::dynamic_pointer_cast<ast::ID>($1)
-            );
+            $$ = ctx.make<ast::Call>($1, ctx.make<ast::ExpList>());
         }
 ;
 
-ExpList:  Exp { $$ = std::make_shared<ast::ExpList>(std::dynamic_pointer_cast<ast::Exp>($1)); }
-|   Exp COMMA ExpList { 
-            auto expList = std::dynamic_pointer_cast<ast::ExpList>($3);
-            expList->push_front(std::dynamic_pointer_cast<ast::Exp>($1));
-            $$ = expList;
+ExpList:  Exp { $$ = ctx.make<ast::ExpList>($1); }
+|   ExpList COMMA Exp { 
+            $1->push_back($3);
+            $$ = $1;
         }
 ;
 
-Type:  INT { $$ = std::make_shared<ast::PrimitiveType>(ast::BuiltInType::INT); }
-|   BYTE { $$ = std::make_shared<ast::PrimitiveType>(ast::BuiltInType::BYTE); }
-|   BOOL { $$ = std::make_shared<ast::PrimitiveType>(ast::BuiltInType::BOOL); }
+Type:  INT { $$ = ctx.make<ast::PrimitiveType>(ast::BuiltInType::INT); }
+|   BYTE { $$ = ctx.make<ast::PrimitiveType>(ast::BuiltInType::BYTE); }
+|   BOOL { $$ = ctx.make<ast::PrimitiveType>(ast::BuiltInType::BOOL); }
 ;
 
 Exp:    LPAREN Exp RPAREN { $$ = $2; }
 |   ID LBRACK Exp RBRACK { 
-            $$ = std::make_shared<ast::ArrayDereference>(
-                std::dynamic_pointer_cast<ast::ID>($1),
-                std::dynamic_pointer_cast<ast::Exp>($3)
-            );
+            $$ = ctx.make<ast::ArrayDereference>($1, $3);
         }
 
 |   Exp BINOP_LOW Exp {
-            $$ = std::make_shared<ast::BinOp>(
-                std::dynamic_pointer_cast<ast::Exp>($1),
-                std::dynamic_pointer_cast<ast::Exp>($3),
-                std::dynamic_pointer_cast<ast::BinOp>($2)->op
-            );
+            $$ = ctx.make<ast::BinOp>($1, $3, $2);
         }
 |    Exp BINOP_HIGH Exp {
-            $$ = std::make_shared<ast::BinOp>(
-                std::dynamic_pointer_cast<ast::Exp>($1),
-                std::dynamic_pointer_cast<ast::Exp>($3),
-                std::dynamic_pointer_cast<ast::BinOp>($2)->op
-            );
+            $$ = ctx.make<ast::BinOp>($1, $3, $2);
         }
 
 |   ID  %prec ID_AS_VALUE { $$ = $1; }
@@ -243,56 +219,35 @@ Exp:    LPAREN Exp RPAREN { $$ = $2; }
 |   NUM { $$ = $1; }
 |   NUM_B { $$ = $1; }
 |   STRING { $$ = $1; }
-|   TRUE { $$ = std::make_shared<ast::Bool>(true); }
-|   FALSE { $$ = std::make_shared<ast::Bool>(false); }
+|   TRUE { $$ = ctx.make<ast::Bool>(true); }
+|   FALSE { $$ = ctx.make<ast::Bool>(false); }
 |   NOT Exp { 
-            $$ = std::make_shared<ast::Not>(
-                std::dynamic_pointer_cast<ast::Exp>($2)
-            );
+            $$ = ctx.make<ast::Not>($2);
         }
 |   Exp AND Exp { 
-            $$ = std::make_shared<ast::And>(
-                std::dynamic_pointer_cast<ast::Exp>($1),
-                std::dynamic_pointer_cast<ast::Exp>($3)
-            );
+            $$ = ctx.make<ast::And>($1, $3);
         }
 |   Exp OR Exp { 
-            $$ = std::make_shared<ast::Or>(
-                std::dynamic_pointer_cast<ast::Exp>($1),
-                std::dynamic_pointer_cast<ast::Exp>($3)
-            );
+            $$ = ctx.make<ast::Or>($1, $3);
         }
 
 
 
 |   Exp RELOP_LOW Exp { 
-            $$ = std::make_shared<ast::RelOp>(
-                std::dynamic_pointer_cast<ast::Exp>($1),
-                std::dynamic_pointer_cast<ast::Exp>($3),
-                std::dynamic_pointer_cast<ast::RelOp>($2)->op
-            );
+            $$ = ctx.make<ast::RelOp>($1, $3, $2);
         }
 |    Exp RELOP_HIGH Exp { 
-            $$ = std::make_shared<ast::RelOp>(
-                std::dynamic_pointer_cast<ast::Exp>($1),
-                std::dynamic_pointer_cast<ast::Exp>($3),
-                std::dynamic_pointer_cast<ast::RelOp>($2)->op
-            );
+            $$ = ctx.make<ast::RelOp>($1, $3, $2);
         }
 
 |   LPAREN Type RPAREN Exp %prec CASTING { 
-            auto type = std::dynamic_pointer_cast<ast::Type>($2);
-            auto primitiveType = std::dynamic_pointer_cast<ast::PrimitiveType>(type);
-            $$ = std::make_shared<ast::Cast>(
-                std::dynamic_pointer_cast<ast::Exp>($4),
-                primitiveType
-            );
+            $$ = ctx.make<ast::Cast>($4, $2);
         }
 
 
 %%
 
-void yyerror(const char* message) {
-    output::errorSyn(yylineno);
-    exit(0);
+
+void yyerror(Compilation &ctx, yyscan_t, const char*) {
+    output::errorSyn(ctx.lineno());
 }
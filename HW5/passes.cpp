@@ -0,0 +1,103 @@
+#include "passes.hpp"
+#include "arithmetic.hpp"
+#include "boundsChecks.hpp"
+#include "cfg.hpp"
+#include "loopInvariants.hpp"
+#include "mem2reg.hpp"
+#include "tailCalls.hpp"
+#include "valueNumbering.hpp"
+
+namespace ir
+{
+
+        PassStats &PassStats::operator+=(const PassStats &other)
+        {
+                boundsChecks += other.boundsChecks;
+                boundsChecksRemoved += other.boundsChecksRemoved;
+                boundsChecksHoisted += other.boundsChecksHoisted;
+                blocksRemoved += other.blocksRemoved;
+                callsInlined += other.callsInlined;
+                tailCallsEliminated += other.tailCallsEliminated;
+                tailCallsMarked += other.tailCallsMarked;
+                loopInvariantsHoisted += other.loopInvariantsHoisted;
+                elementsPromoted += other.elementsPromoted;
+                preheadersAdded += other.preheadersAdded;
+                arithmeticSimplified += other.arithmeticSimplified;
+                strengthReduced += other.strengthReduced;
+                deadInstructionsRemoved += other.deadInstructionsRemoved;
+                expressionsEliminated += other.expressionsEliminated;
+                loadsEliminated += other.loadsEliminated;
+                branchesFolded += other.branchesFolded;
+                valueNumberingReport.insert(valueNumberingReport.end(), other.valueNumberingReport.begin(),
+                                            other.valueNumberingReport.end());
+                return *this;
+        }
+
+        PassStats runPasses(Function &function, const PassOptions &options)
+        {
+                PassStats stats;
+                if (options.simplifyControlFlow)
+                {
+                        stats.blocksRemoved += simplifyControlFlow(function);
+                }
+
+                // The loops it makes go through the parameter slots, which are promoted next
+                if (options.eliminateTailCalls)
+                {
+                        TailCallCounts tailCalls = eliminateTailCalls(function);
+                        stats.tailCallsEliminated = tailCalls.eliminated;
+                        stats.tailCallsMarked = tailCalls.marked;
+                }
+                if (options.promoteLocals)
+                {
+                        promoteLocals(function);
+                }
+
+                // Ahead of the bounds checks, whose index it may move out of the
+                // loop; a check at the top of the loop can then follow it
+                if (options.hoistLoopInvariants)
+                {
+                        LoopInvariantCounts invariants = hoistLoopInvariants(function, options.promoteLocals);
+                        stats.loopInvariantsHoisted = invariants.hoisted;
+                        stats.elementsPromoted = invariants.promoted;
+                        stats.preheadersAdded = invariants.preheaders;
+                }
+
+                // Runs on SSA values; after --no-ssa only constant indices are known
+                if (options.eliminateBoundsChecks)
+                {
+                        BoundsCheckCounts checks = eliminateBoundsChecks(function);
+                        stats.boundsChecks = checks.total;
+                        stats.boundsChecksRemoved = checks.removed;
+                        stats.boundsChecksHoisted = checks.hoisted;
+                }
+
+                // Takes the checks the bounds check pass could not prove, and
+                // leaves the copies of an expression to the arithmetic below
+                if (options.numberValues)
+                {
+                        ValueNumberingCounts numbering = numberValues(function, stats.valueNumberingReport);
+                        stats.expressionsEliminated = numbering.expressions;
+                        stats.loadsEliminated = numbering.loads;
+                        stats.branchesFolded = numbering.branches;
+                }
+
+                // After the bounds checks, whose value ranges know multiplications
+                // but not the shifts they become
+                if (options.simplifyArithmetic)
+                {
+                        ArithmeticCounts arithmetic = simplifyArithmetic(function);
+                        stats.arithmeticSimplified = arithmetic.simplified;
+                        stats.strengthReduced = arithmetic.reduced;
+                        stats.deadInstructionsRemoved = arithmetic.removed;
+                }
+
+                // Removed checks and folded compares leave blocks that only jump on
+                if (options.simplifyControlFlow)
+                {
+                        stats.blocksRemoved += simplifyControlFlow(function);
+                }
+                return stats;
+        }
+
+}
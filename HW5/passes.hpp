@@ -0,0 +1,63 @@
+#ifndef PASSES_HPP
+#define PASSES_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // Which transformations runPasses applies
+    struct PassOptions
+    {
+        // Fold constant branches and drop unreachable, empty and split blocks
+        bool simplifyControlFlow = true;
+        // Turn self tail calls into loops and mark the other tail calls
+        bool eliminateTailCalls = true;
+        // Keep scalars in SSA values instead of stack slots
+        bool promoteLocals = true;
+        // Move computations that do not change in a loop out of it
+        bool hoistLoopInvariants = true;
+        // Drop the array bounds checks value ranges prove to pass
+        bool eliminateBoundsChecks = true;
+        // Reuse what a dominating instruction computed, loaded or checked
+        bool numberValues = true;
+        // Fold constants and identities, turn multiplications and divisions by constants into shifts
+        bool simplifyArithmetic = true;
+        // Inline calls to functions of at most this many instructions, 0 never does
+        int inlineThreshold = 20;
+    };
+
+    // What the passes did, summed over the functions of a module for --stats
+    struct PassStats
+    {
+        std::size_t boundsChecks = 0;
+        std::size_t boundsChecksRemoved = 0;
+        std::size_t boundsChecksHoisted = 0;
+        std::size_t blocksRemoved = 0;
+        std::size_t callsInlined = 0;
+        std::size_t tailCallsEliminated = 0;
+        std::size_t tailCallsMarked = 0;
+        std::size_t loopInvariantsHoisted = 0;
+        std::size_t elementsPromoted = 0;
+        std::size_t preheadersAdded = 0;
+        std::size_t arithmeticSimplified = 0;
+        std::size_t strengthReduced = 0;
+        std::size_t deadInstructionsRemoved = 0;
+        std::size_t expressionsEliminated = 0;
+        std::size_t loadsEliminated = 0;
+        std::size_t branchesFolded = 0;
+        // A line per function that value numbering changed, in source order
+        std::vector<std::string> valueNumberingReport;
+
+        PassStats &operator+=(const PassStats &other);
+    };
+
+    // Optimizes one function right after it is lowered
+    PassStats runPasses(Function &function, const PassOptions &options);
+
+}
+
+#endif // PASSES_HPP
@@ -8,7 +8,7 @@ SymbolEntry::SymbolEntry(string name, vector<BuiltInType> type, bool is_func,
                          bool has_return, int entry_offset,
                          BuiltInType entry_return_type,
                          bool is_formal_parameter, bool is_array,
-                         int array_size, const string &llvmRig)
+                         int array_size, const ir::Value &llvmRig)
     : entry_name(std::move(name)),
       entry_type(std::move(type)),
       is_func(is_func),
@@ -39,7 +39,7 @@ bool SymbolEntry::isArray() const { return is_array; }
 
 int SymbolEntry::getArraySize() const { return array_size; }
 
-string SymbolEntry::getLlvmRig() const { return llvmRig; }
+ir::Value SymbolEntry::getLlvmRig() const { return llvmRig; }
 
 // Implementing setters for SymbolEntry
 
@@ -69,7 +69,7 @@ void SymbolEntry::setIsArray(bool is_array) { this->is_array = is_array; }
 
 void SymbolEntry::setArraySize(int size) { array_size = size; }
 
-void SymbolEntry::setLlvmRig(const string &llvmRig) { this->llvmRig = llvmRig; }
+void SymbolEntry::setLlvmRig(const ir::Value &llvmRig) { this->llvmRig = llvmRig; }
 
 // Implementing the Scope class methods
 
@@ -78,28 +78,21 @@ Scope::Scope(bool is_loop_scope) : is_loop_scope(is_loop_scope) {
 }
 
 void Scope::addSymbol(shared_ptr<SymbolEntry> entry) {
+    // Only the first declaration of a name is visible through the scope
+    scope_index.emplace(entry->getName(), entry);
     scope_entries.push_back(move(entry));
 }
 
 shared_ptr<SymbolEntry> Scope::findEntry(const string &name) const {
-    for (const auto &entry : scope_entries) {
-        if (entry->getName() == name) {
-            return entry;
-        }
-    }
-    return nullptr;
+    auto it = scope_index.find(name);
+    return it != scope_index.end() ? it->second : nullptr;
 }
 
 bool Scope::contains(const string &name) const {
-    for (const auto &entry : scope_entries) {
-        if (entry->getName() == name) {
-            return true;
-        }
-    }
-    return false;
+    return scope_index.count(name) != 0;
 }
 
-vector<shared_ptr<SymbolEntry>> Scope::getEntries() const {
+const vector<shared_ptr<SymbolEntry>> &Scope::getEntries() const {
     return scope_entries;
 }
 
@@ -133,44 +126,72 @@ void SymbolTable::beginScope() {
 
 void SymbolTable::endScope() {
     if (!scopes.empty()) {
+        // Every binding of the innermost scope sits on top of its name's
+        // stack, so unwinding the scope's entries pops exactly those
+        for (const auto &entry : scopes.back()->getEntries()) {
+            auto it = bindings.find(entry->getName());
+            it->second.pop_back();
+            if (it->second.empty()) {
+                bindings.erase(it);
+            }
+        }
         scopes.pop_back();
         symbolTable_offsets.pop_back();
     }
 }
 
+void SymbolTable::bind(const shared_ptr<SymbolEntry> &entry, int depth) {
+    vector<Binding> &stack = bindings[entry->getName()];
+
+    // Keep the stack ordered by depth, and within one scope keep the first
+    // declaration on top so it wins lookups like the linear scan used to
+    auto pos = stack.end();
+    while (pos != stack.begin() && (pos - 1)->depth >= depth) {
+        --pos;
+    }
+    stack.insert(pos, Binding{entry, depth});
+}
+
 void SymbolTable::addEntry(shared_ptr<SymbolEntry> entry) {
     if (entry->isFunction()) {
         scopes.front()->addSymbol(entry);
+        bind(entry, 0);
+        return;
     } else if (entry->isFormalParameter()) {
         entry->setOffset(symbolTable_offsets.back()--);
-        scopes.back()->addSymbol(entry);
     } else {
         int size = entry->isArray() ? entry->getArraySize() : 1;
         entry->setOffset(symbolTable_offsets.back());
         symbolTable_offsets.back() += size;
-        scopes.back()->addSymbol(entry);
     }
+    scopes.back()->addSymbol(entry);
+    bind(entry, static_cast<int>(scopes.size()) - 1);
 }
 
 shared_ptr<SymbolEntry> SymbolTable::findEntry(const string &name,
                                                bool is_function) const {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-        shared_ptr<SymbolEntry> entry = (*it)->findEntry(name);
-        if (entry && entry->isFunction() == is_function) {
-            return entry;
+    auto it = bindings.find(name);
+    if (it == bindings.end()) {
+        return nullptr;
+    }
+
+    // A scope whose visible declaration has the wrong kind hides the rest
+    // of its own declarations, but not those of enclosing scopes
+    int skipDepth = -1;
+    for (auto b = it->second.rbegin(); b != it->second.rend(); ++b) {
+        if (b->depth == skipDepth) {
+            continue;
         }
+        if (b->entry->isFunction() == is_function) {
+            return b->entry;
+        }
+        skipDepth = b->depth;
     }
     return nullptr;
 }
 
 bool SymbolTable::contains(const string &name, bool is_function) const {
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-        shared_ptr<SymbolEntry> entry = (*it)->findEntry(name);
-        if (entry && entry->isFunction() == is_function) {
-            return true;
-        }
-    }
-    return false;
+    return findEntry(name, is_function) != nullptr;
 }
 
 vector<shared_ptr<SymbolEntry>> SymbolTable::getCurrentScopeEntries() const {
@@ -205,7 +226,9 @@ vector<BuiltInType> SymbolTable::getFunctionArgTypes(const string &name) {
     return vector<BuiltInType>();
 }
 
-vector<shared_ptr<Scope>> SymbolTable::getScopes() { return scopes; }
+const vector<shared_ptr<Scope>> &SymbolTable::getScopes() const {
+    return scopes;
+}
 
 void SymbolTable::setOffset(int offset) { symbolTable_offsets.back() = offset; }
 
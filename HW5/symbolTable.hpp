@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include "nodes.hpp"
 using namespace std;
 using namespace ast;
@@ -20,14 +21,14 @@ private:
     bool is_formal_parameter;
     bool is_array;
     int array_size;
-    string llvmRig;
+    ir::Value llvmRig;
 
 public:
     // Constructor for SymbolEntry
     SymbolEntry(string name, vector<BuiltInType> type, bool is_func = false,
                 bool has_return = false, int entry_offset = 0,
                 BuiltInType entry_return_type = BuiltInType::VOID, bool is_formal_parameter = false,
-                bool is_array = false, int array_size = 0, const string &llvmRig = "");
+                bool is_array = false, int array_size = 0, const ir::Value &llvmRig = ir::Value());
 
     // Getters for SymbolEntry
     string getName() const;
@@ -39,7 +40,7 @@ public:
     BuiltInType getReturnType() const;
     bool isArray() const;
     int getArraySize() const;
-    string getLlvmRig() const;
+    ir::Value getLlvmRig() const;
 
     // Setters for SymbolEntry
     void setName(const string &name);
@@ -51,7 +52,7 @@ public:
     void setIsFormalParameter(bool is_formal_parameter);
     void setIsArray(bool is_array);
     void setArraySize(int size);
-    void setLlvmRig(const string &llvmRig);
+    void setLlvmRig(const ir::Value &llvmRig);
 
     ~SymbolEntry();
 };
@@ -59,7 +60,11 @@ public:
 class Scope
 {
 private:
+    // Entries in declaration order; also serves as the undo list that
+    // SymbolTable::endScope uses to unwind the name bindings
     vector<shared_ptr<SymbolEntry>> scope_entries;
+    // Index of the first entry declared under each name in this scope
+    unordered_map<string, shared_ptr<SymbolEntry>> scope_index;
     bool is_loop_scope;
 
 public:
@@ -75,7 +80,7 @@ public:
     bool contains(const string &name) const;
 
     // Get all entries in the scope
-    vector<shared_ptr<SymbolEntry>> getEntries() const;
+    const vector<shared_ptr<SymbolEntry>> &getEntries() const;
 
     // Get the argument types of a function by its name
     vector<BuiltInType> getFunctionArgumentTypes(const string &name) const;
@@ -92,8 +97,20 @@ public:
 class SymbolTable
 {
 private:
+    // A visible declaration of a name, tagged with the depth of its scope
+    struct Binding
+    {
+        shared_ptr<SymbolEntry> entry;
+        int depth;
+    };
+
     vector<shared_ptr<Scope>> scopes;
     vector<int> symbolTable_offsets;
+    // Shadow stack per name: the innermost declaration is at the back
+    unordered_map<string, vector<Binding>> bindings;
+
+    // Bind an entry that was just added to the scope at the given depth
+    void bind(const shared_ptr<SymbolEntry> &entry, int depth);
 
 public:
     // Constructor for SymbolTable, initializes with a global scope
@@ -128,7 +145,7 @@ public:
     vector<BuiltInType> getFunctionArgTypes(const string &name);
 
     // Get all scopes in the symbol table
-    vector<shared_ptr<Scope>> getScopes();
+    const vector<shared_ptr<Scope>> &getScopes() const;
 
     // Set the offset for the current scope
     void setOffset(int offset);
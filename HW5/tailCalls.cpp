@@ -0,0 +1,205 @@
+#include "tailCalls.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                // Calls of the program or the runtime; intrinsics are no calls to the backend
+                bool isCall(const Instruction *instruction)
+                {
+                        return instruction != nullptr && instruction->op == Opcode::CALL &&
+                               std::strncmp(instruction->callee, "llvm.", 5) != 0;
+                }
+
+                Instruction *beforeLast(Block *block)
+                {
+                        Instruction *before = nullptr;
+                        for (Instruction *i = block->first; i != block->last; i = i->next)
+                        {
+                                before = i;
+                        }
+                        return before;
+                }
+
+                // The call right before the ret that ends block, when the ret returns its value
+                Instruction *tailCall(Block *block)
+                {
+                        Instruction *ret = block->last;
+                        if (ret == nullptr || ret->op != Opcode::RET)
+                        {
+                                return nullptr;
+                        }
+                        Instruction *call = beforeLast(block);
+                        if (!isCall(call) || call->type != ret->type ||
+                            (ret->type != Type::VOID && ret->lhs != call->result))
+                        {
+                                return nullptr;
+                        }
+                        return call;
+                }
+
+                // A void call followed by a jump to a lone "ret void", such as
+                // the last statement of an if at the end of a void function,
+                // gets a ret of its own
+                void duplicateReturns(Function &function)
+                {
+                        for (Block *block : function.blocks)
+                        {
+                                Instruction *jump = block->last;
+                                if (jump == nullptr || jump->op != Opcode::BR)
+                                {
+                                        continue;
+                                }
+                                // Other passes may be off, so the target can still be empty
+                                Block *target = jump->target;
+                                Instruction *call = beforeLast(block);
+                                if (!target->isTerminated() || target->first != target->last ||
+                                    target->first->op != Opcode::RET ||
+                                    target->first->type != Type::VOID || !isCall(call) || call->type != Type::VOID)
+                                {
+                                        continue;
+                                }
+                                jump->op = Opcode::RET;
+                                jump->target = nullptr;
+                                block->successors.clear();
+                                auto &predecessors = target->predecessors;
+                                predecessors.erase(std::find(predecessors.begin(), predecessors.end(), block));
+                        }
+                }
+
+                // Moves the code after last, the end of the allocas and the stores
+                // of the arguments, out of the entry block into the block
+                // returned, which the self calls jump back to
+                Block *splitEntry(Function &function, Instruction *last)
+                {
+                        Block *entry = function.blocks.front();
+                        Block *body = function.storage().make<Block>(function.labelCount++);
+                        body->first = last ? last->next : entry->first;
+                        body->last = entry->last;
+
+                        body->successors.swap(entry->successors);
+                        for (Block *successor : body->successors)
+                        {
+                                std::replace(successor->predecessors.begin(), successor->predecessors.end(), entry, body);
+                                for (Instruction *i = successor->first; i != nullptr && i->op == Opcode::PHI; i = i->next)
+                                {
+                                        for (int k = 0; k < i->incomingCount; ++k)
+                                        {
+                                                if (i->incoming[k].block == entry)
+                                                {
+                                                        i->incoming[k].block = body;
+                                                }
+                                        }
+                                }
+                        }
+
+                        Instruction *jump = function.storage().make<Instruction>(Opcode::BR);
+                        jump->target = body;
+                        (last ? last->next : entry->first) = jump;
+                        entry->last = jump;
+                        entry->successors.push_back(body);
+                        body->predecessors.push_back(entry);
+                        function.blocks.insert(function.blocks.begin() + 1, body);
+                        return body;
+                }
+
+                // Replaces the call and the ret after it by stores of the call's
+                // arguments into the parameter slots and a jump to body
+                void loopBack(Function &function, Block *block, Instruction *call, Block *body,
+                              const std::vector<Value> &slots)
+                {
+                        Instruction *ret = block->last;
+                        Instruction *link = nullptr;
+                        for (Instruction *i = block->first; i != call; i = i->next)
+                        {
+                                link = i;
+                        }
+
+                        // Every argument is computed before the first store, so
+                        // none of them sees a parameter of the next round
+                        for (size_t k = 0; k < slots.size(); ++k)
+                        {
+                                Instruction *store = function.storage().make<Instruction>(Opcode::STORE);
+                                store->type = function.parameters[k];
+                                store->lhs = call->arguments[k].value;
+                                store->rhs = slots[k];
+                                (link ? link->next : block->first) = store;
+                                link = store;
+                        }
+                        (link ? link->next : block->first) = ret;
+                        ret->op = Opcode::BR;
+                        ret->type = Type::VOID;
+                        ret->lhs = Value();
+                        ret->target = body;
+                        block->successors.push_back(body);
+                        body->predecessors.push_back(block);
+                }
+
+        }
+
+        TailCallCounts eliminateTailCalls(Function &function)
+        {
+                TailCallCounts counts;
+                duplicateReturns(function);
+
+                // The slot each argument is stored to at the top of the entry block
+                Block *entry = function.blocks.front();
+                std::vector<Value> slots(function.parameters.size());
+                Instruction *prologue = nullptr;
+                for (Instruction *i = entry->first; i != nullptr && i != entry->last; i = i->next)
+                {
+                        if (i->op == Opcode::STORE && i->lhs.kind == Value::Kind::ARGUMENT)
+                        {
+                                slots[i->lhs.id] = i->rhs;
+                        }
+                        else if (i->op != Opcode::ALLOCA)
+                        {
+                                break;
+                        }
+                        prologue = i;
+                }
+                bool canLoop = true;
+                for (const Value &slot : slots)
+                {
+                        canLoop = canLoop && !slot.isNone();
+                }
+
+                Block *body = nullptr;
+                std::vector<Block *> blocks = function.blocks;
+                for (Block *block : blocks)
+                {
+                        Instruction *call = tailCall(block);
+                        if (call == nullptr)
+                        {
+                                continue;
+                        }
+                        if (canLoop && function.name == call->callee)
+                        {
+                                if (body == nullptr)
+                                {
+                                        body = splitEntry(function, prologue);
+                                }
+                                loopBack(function, block == entry ? body : block, call, body, slots);
+                                ++counts.eliminated;
+                                continue;
+                        }
+
+                        // musttail needs the caller's and the callee's signatures to match
+                        bool same = call->type == function.returnType &&
+                                    call->argumentCount == static_cast<int>(function.parameters.size());
+                        for (int k = 0; same && k < call->argumentCount; ++k)
+                        {
+                                same = call->arguments[k].type == function.parameters[k];
+                        }
+                        call->tail = same ? TailCall::MUST : TailCall::TAIL;
+                        ++counts.marked;
+                }
+                return counts;
+        }
+
+}
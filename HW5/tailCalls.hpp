@@ -0,0 +1,26 @@
+#ifndef TAIL_CALLS_HPP
+#define TAIL_CALLS_HPP
+
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // Tail calls of one function, and what became of them
+    struct TailCallCounts
+    {
+        int eliminated = 0;
+        int marked = 0;
+    };
+
+    // Finds the calls whose value, or nothing after a void call, the function
+    // returns right away; a jump to a lone "ret void" counts as a return.
+    // Calls to the function itself become stores of the arguments into the
+    // parameter slots and a jump back to the top of the body, so runs on the
+    // stack slots, before promoteLocals. Other calls are marked musttail when
+    // the two signatures match and tail otherwise
+    TailCallCounts eliminateTailCalls(Function &function);
+
+}
+
+#endif // TAIL_CALLS_HPP
@@ -0,0 +1,122 @@
+#include "threadPool.hpp"
+#include <algorithm>
+
+// Implementing the ThreadPool class methods
+
+ThreadPool::ThreadPool(std::size_t threads)
+    : queues(), workers(), queued(0), unfinished(0), nextQueue(0), stopping(false)
+{
+    threads = std::max<std::size_t>(threads, 1);
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    // Counted before it is visible, so a worker never sees more tasks than counted
+    std::size_t target;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        target = nextQueue++ % queues.size();
+        queued++;
+        unfinished++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return unfinished == 0; });
+}
+
+std::size_t ThreadPool::size() const
+{
+    return workers.size();
+}
+
+bool ThreadPool::takeTask(std::size_t self, std::function<void()> &task)
+{
+    // Own queue first, newest task first
+    {
+        WorkQueue &own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // Then steal the oldest task of the next non-empty queue
+    for (std::size_t offset = 1; offset < queues.size(); ++offset)
+    {
+        WorkQueue &victim = *queues[(self + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(std::size_t self)
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        if (takeTask(self, task))
+        {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                queued--;
+            }
+            task();
+            bool done;
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                done = --unfinished == 0;
+            }
+            if (done)
+            {
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        // Nothing to take: sleep until a submit or shutdown
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+        {
+            return;
+        }
+    }
+}
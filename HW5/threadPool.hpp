@@ -0,0 +1,63 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* ThreadPool class
+ * Fixed set of workers, each with its own task deque. A worker takes work
+ * from the back of its own deque and, once that runs dry, steals from the
+ * front of the others, so one slow task never holds up the rest of a queue.
+ */
+class ThreadPool
+{
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    // Guards the counters below and backs both condition variables
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::size_t queued;
+    std::size_t unfinished;
+    std::size_t nextQueue;
+    bool stopping;
+
+    // Takes a task from queue `self`, or steals one from another queue
+    bool takeTask(std::size_t self, std::function<void()> &task);
+
+    void workerLoop(std::size_t self);
+
+public:
+    // Starts `threads` workers, at least one
+    explicit ThreadPool(std::size_t threads);
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Finishes the pending tasks, then joins the workers
+    ~ThreadPool();
+
+    // Queues a task. Tasks are dealt round-robin to the worker queues
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has run
+    void wait();
+
+    std::size_t size() const;
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,485 @@
+#include "valueNumbering.hpp"
+#include "cfg.hpp"
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+namespace ir
+{
+
+        namespace
+        {
+
+                // Blocks that print an error and exit
+                bool isTrap(const Block *block)
+                {
+                        return block->last != nullptr && block->last->op == Opcode::UNREACHABLE;
+                }
+
+                bool isPure(Opcode op)
+                {
+                        switch (op)
+                        {
+                        case Opcode::ADD:
+                        case Opcode::SUB:
+                        case Opcode::MUL:
+                        case Opcode::SDIV:
+                        case Opcode::AND:
+                        case Opcode::OR:
+                        case Opcode::XOR:
+                        case Opcode::SHL:
+                        case Opcode::LSHR:
+                        case Opcode::ASHR:
+                        case Opcode::ICMP:
+                        case Opcode::ZEXT:
+                        case Opcode::SEXT:
+                        case Opcode::TRUNC:
+                        case Opcode::BITCAST:
+                        case Opcode::GEP:
+                                return true;
+                        default:
+                                return false;
+                        }
+                }
+
+                bool commutes(const Instruction *instruction)
+                {
+                        switch (instruction->op)
+                        {
+                        case Opcode::ADD:
+                        case Opcode::MUL:
+                        case Opcode::AND:
+                        case Opcode::OR:
+                        case Opcode::XOR:
+                                return true;
+                        case Opcode::ICMP:
+                                return instruction->predicate == Predicate::EQ || instruction->predicate == Predicate::NE;
+                        default:
+                                return false;
+                        }
+                }
+
+                const char *opcodeName(Opcode op)
+                {
+                        switch (op)
+                        {
+                        case Opcode::LOAD:
+                                return "load";
+                        case Opcode::ADD:
+                                return "add";
+                        case Opcode::SUB:
+                                return "sub";
+                        case Opcode::MUL:
+                                return "mul";
+                        case Opcode::SDIV:
+                                return "sdiv";
+                        case Opcode::AND:
+                                return "and";
+                        case Opcode::OR:
+                                return "or";
+                        case Opcode::XOR:
+                                return "xor";
+                        case Opcode::SHL:
+                                return "shl";
+                        case Opcode::LSHR:
+                                return "lshr";
+                        case Opcode::ASHR:
+                                return "ashr";
+                        case Opcode::ICMP:
+                                return "icmp";
+                        case Opcode::ZEXT:
+                                return "zext";
+                        case Opcode::SEXT:
+                                return "sext";
+                        case Opcode::TRUNC:
+                                return "trunc";
+                        case Opcode::BITCAST:
+                                return "bitcast";
+                        default:
+                                return "getelementptr";
+                        }
+                }
+
+                const char *typeName(Type type)
+                {
+                        switch (type)
+                        {
+                        case Type::I1:
+                                return "i1";
+                        case Type::I8:
+                                return "i8";
+                        case Type::I32:
+                                return "i32";
+                        case Type::I64:
+                                return "i64";
+                        case Type::I8_PTR:
+                                return "i8*";
+                        default:
+                                return "void";
+                        }
+                }
+
+                // How the report names an instruction, e.g. "load i32" or "zext i8 to i32"
+                std::string describe(const Instruction *instruction)
+                {
+                        std::string text = opcodeName(instruction->op);
+                        text += ' ';
+                        if (instruction->op == Opcode::ZEXT || instruction->op == Opcode::SEXT ||
+                            instruction->op == Opcode::TRUNC || instruction->op == Opcode::BITCAST)
+                        {
+                                text += typeName(instruction->sourceType);
+                                text += " to ";
+                        }
+                        return text + typeName(instruction->type);
+                }
+
+                // What an instruction computes. A load's version tells the
+                // stores to its array apart; pure instructions have none
+                struct Key
+                {
+                        Opcode op;
+                        Type type;
+                        Type sourceType;
+                        Predicate predicate;
+                        Value lhs;
+                        Value rhs;
+                        int version;
+
+                        bool operator==(const Key &other) const
+                        {
+                                return op == other.op && type == other.type && sourceType == other.sourceType &&
+                                       predicate == other.predicate && lhs == other.lhs && rhs == other.rhs &&
+                                       version == other.version;
+                        }
+                };
+
+                struct KeyHash
+                {
+                        std::size_t operator()(const Key &key) const
+                        {
+                                std::size_t hash = static_cast<std::size_t>(key.op);
+                                for (int part : {static_cast<int>(key.type), static_cast<int>(key.sourceType),
+                                                 static_cast<int>(key.predicate), static_cast<int>(key.lhs.kind), key.lhs.id,
+                                                 static_cast<int>(key.rhs.kind), key.rhs.id, key.version})
+                                {
+                                        hash = hash * 31 + std::hash<int>()(part);
+                                }
+                                return hash;
+                        }
+                };
+
+                /* ValueNumbering class
+                 * A preorder walk of the dominator tree. The table of available
+                 * values and the decided conditions hold what the blocks on the
+                 * path from the entry computed, and are rolled back on the way
+                 * up. Memory is versioned per array: a store or a call taking
+                 * the array gives it a new version, a block entered from more
+                 * than one place gives every array one.
+                 */
+                class ValueNumbering
+                {
+                private:
+                        Function &function;
+                        ValueNumberingCounts counts;
+                        std::unordered_map<Key, Value, KeyHash> available;
+                        // Entries to restore on the way up: the key and what it held before
+                        std::vector<std::pair<Key, Value>> undo;
+                        // By temporary: 0 or 1 for a condition the path decided, else -1
+                        std::vector<signed char> decided;
+                        std::vector<int> decidedUndo;
+                        std::vector<Value> replacement;
+                        // By temporary: the array an address points into, 0 if unknown
+                        std::vector<int> rootOf;
+                        int roots = 1;
+                        int nextVersion = 0;
+                        // What was eliminated, by description, in order of first elimination
+                        std::vector<std::pair<std::string, int>> eliminated;
+
+                        Value resolve(Value value) const
+                        {
+                                while (value.kind == Value::Kind::TEMP && !replacement[value.id].isNone())
+                                {
+                                        value = replacement[value.id];
+                                }
+                                return value;
+                        }
+
+                        void record(const std::string &description)
+                        {
+                                for (auto &entry : eliminated)
+                                {
+                                        if (entry.first == description)
+                                        {
+                                                ++entry.second;
+                                                return;
+                                        }
+                                }
+                                eliminated.emplace_back(description, 1);
+                        }
+
+                        void findRoots()
+                        {
+                                rootOf.assign(function.tempCount, 0);
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                if (i->result.kind != Value::Kind::TEMP)
+                                                {
+                                                        continue;
+                                                }
+                                                if (i->op == Opcode::ALLOCA)
+                                                {
+                                                        rootOf[i->result.id] = roots++;
+                                                }
+                                                else if ((i->op == Opcode::GEP || i->op == Opcode::BITCAST) &&
+                                                         i->lhs.kind == Value::Kind::TEMP)
+                                                {
+                                                        // Allocas lead the entry block, so the root is known already
+                                                        rootOf[i->result.id] = rootOf[i->lhs.id];
+                                                }
+                                        }
+                                }
+                        }
+
+                        int root(Value pointer) const
+                        {
+                                return pointer.kind == Value::Kind::TEMP ? rootOf[pointer.id] : 0;
+                        }
+
+                        // Memory of the array changed; an unknown one may be any array,
+                        // and an address into an unknown one may point into any
+                        void clobber(std::vector<int> &memory, int array)
+                        {
+                                if (array != 0)
+                                {
+                                        memory[array] = nextVersion++;
+                                        memory[0] = nextVersion++;
+                                        return;
+                                }
+                                for (int &version : memory)
+                                {
+                                        version = nextVersion++;
+                                }
+                        }
+
+                        void define(const Key &key, Value value)
+                        {
+                                auto found = available.find(key);
+                                undo.emplace_back(key, found == available.end() ? Value() : found->second);
+                                available[key] = value;
+                        }
+
+                        void decide(Value condition, bool value)
+                        {
+                                if (condition.kind == Value::Kind::TEMP && decided[condition.id] < 0)
+                                {
+                                        decided[condition.id] = value;
+                                        decidedUndo.push_back(condition.id);
+                                }
+                        }
+
+                        void rollBack(std::size_t undoMark, std::size_t decidedMark)
+                        {
+                                while (undo.size() > undoMark)
+                                {
+                                        if (undo.back().second.isNone())
+                                        {
+                                                available.erase(undo.back().first);
+                                        }
+                                        else
+                                        {
+                                                available[undo.back().first] = undo.back().second;
+                                        }
+                                        undo.pop_back();
+                                }
+                                while (decidedUndo.size() > decidedMark)
+                                {
+                                        decided[decidedUndo.back()] = -1;
+                                        decidedUndo.pop_back();
+                                }
+                        }
+
+                        Key keyOf(const Instruction *instruction) const
+                        {
+                                Key key{instruction->op, instruction->type, instruction->sourceType, instruction->predicate,
+                                        instruction->lhs, instruction->rhs, 0};
+                                if (commutes(instruction) &&
+                                    (key.lhs.kind > key.rhs.kind || (key.lhs.kind == key.rhs.kind && key.lhs.id > key.rhs.id)))
+                                {
+                                        std::swap(key.lhs, key.rhs);
+                                }
+                                return key;
+                        }
+
+                        Key loadKey(Type type, Value pointer, const std::vector<int> &memory) const
+                        {
+                                return Key{Opcode::LOAD, type, Type::VOID, Predicate::EQ, pointer, Value(), memory[root(pointer)]};
+                        }
+
+                        // Whether the instruction goes, its result read from an earlier one
+                        bool eliminate(Instruction *instruction, const Key &key)
+                        {
+                                auto found = available.find(key);
+                                if (found != available.end())
+                                {
+                                        replacement[instruction->result.id] = found->second;
+                                        record(describe(instruction));
+                                        return true;
+                                }
+                                define(key, instruction->result);
+                                return false;
+                        }
+
+                        // A branch whose condition the path to it decided
+                        void foldBranch(Instruction *branch)
+                        {
+                                Value condition = branch->lhs;
+                                if (condition.kind != Value::Kind::TEMP || decided[condition.id] < 0)
+                                {
+                                        return;
+                                }
+                                bool taken = decided[condition.id] == 1;
+                                Block *untaken = taken ? branch->otherwise : branch->target;
+                                branch->lhs = Value::constant(taken);
+                                record(isTrap(untaken) ? "check" : "branch");
+                                ++counts.branches;
+                        }
+
+                        void visit(Block *block, std::vector<int> &memory)
+                        {
+                                if (block->predecessors.size() != 1)
+                                {
+                                        clobber(memory, 0);
+                                }
+                                else
+                                {
+                                        // Entered by one side of a branch, the block knows which
+                                        Instruction *branch = block->predecessors.front()->last;
+                                        if (branch->op == Opcode::COND_BR && branch->target != branch->otherwise)
+                                        {
+                                                decide(branch->lhs, branch->target == block);
+                                        }
+                                }
+
+                                Instruction *previous = nullptr;
+                                for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                {
+                                        i->forEachOperand([&](Value &operand) { operand = resolve(operand); });
+                                        bool gone = false;
+                                        if (isPure(i->op))
+                                        {
+                                                gone = eliminate(i, keyOf(i));
+                                                counts.expressions += gone;
+                                        }
+                                        else if (i->op == Opcode::LOAD)
+                                        {
+                                                gone = eliminate(i, loadKey(i->type, i->lhs, memory));
+                                                counts.loads += gone;
+                                        }
+                                        else if (i->op == Opcode::STORE)
+                                        {
+                                                // The next load of the address reads what was stored
+                                                clobber(memory, root(i->rhs));
+                                                define(loadKey(i->type, i->rhs, memory), i->lhs);
+                                        }
+                                        else if (i->op == Opcode::CALL)
+                                        {
+                                                // Functions only reach the arrays of their caller through their arguments
+                                                for (int k = 0; k < i->argumentCount; ++k)
+                                                {
+                                                        if (i->arguments[k].value.kind == Value::Kind::TEMP &&
+                                                            i->arguments[k].type == Type::I8_PTR)
+                                                        {
+                                                                clobber(memory, root(i->arguments[k].value));
+                                                        }
+                                                }
+                                        }
+                                        else if (i->op == Opcode::COND_BR)
+                                        {
+                                                foldBranch(i);
+                                        }
+
+                                        if (gone)
+                                        {
+                                                (previous ? previous->next : block->first) = i->next;
+                                        }
+                                        else
+                                        {
+                                                previous = i;
+                                        }
+                                }
+                                block->last = previous;
+                        }
+
+                public:
+                        explicit ValueNumbering(Function &function) : function(function) {}
+
+                        ValueNumberingCounts run(std::vector<std::string> &report)
+                        {
+                                findRoots();
+                                decided.assign(function.tempCount, -1);
+                                replacement.assign(function.tempCount, Value());
+                                DominatorTree tree(function);
+
+                                // Each frame keeps the memory versions at the end of its block for its children
+                                struct Frame
+                                {
+                                        Block *block;
+                                        std::size_t child;
+                                        std::size_t undoMark;
+                                        std::size_t decidedMark;
+                                        std::vector<int> memory;
+                                };
+                                std::vector<Frame> stack;
+                                Block *entry = tree.order().front();
+                                stack.push_back({entry, 0, 0, 0, std::vector<int>(roots, 0)});
+                                visit(entry, stack.back().memory);
+                                while (!stack.empty())
+                                {
+                                        Frame &top = stack.back();
+                                        const std::vector<Block *> &children = tree.children(top.block);
+                                        if (top.child < children.size())
+                                        {
+                                                Block *child = children[top.child++];
+                                                std::vector<int> memory = top.memory;
+                                                stack.push_back({child, 0, undo.size(), decidedUndo.size(), std::move(memory)});
+                                                visit(child, stack.back().memory);
+                                                continue;
+                                        }
+                                        rollBack(top.undoMark, top.decidedMark);
+                                        stack.pop_back();
+                                }
+
+                                // Phis read values of blocks the walk may reach after them
+                                for (Block *block : function.blocks)
+                                {
+                                        for (Instruction *i = block->first; i != nullptr; i = i->next)
+                                        {
+                                                i->forEachOperand([&](Value &operand) { operand = resolve(operand); });
+                                        }
+                                }
+
+                                if (!eliminated.empty())
+                                {
+                                        std::string line = function.name + ": eliminated ";
+                                        for (std::size_t k = 0; k < eliminated.size(); ++k)
+                                        {
+                                                line += k > 0 ? ", " : "";
+                                                line += eliminated[k].first + " x" + std::to_string(eliminated[k].second);
+                                        }
+                                        report.push_back(std::move(line));
+                                }
+                                return counts;
+                        }
+                };
+
+        }
+
+        ValueNumberingCounts numberValues(Function &function, std::vector<std::string> &report)
+        {
+                return ValueNumbering(function).run(report);
+        }
+
+}
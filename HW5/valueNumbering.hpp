@@ -0,0 +1,31 @@
+#ifndef VALUE_NUMBERING_HPP
+#define VALUE_NUMBERING_HPP
+
+#include <string>
+#include <vector>
+#include "ir.hpp"
+
+namespace ir
+{
+
+    // What value numbering removed from one function
+    struct ValueNumberingCounts
+    {
+        int expressions = 0;
+        int loads = 0;
+        int branches = 0;
+    };
+
+    // Hash based value numbering over the dominator tree: an instruction that
+    // computes what one in a dominating block already did is replaced by its
+    // result. A load reuses the value last loaded from or stored to the same
+    // address, unless a store to the same array, a call taking it, or a join
+    // of paths came in between. A branch on a condition its dominating
+    // branches decided, such as a repeated bounds check, gets that condition
+    // as a constant for simplifyControlFlow to fold. Appends a line to report
+    // naming what the function lost, if anything
+    ValueNumberingCounts numberValues(Function &function, std::vector<std::string> &report);
+
+}
+
+#endif // VALUE_NUMBERING_HPP
@@ -16,6 +16,7 @@ namespace ast {
     class Cast;
     class ExpList;
     class Call;
+    class CallStatement;
     class Statements;
     class Break;
     class Continue;
@@ -72,6 +73,8 @@ public:
 
     virtual void visit(ast::Call &node) = 0;
 
+    virtual void visit(ast::CallStatement &node) = 0;
+
     virtual void visit(ast::Statements &node) = 0;
 
     virtual void visit(ast::Break &node) = 0;